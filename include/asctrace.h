@@ -0,0 +1,57 @@
+#ifndef ASCTRACE_H
+#define ASCTRACE_H
+
+#include "tracefile.h"
+
+// Текстовый формат Vector ASC:
+//   date Wed Jun 16 10:22:10.123 am 2021
+//   base hex  timestamps absolute
+//   Begin Triggerblock Wed Jun 16 10:22:10.123 am 2021
+//      0.001234 1  123             Rx   d 8 01 02 03 04 05 06 07 08
+//      0.002000 1  18DAF110x       Tx   d 2 02 11
+//      0.003000 1  ErrorFrame
+//   End TriggerBlock
+// Время строк - секунды от начала измерения (строка date) или, при
+// "timestamps relative", от предыдущей строки. Без строки date отсчет идет
+// от эпохи. Строки CANFD и прочие события (статистика, J1939, системные
+// переменные) пропускаются.
+class AscReader : public TraceReader
+{
+public:
+    bool open(const QString &path) override;
+    int read(CanFrame *frames, int maxCount) override;
+    void close() override;
+    qint64 position() const override { return m_input.position(); }
+    qint64 size() const override { return m_input.size(); }
+
+private:
+    // 1 - кадр, 0 - не кадр, -1 - поврежденная строка кадра
+    int parseEvent(const char *p, const char *end, CanFrame &frame);
+    void parseHeader(const char *p, const char *end);
+    
+    TraceLineInput m_input;
+    qint64 m_startNs = 0;         // Начало измерения, нс от эпохи
+    qint64 m_previousNs = 0;      // Для относительных меток
+    int m_base = 16;
+    bool m_relativeTimestamps = false;
+};
+
+class AscWriter : public TraceWriter
+{
+public:
+    ~AscWriter() override;
+    
+    bool open(const QString &path) override;
+    bool write(const CanFrame *frames, int count) override;
+    bool close() override;
+
+private:
+    // Заголовок пишется по первому кадру: его время - начало измерения
+    void writeHeader(qint64 startNs);
+    
+    TraceOutput m_output;
+    qint64 m_startNs = 0;
+    bool m_headerWritten = false;
+};
+
+#endif // ASCTRACE_H
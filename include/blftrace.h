@@ -0,0 +1,93 @@
+#ifndef BLFTRACE_H
+#define BLFTRACE_H
+
+#include "tracefile.h"
+
+// Двоичный формат Vector BLF. Файл: заголовок LOGG (144 байта), затем
+// объекты LOBJ. Кадры хранятся объектами CAN_MESSAGE внутри контейнеров
+// LOG_CONTAINER, сжатых zlib; объект может продолжаться в следующем
+// контейнере. Время объекта - от начала измерения из заголовка файла
+// (SYSTEMTIME, местное время), в наносекундах или по 10 мкс.
+namespace Blf {
+    constexpr int FILE_HEADER_SIZE = 144;
+    constexpr int OBJECT_HEADER_BASE_SIZE = 16;   // LOBJ, размер заголовка, версия, размер, тип
+    constexpr int OBJECT_HEADER_V1_SIZE = 16;     // Флаги, клиент, версия объекта, время
+    constexpr int CONTAINER_HEADER_SIZE = 16;     // Сжатие, размер без сжатия
+    // Предел размера объекта и распакованного контейнера. Реальные объекты -
+    // десятки байт, контейнеры - около 128 КБ; больше - поврежденный файл.
+    constexpr quint32 MAX_OBJECT_SIZE = 16 * 1024 * 1024;
+    
+    constexpr quint32 CAN_MESSAGE = 1;
+    constexpr quint32 CAN_ERROR = 2;
+    constexpr quint32 LOG_CONTAINER = 10;
+    constexpr quint32 CAN_ERROR_EXT = 73;
+    constexpr quint32 CAN_MESSAGE2 = 86;
+    constexpr quint32 CAN_FD_MESSAGE = 100;
+    constexpr quint32 CAN_FD_MESSAGE_64 = 101;
+    
+    constexpr quint32 TIME_TEN_MICS = 1;
+    constexpr quint32 TIME_ONE_NANS = 2;
+    
+    constexpr quint16 NO_COMPRESSION = 0;
+    constexpr quint16 ZLIB_DEFLATE = 2;
+    
+    constexpr quint8 CAN_MSG_DIR_TX = 0x01;
+    constexpr quint8 CAN_MSG_RTR = 0x80;
+    constexpr quint32 CAN_MSG_EXT = 0x80000000;
+}
+
+class BlfReader : public TraceReader
+{
+public:
+    bool open(const QString &path) override;
+    int read(CanFrame *frames, int maxCount) override;
+    void close() override;
+    qint64 position() const override { return m_file.pos(); }
+    qint64 size() const override { return m_file.size(); }
+
+private:
+    // Следующий объект верхнего уровня в m_stream; false - конец файла или ошибка
+    bool loadNextObject();
+    // 1 - кадр, 0 - объект другого типа
+    int parseObject(const char *object, quint32 type, CanFrame &frame);
+    
+    QFile m_file;
+    QByteArray m_stream;          // Распакованные объекты, еще не разобранные
+    int m_streamPos = 0;
+    QByteArray m_compressed;      // Содержимое контейнера с 4 байтами под размер для qUncompress
+    qint64 m_startNs = 0;         // Начало измерения, нс от эпохи
+    bool m_failed = false;
+};
+
+class BlfWriter : public TraceWriter
+{
+public:
+    ~BlfWriter() override;
+    
+    // 0 - контейнеры без сжатия, 1-9 - уровень zlib. По умолчанию 1: сжатие
+    // втрое-вчетверо при скорости, близкой к записи на диск.
+    void setCompressionLevel(int level) { m_compressionLevel = qBound(0, level, 9); }
+    
+    bool open(const QString &path) override;
+    bool write(const CanFrame *frames, int count) override;
+    bool close() override;
+    
+    static constexpr int DEFAULT_COMPRESSION_LEVEL = 1;
+    static constexpr int MAX_CONTAINER_BYTES = 128 * 1024;
+
+private:
+    void appendObject(const CanFrame &frame);
+    bool flushContainer();
+    QByteArray fileHeader() const;
+    
+    TraceOutput m_output;
+    QByteArray m_container;
+    int m_compressionLevel = DEFAULT_COMPRESSION_LEVEL;
+    qint64 m_startNs = 0;
+    qint64 m_lastNs = 0;
+    quint64 m_uncompressedSize = 0;
+    quint32 m_objectCount = 0;
+    bool m_started = false;
+};
+
+#endif // BLFTRACE_H
@@ -0,0 +1,47 @@
+#ifndef CANDUMPTRACE_H
+#define CANDUMPTRACE_H
+
+#include "tracefile.h"
+
+// Журнал candump -l (can-utils):
+//   (1436509053.850870) can0 123#DEADBEEF
+//   (1436509053.850900) can0 18DAF110#0211
+//   (1436509053.851000) can0 123#R
+// Время - секунды от эпохи, 8 цифр ID - 29-битный кадр, бит 0x20000000 в нем -
+// кадр ошибки. Направления в формате нет: необязательные метки R/T в конце
+// строки читаются, но не пишутся, чтобы файл открывался любой версией
+// can-utils. Кадры CAN FD ("##") пропускаются.
+class CandumpReader : public TraceReader
+{
+public:
+    bool open(const QString &path) override;
+    int read(CanFrame *frames, int maxCount) override;
+    void close() override;
+    qint64 position() const override { return m_input.position(); }
+    qint64 size() const override { return m_input.size(); }
+
+private:
+    // 1 - кадр, 0 - строка не кадр (пустая, комментарий), -1 - поврежденный кадр
+    static int parseLine(const char *p, const char *end, CanFrame &frame);
+    
+    TraceLineInput m_input;
+};
+
+class CandumpWriter : public TraceWriter
+{
+public:
+    ~CandumpWriter() override;
+    
+    // Имя интерфейса в каждой строке
+    void setInterfaceName(const QString &name) { m_interfaceName = name.toLatin1(); }
+    
+    bool open(const QString &path) override;
+    bool write(const CanFrame *frames, int count) override;
+    bool close() override;
+
+private:
+    TraceOutput m_output;
+    QByteArray m_interfaceName = "can0";
+};
+
+#endif // CANDUMPTRACE_H
@@ -0,0 +1,72 @@
+#ifndef CANFRAME_H
+#define CANFRAME_H
+
+#include <QtGlobal>
+#include <chrono>
+#include <type_traits>
+
+class QByteArray;
+class QDateTime;
+
+// Кадр CAN фиксированного размера без выделения памяти.
+// Копируется побайтно, хранится в очередях и буферах как есть.
+struct CanFrame {
+    quint64 timestampNs;  // Монотонное время приема/отправки, см. CanClock
+    quint32 id;
+    quint8 flags;
+    quint8 dlc;           // Число байт данных (0-8)
+    quint8 reserved[2];
+    quint8 data[8];
+    
+    static constexpr quint8 FLAG_TX = 0x01;        // Отправленный кадр
+    static constexpr quint8 FLAG_EXTENDED = 0x02;  // 29-битный идентификатор
+    static constexpr quint8 FLAG_RTR = 0x04;       // Удаленный запрос
+    static constexpr quint8 FLAG_ERROR = 0x08;     // Кадр ошибки
+    
+    bool isTx() const { return flags & FLAG_TX; }
+    bool isExtended() const { return flags & FLAG_EXTENDED; }
+    
+    // Длина кадра на шине в битах, включая хвост (ограничитель CRC, ACK, EOF)
+    // и межкадровый интервал. Битстаффинг оценивается как половина худшего
+    // случая для полей SOF..CRC: реальное число зависит от содержимого.
+    // Кадры ошибок - отчеты адаптера, на шине они не занимают времени.
+    int bitLength() const
+    {
+        if (flags & FLAG_ERROR) {
+            return 0;
+        }
+        const int dataBits = (flags & FLAG_RTR) ? 0 : 8 * qMin<int>(dlc, 8);
+        const int stuffedBits = (isExtended() ? 54 : 34) + dataBits;
+        return stuffedBits + (stuffedBits - 1) / 8 + 13;
+    }
+    
+    // Данные как QByteArray (копия, только для отображения и протоколов)
+    QByteArray payload() const;
+    
+    static CanFrame make(quint32 id, const QByteArray &data, quint64 timestampNs, quint8 flags = 0);
+};
+
+static_assert(sizeof(CanFrame) == 24, "CanFrame должен занимать 24 байта");
+static_assert(std::is_trivially_copyable<CanFrame>::value, "CanFrame должен копироваться побайтно");
+
+// Метки времени кадров: монотонные наносекунды (CLOCK_MONOTONIC на Linux,
+// QueryPerformanceCounter на Windows). В календарное время переводятся
+// только при отображении и экспорте.
+namespace CanClock {
+    inline quint64 nowNs()
+    {
+        return static_cast<quint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+    
+    qint64 toMSecsSinceEpoch(quint64 timestampNs);
+    QDateTime toDateTime(quint64 timestampNs);
+    
+    // Перевод с точностью до наносекунды для файлов трасс. Привязка та же,
+    // поэтому fromNsSinceEpoch(toNsSinceEpoch(t)) == t; метки из далекого
+    // прошлого переполняют счетчик по модулю 2^64 и обратимы так же.
+    qint64 toNsSinceEpoch(quint64 timestampNs);
+    quint64 fromNsSinceEpoch(qint64 nsSinceEpoch);
+}
+
+#endif // CANFRAME_H
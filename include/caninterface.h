@@ -2,32 +2,42 @@
 #define CANINTERFACE_H
 
 #include <QObject>
-#include <QSerialPort>
 #include <QSerialPortInfo>
 #include <QTimer>
 #include <QByteArray>
 #include <QMap>
 #include <QDateTime>
+#include <QThread>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QVector>
+#include <QElapsedTimer>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "cantransport.h"
+#include "transmitqueue.h"
+#include "filterengine.h"
+#include "filterexpression.h"
+#include "idstatistics.h"
+#include "rateestimator.h"
+#include "framerecorder.h"
 
-class USBDevice;
-
-struct CANMessage {
-    quint32 id;
-    QByteArray data;
-    QDateTime timestamp;
-    bool isReceived;
-};
+class SerialTransport;
+class UsbTransport;
+class SocketCanTransport;
+class FrameConsumer;
+class UsbBackend;
 
 struct Statistics {
     quint64 messagesSent;
     quint64 messagesReceived;
     quint64 errorsCount;
-    QDateTime firstMessageTime;
-    QDateTime lastMessageTime;
-    QMap<quint32, quint64> messagesPerId;
+    quint64 firstMessageTimeNs; // CanClock, 0 - сообщений не было
+    quint64 lastMessageTimeNs;
 };
 
-class CANInterface : public QObject
+class CANInterface : public QObject, private CanFrameSink
 {
     Q_OBJECT
 
@@ -37,73 +47,215 @@ public:
     
     bool connect(const QString &portName, int baudRateKbps);
     bool connectUSB(quint16 vendorId = 0x20A2, quint16 productId = 0x0001, int baudRateKbps = 250);
+    // SocketCAN (только Linux). Скорость шины задается при настройке интерфейса (ip link).
+    bool connectSocketCan(const QString &interfaceName);
     void disconnect();
     bool isConnected() const;
-    bool sendMessage(quint32 canId, const QByteArray &data);
+    // Постановка кадра в очередь передачи, без ожидания записи.
+    // false - адаптер не подключен, кадр неверен или очередь класса заполнена.
+    // callback вызывается в потоке сбора после записи пачки в устройство.
+    bool sendMessage(quint32 canId, const QByteArray &data,
+                     TransmitPriority priority = TransmitPriority::Normal,
+                     const TransmitCallbackPtr &callback = TransmitCallbackPtr());
+    
+    // Постановка пачки готовых кадров (генераторы, циклическая передача).
+    // Возвращает число принятых в очередь кадров. Сигнал errorOccurred не
+    // испускается: вызывающий учитывает отказы сам. callback вызывается для
+    // каждого принятого кадра после его записи, как у sendMessage.
+    int sendFrames(const CanFrame *frames, int count, TransmitPriority priority = TransmitPriority::Bulk,
+                   const TransmitCallbackPtr &callback = TransmitCallbackPtr());
+    
+    // Ограничение частоты передачи кадров с данным ID (0 - снять).
+    // Лишние кадры не отбрасываются, а ждут в очереди.
+    void setTransmitRateLimit(quint32 canId, int framesPerSecond);
+    void clearTransmitRateLimits();
     QStringList getAvailablePorts() const;
     void refreshPortList();
     
-    // Фильтрация
+    // Фильтрация. Правило для конкретного ID важнее масок и диапазонов,
+    // из них действует первое совпавшее; кадры без правила пропускаются.
     void setFilterEnabled(bool enabled);
     void addFilterId(quint32 id, bool allow);
+    void addFilterMask(quint32 code, quint32 mask, bool allow);
+    void addFilterRange(quint32 firstId, quint32 lastId, bool allow);
+    void addFilterRule(const FilterRule &rule);
     void clearFilters();
     bool isMessageFiltered(quint32 id) const;
+    QVector<FilterRule> filterRules() const;
+    // Фильтр по содержимому кадра (см. FilterExpression), действует вместе
+    // с правилами по ID при включенной фильтрации. Пустая строка - без фильтра.
+    // false - ошибка разбора, текст ошибки в error, прежнее выражение остается.
+    bool setFilterExpression(const QString &expression, QString *error = nullptr);
+    QString filterExpression() const;
+    // Совпадения по правилам в порядке filterRules() с момента добавления правила.
+    // Кадры, отброшенные фильтрами устройства или ядра, не учитываются.
+    QVector<quint64> filterRuleHits() const;
     
-    // Статистика
+    // Статистика. Значения - снимок на момент последней публикации
+    // (сигнал statisticsUpdated()), счетчики на пути кадров не блокируются.
     Statistics getStatistics() const;
     void resetStatistics();
+    // Кадров в секунду (прием и передача) за последнюю секунду
     quint64 getMessagesPerSecond() const;
+    // Загрузка шины в процентах за последнюю секунду с оценкой битстаффинга.
+    // 0, если скорость шины неизвестна (SocketCAN).
+    double getBusLoad() const;
+    // Счетчики, скорость и загрузка по ID (прием и передача отдельно) на
+    // момент последнего обновления статистики. Копия дешевая.
+    QVector<IdStatistics> idStatistics() const;
+    // Текущие счетчики и последний кадр по ID прямо из таблицы, без скоростей.
+    // O(число ID), не зависит от частоты кадров; буфер переиспользуется.
+    void latestIdStatistics(QVector<IdStatistics> &result) const;
+    TransmitStatistics getTransmitStatistics() const;
+    // Период публикации статистики, мс. Сигнал statisticsUpdated() испускается
+    // не чаще и только при изменениях.
+    void setStatisticsInterval(int milliseconds);
+    int statisticsInterval() const;
+    
+    // Запись принятых (после фильтров по ID и выражению) и отправленных кадров
+    // в файлы .canrec в фоновом потоке (см. FrameRecorder). Не зависит от
+    // подключения; скорость шины для заголовка берется из текущего
+    // подключения, если не задана. stopRecording() не ждет диск: окончание
+    // записи сообщает recordingFinished().
+    bool startRecording(const FrameRecorder::Config &config);
+    void stopRecording();
+    bool isRecording() const;
+    bool isRecordingFinishing() const;
+    FrameRecorder::Statistics recordingStatistics() const;
     
     // Настройки
     void setReadTimeout(int milliseconds);
     void setWriteTimeout(int milliseconds);
     void setMaxBufferSize(int size);
+    void setUSBReceiveBuffers(int transferCount, int transferSize);
+    // Замена устройства за connectUSB() (по умолчанию libusb), например
+    // UsbLoopbackBackend для проверок без адаптера. USB подключение закрывается.
+    void setUSBBackend(std::unique_ptr<UsbBackend> backend);
+    
+    // Режим сбора: чтение, парсинг и метки времени в отдельном потоке.
+    // Переключение возможно только без подключения.
+    void setAcquisitionThreadEnabled(bool enabled);
+    bool isAcquisitionThreadEnabled() const;
+    
+    // Потребители принятых кадров. У каждого своя ограниченная очередь
+    // и свой счетчик переполнений. Владелец - CANInterface.
+    FrameConsumer *createConsumer(const QString &name, int capacity = DEFAULT_CONSUMER_CAPACITY);
+    void removeConsumer(FrameConsumer *consumer);
+    
+    // Интервал сигнала framesReceived(): 0 - на каждое чтение,
+    // иначе кадры копятся и отдаются не чаще одного раза за интервал
+    void setBatchInterval(int milliseconds);
+    int batchInterval() const { return m_batchInterval; }
+    
+    static constexpr int DEFAULT_CONSUMER_CAPACITY = 65536;
+    static constexpr int MAX_TX_BATCH = 256;      // Кадров в одной записи в устройство
+    static constexpr int TX_RETRY_INTERVAL = 1;   // мс, повтор при занятом транспорте
+    static constexpr int DEFAULT_STATISTICS_INTERVAL = 200; // мс, 5 Гц
+    
+    // Префикс интерфейсов SocketCAN в списке getAvailablePorts()
+    static constexpr const char *SOCKETCAN_PORT_PREFIX = "SocketCAN: ";
+    
+    // Порт симулятора адаптера (tools/scanmatic_simulator), показывается, если существует
+    static constexpr const char *SIMULATOR_PORT = "/tmp/ttyScanmaticSim";
 
 signals:
+    // Пачка принятых кадров. QVector разделяемый: при доставке в другой
+    // поток копируется только ссылка на общий блок.
+    void framesReceived(const QVector<CanFrame> &frames);
+    
+    // Сигналы на каждый кадр. Строка форматируется и сигнал
+    // испускается только при наличии подключенных получателей.
     void messageReceived(const QString &message);
-    void messageReceivedDetailed(quint32 id, const QByteArray &data, const QDateTime &timestamp);
+    void messageReceivedDetailed(const CanFrame &frame);
     void connectionStatusChanged(bool connected);
     void errorOccurred(const QString &error);
     void statisticsUpdated();
+    void recordingFinished();
 
 private slots:
-    void onDataReceived();
-    void onSerialError(QSerialPort::SerialPortError error);
-    void onUSBDataReceived(const QByteArray &data);
     void updateStatistics();
 
 private:
-    void parseReceivedData(QByteArray &data);
-    QByteArray buildCanFrame(quint32 canId, const QByteArray &data);
-    QString formatCanMessage(quint32 canId, const QByteArray &data);
-    bool validateFrame(const QByteArray &frame) const;
-    
-    QSerialPort *m_serialPort;
-    USBDevice *m_usbDevice;
-    QByteArray m_buffer;
-    bool m_connected;
-    bool m_useUSB;
+    // Открытие транспорта в потоке сбора и переключение на него
+    bool activateTransport(ICanTransport *transport, const std::function<bool()> &open);
+    void closeDevice();
+    void scheduleTransmit();
+    void flushTransmitQueue();
+    bool runInAcquisitionThread(const std::function<bool()> &function);
+    void deliverToConsumers(const QVector<CanFrame> &frames);
+    void flushBatch();
+    void countErrors(quint64 count = 1);
+    void countFrames(std::atomic<quint64> &counter, quint64 count, quint64 firstNs, quint64 lastNs);
+    void onFramesReceived(const CanFrame *frames, int count, quint64 lostFrames) override;
+    void publishReceived(quint64 lostFrames);
+    void rebuildFilter();
+    void installFilter(const std::shared_ptr<FilterEngine> &engine,
+                       const std::shared_ptr<const FilterExpression> &expression);
+    void pushDownFilters();
+    QString formatCanMessage(const CanFrame &frame);
+    
+    // Объекты ввода-вывода живут в m_ioContext (в потоке сбора, если он включен)
+    QObject *m_ioContext;
+    QThread m_acquisitionThread;
+    SerialTransport *m_serialTransport;
+    UsbTransport *m_usbTransport;
+    SocketCanTransport *m_socketCanTransport; // nullptr вне Linux
+    QVector<ICanTransport*> m_transports;
+    std::atomic<ICanTransport*> m_transport;  // Активный транспорт, nullptr без подключения
+    QVector<CanFrame> m_received; // Кадры текущей пачки, память переиспользуется
+    
+    // Очередь передачи: кадры пишутся в устройство пачками из потока сбора
+    TransmitQueue m_txQueue;
+    QVector<TransmitRequest> m_txBatch;
+    QVector<CanFrame> m_txFrames;
+    QTimer *m_txRetryTimer;
+    std::atomic<bool> m_txFlushPending;
+    
+    // Накопление кадров для framesReceived()
+    QVector<CanFrame> m_batch;
+    QTimer *m_batchTimer;
+    QElapsedTimer m_batchClock;
+    std::atomic<int> m_batchInterval;
+    std::atomic<bool> m_connected;
     int m_currentBaudRate;
     
     // Таймауты
     int m_readTimeout;
     int m_writeTimeout;
-    int m_maxBufferSize;
     
     // Фильтрация
     bool m_filterEnabled;
-    QMap<quint32, bool> m_filterIds; // true = разрешить, false = запретить
+    QVector<FilterRule> m_filterRules;
+    mutable QReadWriteLock m_filterLock;
+    // Действующий набор (nullptr - фильтр выключен). Меняется в потоке сбора,
+    // читается для счетчиков из любого потока через std::atomic_load.
+    std::shared_ptr<FilterEngine> m_filterEngine;
+    std::shared_ptr<const FilterExpression> m_filterExpression;   // Заданное выражение
+    std::shared_ptr<const FilterExpression> m_activeExpression;   // Действующее, только поток сбора
+    
+    // Запись кадров, append() вызывается из потока сбора
+    FrameRecorder *m_recorder;
     
-    // Статистика
+    // Потребители кадров
+    QVector<FrameConsumer*> m_consumers;
+    QMutex m_consumersMutex;
+    
+    // Статистика: счетчики обновляются на пачку без блокировки, снимок
+    // для чтения собирается таймером публикации под m_statsMutex
+    std::atomic<quint64> m_sentCount;
+    std::atomic<quint64> m_receivedCount;
+    std::atomic<quint64> m_errorCount;
+    std::atomic<quint64> m_firstMessageNs;
+    std::atomic<quint64> m_lastMessageNs;
+    mutable QMutex m_statsMutex;
     Statistics m_stats;
+    IdStatisticsTable m_idStats;          // Пишет только поток сбора
+    QVector<IdStatistics> m_idSnapshot;   // Под m_statsMutex
     QTimer *m_statsTimer;
-    quint64 m_lastSecondMessages;
-    QDateTime m_lastSecondTime;
-    
-    // Протокол Scanmatic 2 Pro
-    static constexpr quint8 FRAME_START = 0xAA;
-    static constexpr quint8 FRAME_END = 0x55;
-    static constexpr int MAX_BUFFER_SIZE = 4096; // Защита от переполнения
+    RateEstimator m_rateEstimator;        // Только поток таймера статистики
+    std::atomic<bool> m_rateResetPending;
+    double m_messagesPerSecond;           // Под m_statsMutex
+    double m_busLoad;
 };
 
 #endif // CANINTERFACE_H
@@ -0,0 +1,76 @@
+#ifndef CANTRANSPORT_H
+#define CANTRANSPORT_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include "canframe.h"
+
+class FilterEngine;
+struct AcceptanceFilters;
+
+// Получатель принятых кадров. Вызывается в потоке транспорта один раз
+// на пачку, кадры уже декодированы и имеют метки времени. lostFrames -
+// кадры, потерянные с прошлой пачки: поврежденные в потоке адаптера или
+// отброшенные ядром при переполнении очереди сокета; учитываются как ошибки.
+class CanFrameSink
+{
+public:
+    virtual ~CanFrameSink() = default;
+    virtual void onFramesReceived(const CanFrame *frames, int count, quint64 lostFrames) = 0;
+};
+
+// Транспорт до шины CAN: последовательный порт Scanmatic, libusb, SocketCAN.
+// Открытие у каждого транспорта свое (порт, VID/PID, имя интерфейса),
+// прием, передача и закрытие - общие. Декодирование выполняется внутри
+// транспорта без виртуальных вызовов на кадр; получатель вызывается на пачку.
+class ICanTransport : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ICanTransport(QObject *parent = nullptr)
+        : QObject(parent)
+        , m_sink(nullptr)
+        , m_filter(nullptr)
+    {
+    }
+    
+    virtual QString name() const = 0;
+    virtual bool isOpen() const = 0;
+    virtual void close() = 0;
+    
+    // Передача пачки кадров. Возвращает число принятых к отправке кадров
+    // (меньше count, в том числе 0 - транспорт занят, остаток повторяется позже)
+    // или -1 при ошибке устройства.
+    virtual int writeBatch(const CanFrame *frames, int count) = 0;
+    virtual QString errorString() const = 0;
+    
+    // Фильтры приема на стороне устройства или ядра (код/маска по ID).
+    // 0 - транспорт их не поддерживает, фильтрация остается в приложении.
+    virtual int maxAcceptanceFilters() const { return 0; }
+    
+    // false - фильтры не установлены, устройство передает все кадры
+    virtual bool setAcceptanceFilters(const AcceptanceFilters &filters)
+    {
+        Q_UNUSED(filters);
+        return false;
+    }
+    
+    void setSink(CanFrameSink *sink) { m_sink = sink; }
+    
+    // Фильтр по ID, проверяется при декодировании до копирования данных кадра.
+    // nullptr - прием всех кадров. Устанавливается в потоке транспорта.
+    void setFilter(FilterEngine *filter) { m_filter = filter; }
+
+signals:
+    void errorOccurred(const QString &error);
+    // Устройство пропало (отключено), соединение нужно закрыть
+    void deviceLost();
+
+protected:
+    CanFrameSink *m_sink;
+    FilterEngine *m_filter;
+};
+
+#endif // CANTRANSPORT_H
@@ -0,0 +1,36 @@
+#ifndef CAPTURETABLEMODEL_H
+#define CAPTURETABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QVector>
+#include "mappedcapture.h"
+
+// Таблица кадров файла записи с теми же колонками и оформлением, что у
+// MessageTableModel. Кадры читаются из отображения файла только для
+// видимых строк; выборка хранит лишь номера кадров, а без фильтра строки
+// совпадают с кадрами файла и список не нужен.
+class CaptureTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit CaptureTableModel(QObject *parent = nullptr);
+    
+    // Файл не принадлежит модели; перед его закрытием вызывается setCapture(nullptr)
+    void setCapture(const MappedCapture *capture);
+    void setSelection(const CaptureSelection &selection);
+    
+    CanFrame frameAt(int row) const;
+    
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    const MappedCapture *m_capture;
+    bool m_allFrames;             // Без фильтра: строка = номер кадра
+    QVector<quint32> m_rows;      // Номера кадров выборки
+};
+
+#endif // CAPTURETABLEMODEL_H
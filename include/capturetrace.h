@@ -0,0 +1,37 @@
+#ifndef CAPTURETRACE_H
+#define CAPTURETRACE_H
+
+#include "tracefile.h"
+#include "framerecorder.h"
+
+// Файл записи .canrec (см. CaptureFileHeader): кадры читаются и пишутся
+// блоками прямо в массив CanFrame
+class CaptureReader : public TraceReader
+{
+public:
+    bool open(const QString &path) override;
+    int read(CanFrame *frames, int maxCount) override;
+    void close() override;
+    qint64 position() const override { return m_file.pos(); }
+    qint64 size() const override { return m_file.size(); }
+
+private:
+    QFile m_file;
+    CaptureFileHeader m_header = {};
+    QByteArray m_records;         // Для файлов с записями другого размера
+};
+
+class CaptureWriter : public TraceWriter
+{
+public:
+    ~CaptureWriter() override;
+    
+    bool open(const QString &path) override;
+    bool write(const CanFrame *frames, int count) override;
+    bool close() override;
+
+private:
+    TraceOutput m_output;
+};
+
+#endif // CAPTURETRACE_H
@@ -0,0 +1,125 @@
+#ifndef CYCLICTRANSMITTER_H
+#define CYCLICTRANSMITTER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "canframe.h"
+#include "transmitqueue.h"
+
+class QThread;
+class CANInterface;
+
+// Статистика одного периодического сообщения
+struct CyclicStatistics {
+    int handle;
+    quint32 id;
+    int periodUs;
+    quint64 sent;          // Записано в устройство
+    quint64 failed;        // Отказ очереди, нет подключения или ошибка записи
+    quint64 missedCycles;  // Пропущенные периоды (поток расписания не успел)
+    // Опоздание записи в устройство относительно расписания: ожидание потока
+    // расписания, очереди передачи и потока сбора вместе
+    quint64 averageJitterUs;
+    quint64 maxJitterUs;
+};
+
+// Периодическая передача кадров (имитация ЭБУ): десятки сообщений с периодами
+// 10/20/100 мс и фазовыми сдвигами. Расписание - хешированное колесо таймеров
+// с шагом TICK_NS в отдельном потоке; ожидание по абсолютному времени
+// (clock_nanosleep на Linux). Период и фаза округляются до шага колеса.
+// Кадры ставятся в очередь передачи CANInterface с приоритетом Periodic
+// (раньше генераторов Bulk), запись в устройство объединяется потоком сбора.
+class CyclicTransmitter : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Изменение кадра перед каждой отправкой: счетчики, контрольные суммы.
+    // Вызывается в потоке расписания; sendCount - номер отправки с нуля.
+    using PayloadHook = std::function<void(CanFrame &frame, quint64 sendCount)>;
+    
+    explicit CyclicTransmitter(CANInterface *canInterface, QObject *parent = nullptr);
+    ~CyclicTransmitter();
+    
+    // Возвращает идентификатор сообщения или -1 при неверных параметрах.
+    // Период не меньше TICK_NS; фаза отсчитывается от запуска расписания.
+    int addMessage(quint32 canId, const QByteArray &data, int periodUs, int phaseUs = 0);
+    void removeMessage(int handle);
+    void clear();
+    
+    void setPayload(int handle, const QByteArray &data);
+    void addHook(int handle, const PayloadHook &hook);
+    
+    void start();
+    void stop();
+    bool isRunning() const { return m_running; }
+    
+    QVector<CyclicStatistics> statistics() const;
+    void resetStatistics();
+    
+    // Готовые изменения кадра
+    // Счетчик в младших битах байта по маске (например 0x0F - 4-битный счетчик)
+    static PayloadHook counterHook(int byteIndex, quint8 mask = 0xFF);
+    // Сумма байтов кадра (кроме byteIndex) по модулю 256 или XOR
+    static PayloadHook checksumHook(int byteIndex, bool useXor = false);
+    
+    static constexpr quint64 TICK_NS = 100000;       // 100 мкс - шаг колеса
+    static constexpr int WHEEL_SIZE = 1024;          // Один оборот - 102.4 мс
+    static constexpr quint64 MAX_SLEEP_NS = 1000000; // Проверка новых сообщений и остановки
+    static constexpr quint64 ADD_LEAD_NS = 2000000;  // Первая отправка нового сообщения не раньше
+
+private:
+    // Итоги записи кадров сообщения. Обновляются из потока сбора (callback
+    // очереди передачи); кадр может быть записан и после удаления сообщения.
+    struct WriteStats {
+        std::atomic<quint64> sent{0};
+        std::atomic<quint64> failed{0};
+        std::atomic<quint64> lateTotalNs{0};
+        std::atomic<quint64> lateMaxNs{0};
+        
+        void reset();
+    };
+    
+    struct Message {
+        CanFrame frame;
+        QVector<PayloadHook> hooks;
+        quint64 periodNs;
+        quint64 phaseNs;
+        quint64 deadlineNs;
+        quint64 sendCount;
+        quint64 missedCycles;
+        std::shared_ptr<WriteStats> writeStats;
+        TransmitCallbackPtr onWritten;  // Общий для всех кадров сообщения
+    };
+    
+    void run();
+    void schedule(int handle, Message &message);
+    quint64 firstDeadline(const Message &message, quint64 nowNs) const;
+    quint64 nextWakeNs(quint64 nowNs) const;
+    void processTick(quint64 tick, quint64 nowNs);
+    void fire(Message &message, quint64 nowNs);
+    static TransmitCallbackPtr makeWriteCallback(const std::shared_ptr<WriteStats> &stats);
+    static void sleepUntil(quint64 deadlineNs);
+    
+    CANInterface *m_canInterface;
+    QThread *m_thread;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_stopping;
+    
+    mutable QMutex m_mutex;
+    QHash<int, Message> m_messages;
+    std::vector<int> m_wheel[WHEEL_SIZE]; // Идентификаторы сообщений по слотам
+    std::vector<int> m_slotBuffer;
+    quint64 m_startNs;
+    quint64 m_currentTick;                // Следующий необработанный шаг
+    int m_nextHandle;
+};
+
+#endif // CYCLICTRANSMITTER_H
@@ -4,10 +4,12 @@
 #include <QObject>
 #include <QByteArray>
 #include <QString>
-#include <QDateTime>
 #include <QTimer>
+#include <QPointer>
+#include "canframe.h"
 
 class CANInterface;
+class FrameConsumer;
 
 // Базовый класс для диагностических протоколов
 class DiagnosticProtocol : public QObject
@@ -16,7 +18,7 @@ class DiagnosticProtocol : public QObject
 
 public:
     explicit DiagnosticProtocol(CANInterface *canInterface, QObject *parent = nullptr);
-    virtual ~DiagnosticProtocol() = default;
+    virtual ~DiagnosticProtocol();
     
     // Общие методы
     virtual QString protocolName() const = 0;
@@ -37,6 +39,7 @@ signals:
 
 protected:
     CANInterface *m_canInterface;
+    QPointer<FrameConsumer> m_consumer;
     quint32 m_requestId;
     quint32 m_responseId;
     int m_timeout;
@@ -50,8 +53,12 @@ protected:
     virtual bool parseResponse(const QByteArray &data, QByteArray &responseData);
     
 private slots:
-    void onCanMessageReceived(quint32 id, const QByteArray &data, const QDateTime &timestamp);
+    void onFramesAvailable();
+    void onCanFrameReceived(const CanFrame &frame);
     void onResponseTimeout();
+
+private:
+    static constexpr int DIAGNOSTIC_QUEUE_CAPACITY = 4096;
 };
 
 #endif // DIAGNOSTICPROTOCOL_H
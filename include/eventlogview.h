@@ -0,0 +1,59 @@
+#ifndef EVENTLOGVIEW_H
+#define EVENTLOGVIEW_H
+
+#include <QPlainTextEdit>
+#include <QTextCharFormat>
+#include <QTime>
+#include <QVector>
+
+// Журнал событий с ограниченным числом строк (maximumBlockCount: старые
+// строки удаляются при добавлении новых). Строки копятся в append() и
+// выводятся одной правкой документа в flush(). Каналы RX/TX/ERROR можно
+// отключать: строки выключенного канала отбрасываются до форматирования.
+class EventLogView : public QPlainTextEdit
+{
+    Q_OBJECT
+
+public:
+    enum Channel {
+        InfoChannel = 0x1,
+        RxChannel = 0x2,
+        TxChannel = 0x4,
+        ErrorChannel = 0x8,
+        AllChannels = 0xF
+    };
+    
+    explicit EventLogView(QWidget *parent = nullptr);
+    
+    void setMaximumLines(int lines);
+    int maximumLines() const { return maximumBlockCount(); }
+    
+    // Влияет только на новые строки
+    void setChannelEnabled(Channel channel, bool enabled);
+    bool isChannelEnabled(Channel channel) const { return m_channels & channel; }
+    
+    // tagColor - цвет метки, по умолчанию цвет канала
+    void append(Channel channel, const QString &tag, const QString &message, const QColor &tagColor = QColor());
+    void flush();
+    int pendingCount() const { return m_pending.size(); }
+    void clearLog();
+    
+    static constexpr int DEFAULT_MAXIMUM_LINES = 5000;
+
+private:
+    struct Line {
+        QTime time;
+        Channel channel;
+        QString tag;
+        QString message;
+        QColor tagColor;
+    };
+    
+    QTextCharFormat tagFormat(const Line &line) const;
+    
+    int m_channels;
+    QVector<Line> m_pending;
+    QTextCharFormat m_textFormat;
+};
+
+#endif // EVENTLOGVIEW_H
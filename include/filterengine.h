@@ -0,0 +1,128 @@
+#ifndef FILTERENGINE_H
+#define FILTERENGINE_H
+
+#include <QtGlobal>
+#include <QHash>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+// Правило фильтрации по CAN ID
+struct FilterRule {
+    enum Kind : quint8 {
+        ExactId,   // first - ID
+        MaskCode,  // first - код, second - маска: (id & маска) == (код & маска)
+        IdRange,   // first..second включительно
+    };
+    
+    Kind kind;
+    quint32 first;
+    quint32 second;
+    bool allow;
+    
+    static FilterRule exact(quint32 id, bool allow) { return {ExactId, id, 0, allow}; }
+    static FilterRule mask(quint32 code, quint32 mask, bool allow) { return {MaskCode, code, mask, allow}; }
+    static FilterRule range(quint32 first, quint32 last, bool allow) { return {IdRange, first, last, allow}; }
+    
+    bool matches(quint32 id) const;
+    bool operator==(const FilterRule &other) const;
+};
+
+// Фильтры приема для устройства или ядра: пары код/маска по значению ID,
+// без различия 11- и 29-битных кадров. Пропускают не меньше кадров, чем
+// набор правил; окончательное решение остается за FilterEngine.
+struct AcceptanceFilters {
+    enum Mode : quint8 {
+        AcceptAll,       // Правила не выражаются фильтрами приема
+        AcceptMatching,  // Кадр проходит, если совпал хотя бы с одной парой
+        RejectMatching,  // Кадр отбрасывается, если совпал хотя бы с одной парой
+    };
+    
+    struct Mask {
+        quint32 code;
+        quint32 mask;
+    };
+    
+    Mode mode = AcceptAll;
+    QVector<Mask> masks;
+};
+
+// Скомпилированный набор правил: решение по ID за O(1).
+// 11-битные ID - битовая карта на 2048 ID и таблица номеров правил,
+// 29-битные - хеш точных ID, затем маски и диапазоны по порядку.
+// Точное правило для ID важнее масок и диапазонов; из остальных действует
+// первое совпавшее. Кадры без совпавшего правила пропускаются.
+//
+// Набор неизменяем после создания. accept() вызывается только из потока
+// сбора (один писатель счетчиков), счетчики читаются из любого потока.
+class FilterEngine
+{
+public:
+    explicit FilterEngine(const QVector<FilterRule> &rules);
+    
+    FilterEngine(const FilterEngine &) = delete;
+    FilterEngine &operator=(const FilterEngine &) = delete;
+    
+    // Решение для принятого кадра с подсчетом совпадений
+    inline bool accept(quint32 id);
+    
+    // Решение без подсчета; ruleIndex - номер совпавшего правила или NO_RULE
+    bool decide(quint32 id, int *ruleIndex = nullptr) const;
+    
+    const QVector<FilterRule> &rules() const { return m_rules; }
+    quint64 hits(int ruleIndex) const { return m_hits[ruleIndex].load(std::memory_order_relaxed); }
+    quint64 unmatchedHits() const { return m_unmatched.load(std::memory_order_relaxed); }
+    
+    // Перенос счетчиков совпадающих правил из предыдущего набора
+    void inheritHits(const FilterEngine &previous);
+    
+    // Перевод правил в фильтры приема, не более maxMasks пар.
+    // Если есть запрет всех ID маской или диапазоном - список разрешенных,
+    // иначе - запреты, которые не перекрыты разрешениями.
+    AcceptanceFilters acceptanceFilters(int maxMasks) const;
+    
+    static constexpr int NO_RULE = -1;
+    static constexpr quint32 STANDARD_ID_COUNT = 2048;
+
+private:
+    int findExtendedRule(quint32 id) const;
+    
+    static void countHit(std::atomic<quint64> &counter)
+    {
+        // Один писатель: без атомарного сложения с блокировкой шины
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    
+    QVector<FilterRule> m_rules;
+    
+    // 11-битные ID: решение и номер правила для каждого ID
+    quint64 m_standardAccept[STANDARD_ID_COUNT / 64];
+    qint32 m_standardRule[STANDARD_ID_COUNT];
+    
+    // 29-битные ID
+    QHash<quint32, int> m_extendedExact;
+    QVector<int> m_extendedRules; // Маски и диапазоны, затрагивающие ID > 0x7FF
+    
+    std::unique_ptr<std::atomic<quint64>[]> m_hits;
+    std::atomic<quint64> m_unmatched;
+};
+
+inline bool FilterEngine::accept(quint32 id)
+{
+    int rule;
+    if (id < STANDARD_ID_COUNT) {
+        rule = m_standardRule[id];
+        countHit(rule != NO_RULE ? m_hits[rule] : m_unmatched);
+        return (m_standardAccept[id >> 6] >> (id & 63)) & 1;
+    }
+    
+    rule = findExtendedRule(id);
+    if (rule == NO_RULE) {
+        countHit(m_unmatched);
+        return true;
+    }
+    countHit(m_hits[rule]);
+    return m_rules[rule].allow;
+}
+
+#endif // FILTERENGINE_H
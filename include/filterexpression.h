@@ -0,0 +1,123 @@
+#ifndef FILTEREXPRESSION_H
+#define FILTEREXPRESSION_H
+
+#include <QString>
+#include <QVector>
+#include "canframe.h"
+
+// Фильтр по содержимому кадра: выражение компилируется в плоский байткод
+// стековой машины и проверяется на каждом кадре без выделения памяти.
+//
+// Синтаксис:
+//   id, dlc, ext            - ID, длина данных, 1 для 29-битного ID
+//   data[N]                 - байт данных N (0-7)
+//   data[N].K               - бит K (0-7) байта N
+//   word[N]                 - байты N, N+1 как big-endian (0-6)
+//   0x7E8, 98               - числа (hex или десятичные)
+//   &                       - побитовое И
+//   == != < <= > >=         - сравнения
+//   ! && || ( )             - логика и группировка
+//
+// Примеры: "id == 0x7E8 && data[1] == 0x62", "data[2].3", "(word[0] & 0xFFF0) != 0x1230"
+//
+// Сравнение с байтом, которого нет в кадре (N >= dlc), ложно.
+// && и || вычисляются без ветвлений: обе части всегда считаются.
+class FilterExpression
+{
+public:
+    FilterExpression();
+    
+    // false - ошибка разбора, см. errorString() и errorPosition()
+    bool compile(const QString &expression);
+    
+    bool isValid() const { return !m_code.isEmpty(); }
+    QString expression() const { return m_expression; }
+    QString errorString() const { return m_lastError; }
+    int errorPosition() const { return m_errorPosition; }
+    int instructionCount() const { return m_code.size(); }
+    
+    inline bool matches(const CanFrame &frame) const;
+    
+    enum Opcode : quint8 {
+        PushConst,
+        LoadId,
+        LoadDlc,
+        LoadExtended,
+        LoadByte,
+        LoadWord,
+        // Над двумя значениями стека
+        BitAnd,
+        BitOr,
+        Equal,
+        NotEqual,
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual,
+        // Значение стека с константой из инструкции
+        BitAndConst,
+        EqualConst,
+        NotEqualConst,
+        LessConst,
+        LessEqualConst,
+        GreaterConst,
+        GreaterEqualConst,
+        // Над вершиной стека
+        ToBool,
+        Not,
+        RequireDlc, // Вершина & (dlc > аргумент)
+    };
+    
+    struct Instruction {
+        Opcode op;
+        quint32 arg;
+    };
+    
+    static constexpr int MAX_STACK = 16;
+
+private:
+    QVector<Instruction> m_code;
+    QString m_expression;
+    QString m_lastError;
+    int m_errorPosition;
+};
+
+inline bool FilterExpression::matches(const CanFrame &frame) const
+{
+    quint32 stack[MAX_STACK];
+    int top = -1;
+    
+    for (const Instruction &instruction : m_code) {
+        const quint32 arg = instruction.arg;
+        switch (instruction.op) {
+            case PushConst:         stack[++top] = arg; break;
+            case LoadId:            stack[++top] = frame.id; break;
+            case LoadDlc:           stack[++top] = frame.dlc; break;
+            case LoadExtended:      stack[++top] = frame.isExtended(); break;
+            case LoadByte:          stack[++top] = frame.data[arg]; break;
+            case LoadWord:          stack[++top] = (quint32(frame.data[arg]) << 8) | frame.data[arg + 1]; break;
+            case BitAnd:            --top; stack[top] &= stack[top + 1]; break;
+            case BitOr:             --top; stack[top] |= stack[top + 1]; break;
+            case Equal:             --top; stack[top] = stack[top] == stack[top + 1]; break;
+            case NotEqual:          --top; stack[top] = stack[top] != stack[top + 1]; break;
+            case Less:              --top; stack[top] = stack[top] < stack[top + 1]; break;
+            case LessEqual:         --top; stack[top] = stack[top] <= stack[top + 1]; break;
+            case Greater:           --top; stack[top] = stack[top] > stack[top + 1]; break;
+            case GreaterEqual:      --top; stack[top] = stack[top] >= stack[top + 1]; break;
+            case BitAndConst:       stack[top] &= arg; break;
+            case EqualConst:        stack[top] = stack[top] == arg; break;
+            case NotEqualConst:     stack[top] = stack[top] != arg; break;
+            case LessConst:         stack[top] = stack[top] < arg; break;
+            case LessEqualConst:    stack[top] = stack[top] <= arg; break;
+            case GreaterConst:      stack[top] = stack[top] > arg; break;
+            case GreaterEqualConst: stack[top] = stack[top] >= arg; break;
+            case ToBool:            stack[top] = stack[top] != 0; break;
+            case Not:               stack[top] = stack[top] == 0; break;
+            case RequireDlc:        stack[top] &= quint32(frame.dlc > arg); break;
+        }
+    }
+    
+    return top >= 0 && stack[top] != 0;
+}
+
+#endif // FILTEREXPRESSION_H
@@ -0,0 +1,47 @@
+#ifndef FRAMECONSUMER_H
+#define FRAMECONSUMER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include "canframe.h"
+#include "spscring.h"
+
+// Потребитель принятых кадров: собственная очередь SPSC между потоком сбора
+// и потоком потребителя (GUI, диагностика). Если потребитель не успевает,
+// новые кадры для него отбрасываются и учитываются в overflowCount().
+class FrameConsumer : public QObject
+{
+    Q_OBJECT
+
+public:
+    FrameConsumer(const QString &name, int capacity, QObject *parent = nullptr);
+    
+    QString name() const { return m_name; }
+    int capacity() const { return m_ring.capacity(); }
+    int pending() const { return m_ring.size(); }
+    
+    // Сторона производителя (поток сбора)
+    bool push(const CanFrame &frame);
+    void notify();
+    
+    // Сторона потребителя
+    bool pop(CanFrame &frame);
+    int drain(QVector<CanFrame> &frames, int maxCount = -1);
+    
+    quint64 overflowCount() const { return m_overflows.load(std::memory_order_relaxed); }
+    void resetOverflowCount() { m_overflows.store(0, std::memory_order_relaxed); }
+
+signals:
+    // Не чаще одного раза на пачку кадров, пока потребитель не начал чтение
+    void framesAvailable();
+
+private:
+    QString m_name;
+    SpscRing<CanFrame> m_ring;
+    std::atomic<quint64> m_overflows;
+    std::atomic<bool> m_notifyPending;
+};
+
+#endif // FRAMECONSUMER_H
@@ -0,0 +1,138 @@
+#ifndef FRAMERECORDER_H
+#define FRAMERECORDER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QFile>
+#include <atomic>
+#include "canframe.h"
+
+class QThread;
+
+// Файл записи (.canrec): заголовок CaptureFileHeader, затем записи CanFrame
+// по 24 байта как есть (порядок байтов платформы, little-endian).
+// Метки времени кадров - CanClock, перевод в календарное время по паре
+// wallClockMs/monotonicNs из заголовка.
+struct CaptureFileHeader {
+    char magic[8];          // CAPTURE_MAGIC
+    quint32 version;
+    quint32 headerSize;     // sizeof(CaptureFileHeader)
+    quint32 recordSize;     // sizeof(CanFrame)
+    quint32 bitrateKbps;    // 0 - неизвестна
+    qint64 wallClockMs;     // Календарное время, соответствующее monotonicNs
+    quint64 monotonicNs;    // CanClock при создании файла
+    quint32 sequence;       // Номер файла в серии ротации, с 0
+    quint8 reserved[20];
+    
+    static constexpr char CAPTURE_MAGIC[8] = {'C', 'A', 'N', 'R', 'E', 'C', '0', '1'};
+    static constexpr quint32 CAPTURE_VERSION = 1;
+};
+
+static_assert(sizeof(CaptureFileHeader) == 64, "Заголовок файла записи должен занимать 64 байта");
+
+// Непрерывная запись принятых и отправленных кадров. Записываются кадры после
+// фильтрации CANInterface (по ID и выражению): отброшенные фильтром кадры в
+// файл не попадают. Поток сбора копирует
+// пачки кадров в активный буфер; заполненные буферы пишет отдельный поток
+// большими небуферизованными записями. Пока один буфер пишется, заполняется
+// другой; если диск отстает, выделяются дополнительные буферы до maxBuffers,
+// и только после этого кадры теряются (framesDropped). Частично заполненный
+// буфер сбрасывается на диск не реже flushIntervalMs.
+class FrameRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Config {
+        QString directory;
+        QString prefix = "capture";
+        qint64 maxFileBytes = 1024LL * 1024 * 1024;  // Ротация по размеру, 0 - без ограничения
+        int maxFileSeconds = 0;                      // Ротация по времени, 0 - без ограничения
+        int bufferBytes = 4 * 1024 * 1024;
+        int maxBuffers = 64;
+        int flushIntervalMs = 1000;
+        int bitrateKbps = 0;                         // Для заголовка файла
+    };
+    
+    struct Statistics {
+        quint64 framesRecorded;  // Записано на диск
+        quint64 bytesWritten;
+        quint64 framesDropped;   // Нет свободного буфера или ошибка записи
+        int filesCreated;
+        int buffersAllocated;
+        QString currentFile;
+    };
+    
+    explicit FrameRecorder(QObject *parent = nullptr);
+    ~FrameRecorder() override;
+    
+    // Открытие первого файла и запуск потока записи. false, если предыдущая
+    // запись еще не завершена (isFinishing) или файл не создан.
+    bool start(const Config &config);
+    // Остановка без ожидания: новые кадры больше не принимаются, поток записи
+    // сбрасывает накопленные буферы и закрывает файл, затем испускается finished()
+    void stop();
+    // Ожидание завершения потока записи (закрытие приложения)
+    void waitForFinished();
+    bool isRecording() const { return m_recording.load(std::memory_order_acquire); }
+    // Запись остановлена, накопленные кадры еще пишутся на диск
+    bool isFinishing() const;
+    QString errorString() const;
+    
+    // Сторона производителя (поток сбора), не ждет диск
+    void append(const CanFrame *frames, int count);
+    
+    Statistics statistics() const;
+    
+    static constexpr const char *FILE_SUFFIX = ".canrec";
+
+signals:
+    void errorOccurred(const QString &error);
+    void fileStarted(const QString &path);
+    // Поток записи завершен, файл закрыт; итоги - statistics()
+    void finished();
+
+private:
+    struct Buffer {
+        QByteArray data;
+        int used;
+    };
+    
+    void runWriter();
+    bool openNextFile();
+    bool writeBuffer(const Buffer &buffer);
+    void fail(const QString &error);
+    Buffer *takeFreeBuffer();
+    
+    Config m_config;              // Меняется в start() под m_mutex
+    QPointer<QThread> m_writerThread; // Удаляется сам по завершении
+    std::atomic<bool> m_recording;
+    bool m_stopping;              // Под m_mutex
+    bool m_failed;                // Под m_mutex
+    
+    // Буферы: активный заполняет поток сбора, полные ждут потока записи
+    mutable QMutex m_mutex;
+    QWaitCondition m_bufferReady;
+    QVector<Buffer*> m_buffers;   // Все выделенные, владелец
+    QVector<Buffer*> m_free;
+    QVector<Buffer*> m_full;
+    Buffer *m_active;
+    
+    // Только поток записи
+    QFile m_file;
+    quint32 m_sequence;
+    quint64 m_fileStartNs;
+    
+    QString m_lastError;          // Под m_mutex
+    QString m_currentFile;        // Под m_mutex
+    quint64 m_framesRecorded;     // Под m_mutex
+    quint64 m_bytesWritten;
+    quint64 m_framesDropped;
+    int m_filesCreated;
+};
+
+#endif // FRAMERECORDER_H
@@ -0,0 +1,49 @@
+#ifndef IDOVERVIEWMODEL_H
+#define IDOVERVIEWMODEL_H
+
+#include <QAbstractTableModel>
+#include <QVector>
+#include "idstatistics.h"
+
+// Обзор по ID ("фиксированная трасса"): одна строка на ID и направление,
+// строки обновляются на месте. Источник - снимок IdStatisticsTable, поэтому
+// обновление стоит O(число ID) независимо от частоты кадров. Строки идут
+// в порядке появления ID, сортировка - через QSortFilterProxyModel.
+class IdOverviewModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        IdColumn,
+        DirectionColumn,
+        CountColumn,
+        DataColumn,
+        ChangesColumn,
+        CycleColumn,
+        JitterColumn,
+        COLUMN_COUNT
+    };
+    
+    explicit IdOverviewModel(QObject *parent = nullptr);
+    
+    // Применение нового снимка: изменившиеся строки обновляются одним
+    // сигналом dataChanged, новые ID добавляются в конец
+    void update(const QVector<IdStatistics> &snapshot);
+    void clear();
+    
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    
+    // Роль для сортировки прокси-моделью: числа вместо текста
+    static constexpr int SortRole = Qt::UserRole;
+
+private:
+    static bool sameRow(const IdStatistics &a, const IdStatistics &b);
+    
+    QVector<IdStatistics> m_rows;
+};
+
+#endif // IDOVERVIEWMODEL_H
@@ -0,0 +1,105 @@
+#ifndef IDSTATISTICS_H
+#define IDSTATISTICS_H
+
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include "canframe.h"
+
+// Снимок счетчиков одного ID в одном направлении (прием или передача)
+struct IdStatistics {
+    quint32 id;
+    bool tx;
+    quint64 frames;
+    quint64 bytes;
+    quint64 bits;             // Время шины, см. CanFrame::bitLength()
+    quint64 firstTimestampNs; // CanClock
+    quint64 lastTimestampNs;
+    quint64 minPeriodNs;      // 0 - меньше двух кадров с разными метками
+    quint64 maxPeriodNs;
+    quint64 dlcHistogram[9];  // Индекс - DLC 0-8
+    double framesPerSecond;   // Заполняет RateEstimator, иначе 0
+    double busLoadPercent;
+    
+    // Последний кадр
+    quint8 data[8];
+    quint8 dlc;
+    quint8 flags;             // CanFrame::FLAG_*
+    quint8 changedMask;       // Бит i - байт i отличается от предыдущего кадра
+    quint64 cyclePeriodNs;    // Сглаженный период, 0 - меньше двух кадров
+    quint64 jitterNs;         // Сглаженное отклонение периода от cyclePeriodNs
+    
+    // Средний период между кадрами, 0 - меньше двух кадров
+    quint64 averagePeriodNs() const
+    {
+        return frames > 1 ? (lastTimestampNs - firstTimestampNs) / (frames - 1) : 0;
+    }
+};
+
+// Счетчики по ID без блокировок: плоский массив записей в порядке появления
+// ID и индекс с открытой адресацией. Пишет один поток (поток сбора), читать
+// снимок можно из любого потока; чтение не мешает записи.
+//
+// Поля записи обновляются по отдельности, поэтому снимок может отставать
+// на кадр между полями одной записи. Записи не удаляются: после reset()
+// они скрываются до следующего кадра своего ID. Если ID больше емкости,
+// кадры новых ID учитываются только в untrackedFrames().
+class IdStatisticsTable
+{
+public:
+    explicit IdStatisticsTable(int capacity = DEFAULT_CAPACITY);
+    ~IdStatisticsTable();
+    
+    IdStatisticsTable(const IdStatisticsTable &) = delete;
+    IdStatisticsTable &operator=(const IdStatisticsTable &) = delete;
+    
+    // Сторона писателя, на каждый кадр
+    void record(const CanFrame &frame);
+    
+    // Обнуление из любого потока
+    void reset();
+    
+    // Полная очистка с освобождением записей. Только из потока писателя.
+    void clear();
+    
+    // Сторона читателя
+    QVector<IdStatistics> snapshot() const;
+    // То же в готовый буфер без выделения памяти при повторных вызовах
+    void snapshot(QVector<IdStatistics> &result) const;
+    int idCount() const { return m_count.load(std::memory_order_acquire); }
+    int capacity() const { return m_capacity; }
+    quint64 untrackedFrames() const { return m_untracked.load(std::memory_order_relaxed); }
+    
+    // Все кадры и биты, включая неучтенные по ID. Не обнуляются reset(),
+    // только clear(), поэтому годятся для расчета скорости по разности.
+    quint64 totalFrames() const { return m_totalFrames.load(std::memory_order_relaxed); }
+    quint64 totalBits() const { return m_totalBits.load(std::memory_order_relaxed); }
+    
+    static constexpr int DEFAULT_CAPACITY = 8192;
+
+private:
+    struct Entry;
+    
+    Entry *find(quint32 key);
+    Entry *insert(quint32 key, int slot);
+    
+    int m_capacity;
+    std::unique_ptr<Entry[]> m_entries;
+    std::atomic<int> m_count;
+    
+    // Индекс ключ -> номер записи, только поток писателя
+    std::unique_ptr<qint32[]> m_index;
+    std::unique_ptr<quint32[]> m_indexKeys;
+    quint32 m_indexMask;
+    
+    // Последняя найденная запись: кадры одного ID часто идут подряд
+    quint32 m_lastKey;
+    Entry *m_lastEntry;
+    
+    std::atomic<quint32> m_epoch;
+    std::atomic<quint64> m_untracked;
+    std::atomic<quint64> m_totalFrames;
+    std::atomic<quint64> m_totalBits;
+};
+
+#endif // IDSTATISTICS_H
@@ -0,0 +1,55 @@
+#ifndef LIBUSBBACKEND_H
+#define LIBUSBBACKEND_H
+
+#include <QVector>
+#include <atomic>
+#include "usbbackend.h"
+
+class QThread;
+
+// Forward declaration для libusb
+struct libusb_device_handle;
+struct libusb_context;
+
+// Адаптер через libusb: асинхронный прием bulk IN в отдельном потоке событий
+class LibusbBackend : public UsbBackend
+{
+public:
+    LibusbBackend();
+    ~LibusbBackend() override;
+    
+    bool open(quint16 vendorId, quint16 productId, int transferCount, int transferSize) override;
+    void close() override;
+    bool isOpen() const override;
+    
+    int write(const QByteArray &data) override;
+    QByteArray read(int timeoutMs) override;
+    QString errorString() const override { return m_lastError; }
+
+private:
+    struct TransferSlot;
+    
+    bool startReceiving(int transferCount, int transferSize);
+    void stopReceiving();
+    void runEventLoop();
+    void reportError(const QString &error);
+    
+    libusb_context *m_context;
+    libusb_device_handle *m_handle;
+    bool m_isOpen;
+    QString m_lastError;
+    
+    // Асинхронный прием
+    QVector<TransferSlot*> m_transfers;
+    QThread *m_eventThread;
+    std::atomic<bool> m_stopping;
+    std::atomic<int> m_activeTransfers;
+    
+    static constexpr int USB_TIMEOUT = 1000; // мс
+    static constexpr int STOP_WAIT_STEPS = 20;          // Ожидание отмены запросов: 20 x 100 мс
+    static constexpr int STOP_WAIT_STEP_US = 100000;
+    static constexpr int BULK_IN_ENDPOINT = 0x81;  // Обычно для USB Bulk IN
+    static constexpr int BULK_OUT_ENDPOINT = 0x01; // Обычно для USB Bulk OUT
+};
+
+#endif // LIBUSBBACKEND_H
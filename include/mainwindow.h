@@ -2,7 +2,6 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <QTextEdit>
 #include <QPushButton>
 #include <QComboBox>
 #include <QLineEdit>
@@ -12,19 +11,29 @@
 #include <QGridLayout>
 #include <QGroupBox>
 #include <QStatusBar>
-#include <QTableWidget>
+#include <QTableView>
 #include <QCheckBox>
 #include <QSpinBox>
 #include <QFileDialog>
 #include <QKeySequence>
 #include <QShortcut>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QTabWidget>
 #include <QTextBrowser>
 #include "caninterface.h"
+#include "mappedcapture.h"
 
 class UDSProtocol;
 class OBD2Protocol;
+class FrameConsumer;
+class MessageTableModel;
+class EventLogView;
+class IdOverviewModel;
+class CaptureTableModel;
+class QSortFilterProxyModel;
+class QAbstractItemModel;
+enum class TraceFormat;
 
 class MainWindow : public QMainWindow
 {
@@ -41,17 +50,23 @@ protected:
 private slots:
     void onConnectClicked();
     void onSendClicked();
-    void onCanMessageReceived(const QString &message);
-    void onCanMessageReceivedDetailed(quint32 id, const QByteArray &data, const QDateTime &timestamp);
+    void onUiTick();
+    void onOverviewToggled(bool enabled);
     void onConnectionStatusChanged(bool connected);
     void onErrorOccurred(const QString &error);
     void onStatisticsUpdated();
     void onRefreshPortsClicked();
     void onClearLogClicked();
     void onSaveLogClicked();
+    void onOpenTraceClicked();
+    void onApplyCaptureSelection();
+    void onCloseCaptureClicked();
+    void onRecordToggled(bool enabled);
+    void onRecordingFinished();
     void onFilterToggled(bool enabled);
     void onAddFilterClicked();
     void onClearFiltersClicked();
+    void onFilterExpressionEntered();
     void onAutoRefreshPorts();
     
     // Диагностика
@@ -75,18 +90,46 @@ private:
     void setupUI();
     void logMessage(const QString &message, const QString &type = "INFO");
     void updateStatisticsDisplay();
-    void addMessageToTable(quint32 id, const QByteArray &data, const QDateTime &timestamp, bool isReceived);
+    void flushMessageTable();
+    void logReceivedFrames(const QVector<CanFrame> &frames);
+    void exportTrace(const QString &fileName);
+    void importTrace(const QString &fileName, TraceFormat format);
+    void openCapture(const QString &fileName);
+    void showFileView(QAbstractItemModel *model, const QString &description, bool captureFilters);
+    void closeFileView();
+    int exportRowCount() const;
+    CanFrame exportFrameAt(int row) const;
+    void updateUiLagDisplay();
     void setupShortcuts();
     void saveSettings();
     void loadSettings();
     
     // UI элементы
-    QTextEdit *m_logTextEdit;
-    QTableWidget *m_messageTable;
+    EventLogView *m_logView;
+    QTableView *m_messageTable;
+    MessageTableModel *m_messageModel;
+    IdOverviewModel *m_overviewModel;
+    QSortFilterProxyModel *m_overviewProxy;
+    QCheckBox *m_overviewCheck;
+    
+    // Просмотр файла вместо живой трассы: запись .canrec через индекс файла
+    // или загруженная трасса другого формата в отдельной модели
+    MappedCapture m_capture;
+    CaptureTableModel *m_captureModel;
+    MessageTableModel *m_importModel;
+    bool m_viewingFile;
+    QWidget *m_captureBar;
+    QWidget *m_captureFilters;    // Выборка по ID и времени, только для .canrec
+    QLabel *m_captureFileLabel;
+    QLineEdit *m_captureIdEdit;
+    QLineEdit *m_captureFromEdit;
+    QLineEdit *m_captureToEdit;
     QPushButton *m_connectButton;
     QPushButton *m_refreshPortsButton;
     QPushButton *m_clearLogButton;
     QPushButton *m_saveLogButton;
+    QPushButton *m_openTraceButton;
+    QPushButton *m_recordButton;
     QComboBox *m_baudRateCombo;
     QComboBox *m_portCombo;
     QLineEdit *m_canIdEdit;
@@ -94,15 +137,18 @@ private:
     QPushButton *m_sendButton;
     QLabel *m_statusLabel;
     QLabel *m_statsLabel;
+    QLabel *m_uiLagLabel;
     
     // Фильтры
     QCheckBox *m_filterEnabledCheck;
     QLineEdit *m_filterIdEdit;
+    QLineEdit *m_filterExpressionEdit;
     QPushButton *m_addFilterButton;
     QPushButton *m_clearFiltersButton;
     
     // CAN интерфейс
     CANInterface *m_canInterface;
+    FrameConsumer *m_uiConsumer;
     
     // Диагностические протоколы
     UDSProtocol *m_udsProtocol;
@@ -124,6 +170,19 @@ private:
     
     // Таймеры
     QTimer *m_autoRefreshTimer;
+    QTimer *m_uiTimer;
+    
+    // Такт UI
+    QVector<CanFrame> m_uiFrames;   // Буфер выборки из очереди UI
+    QVector<IdStatistics> m_overviewFrames;  // Буфер снимка для обзора по ID
+    bool m_statsDirty;
+    quint64 m_uiLagNs;              // Максимальная задержка отображения за период
+    QElapsedTimer m_uiLagClock;
+    
+    static constexpr int DEFAULT_UI_REFRESH_RATE = 30;     // Гц
+    static constexpr int MAX_LOGGED_FRAMES_PER_TICK = 20;
+    static constexpr int UI_LAG_UPDATE_INTERVAL = 500;     // мс
+    static constexpr int UI_LAG_WARNING_MS = 100;
     
     bool m_isConnected;
     bool m_useTableView;
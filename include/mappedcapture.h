@@ -0,0 +1,121 @@
+#ifndef MAPPEDCAPTURE_H
+#define MAPPEDCAPTURE_H
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QFile>
+#include <functional>
+#include "canframe.h"
+#include "framerecorder.h"
+
+// Выборка кадров файла записи. Время - в CanClock, как у кадров frameAt().
+struct CaptureSelection {
+    bool allIds = true;
+    quint32 id = 0;
+    bool extended = false;
+    bool timeRange = false;
+    quint64 fromNs = 0;           // Включительно
+    quint64 toNs = 0;             // Включительно
+};
+
+// Файл записи .canrec, отображенный в память (QFile::map), с разреженным
+// индексом. Кадры делятся на блоки по INDEX_BLOCK_FRAMES; для каждого блока
+// хранятся минимальное и максимальное время, для каждого ID - номера
+// блоков, где он встречается. Запрос "ID в интервале" просматривает только
+// такие блоки, остальные страницы файла не читаются.
+//
+// Индекс сохраняется рядом с файлом (indexPath) и при следующем открытии
+// загружается; если файл дописан после построения индекса (запись еще
+// идет), индексируются только новые кадры.
+class MappedCapture
+{
+public:
+    MappedCapture();
+    ~MappedCapture();
+    
+    // progress вызывается при построении индекса (кадров обработано, всего),
+    // false из него прерывает открытие
+    bool open(const QString &path, const std::function<bool(qint64, qint64)> &progress = nullptr);
+    void close();
+    bool isOpen() const { return m_frames != nullptr; }
+    QString errorString() const { return m_lastError; }
+    QString fileName() const { return m_file.fileName(); }
+    
+    quint32 frameCount() const { return m_frameCount; }
+    // Кадр с меткой времени, переведенной в CanClock текущего процесса
+    CanFrame frameAt(quint32 index) const
+    {
+        CanFrame frame = m_frames[index];
+        frame.timestampNs += m_clockOffsetNs;
+        return frame;
+    }
+    // Время первого и последнего кадра (CanClock), 0 - файл пуст
+    quint64 firstTimestampNs() const;
+    quint64 lastTimestampNs() const;
+    int idCount() const { return m_postings.size(); }
+    // Индекс загружен из файла (true) или построен при открытии
+    bool indexLoaded() const { return m_indexLoaded; }
+    
+    // Номера кадров выборки в порядке файла
+    QVector<quint32> select(const CaptureSelection &selection) const;
+    
+    static QString indexPath(const QString &capturePath) { return capturePath + INDEX_SUFFIX; }
+    
+    static constexpr int INDEX_BLOCK_FRAMES = 256;
+    static constexpr const char *INDEX_SUFFIX = ".idx";
+
+private:
+    // Заголовок файла индекса; за ним массивы минимумов и максимумов времени
+    // блоков (quint64), таблица IndexIdEntry и номера блоков (quint32)
+    struct IndexFileHeader {
+        char magic[8];
+        quint32 version;
+        quint32 blockFrames;
+        quint64 frameCount;           // Сколько кадров проиндексировано
+        quint64 captureMonotonicNs;   // Отличает файл записи от другого с тем же именем
+        qint64 captureWallClockMs;
+        quint32 blockCount;
+        quint32 idCount;
+        quint32 postingCount;
+        quint8 reserved[12];
+    };
+    
+    struct IndexIdEntry {
+        quint32 key;
+        quint32 offset;               // В массиве номеров блоков
+        quint32 count;
+    };
+    
+    static quint32 keyOf(const CanFrame &frame);
+    static quint32 keyOf(quint32 id, bool extended);
+    
+    bool loadIndex();
+    bool saveIndex() const;
+    bool buildIndex(quint32 fromFrame, const std::function<bool(qint64, qint64)> &progress);
+    void finishIndex();
+    void adviseAccess(bool sequential);
+    
+    QFile m_file;
+    uchar *m_mapped;
+    const CanFrame *m_frames;         // Внутри m_mapped после заголовка
+    quint32 m_frameCount;
+    CaptureFileHeader m_header;
+    quint64 m_clockOffsetNs;          // CanClock = время в файле + смещение (по модулю 2^64)
+    
+    QVector<quint64> m_blockMin;
+    QVector<quint64> m_blockMax;
+    // Для двоичного поиска по времени при небольшом нарушении порядка кадров
+    // (RX и TX пишутся из разных мест): максимум по блокам до i и минимум от i
+    QVector<quint64> m_prefixMax;
+    QVector<quint64> m_suffixMin;
+    QHash<quint32, QVector<quint32>> m_postings;
+    
+    bool m_indexLoaded;
+    QString m_lastError;
+    
+    static constexpr char INDEX_MAGIC[8] = {'C', 'A', 'N', 'I', 'D', 'X', '0', '1'};
+    static constexpr quint32 INDEX_VERSION = 1;
+};
+
+#endif // MAPPEDCAPTURE_H
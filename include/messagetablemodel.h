@@ -0,0 +1,64 @@
+#ifndef MESSAGETABLEMODEL_H
+#define MESSAGETABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QVector>
+#include "canframe.h"
+
+// Модель таблицы сообщений поверх кольцевого буфера кадров фиксированной
+// емкости. Строки не хранят текст: ячейки форматируются при отрисовке,
+// то есть только для видимых строк. Новые кадры копятся в append() и
+// попадают в модель одной вставкой в flush(); при заполнении буфера
+// самые старые строки удаляются одним блоком.
+class MessageTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        TimeColumn,
+        IdColumn,
+        DataColumn,
+        DirectionColumn,
+        COLUMN_COUNT
+    };
+    
+    explicit MessageTableModel(QObject *parent = nullptr);
+    
+    // Глубина истории в кадрах. Память выделяется по мере заполнения.
+    void setCapacity(int capacity);
+    int capacity() const { return m_capacity; }
+    
+    void append(const CanFrame &frame);
+    void append(const CanFrame *frames, int count);
+    // Применение накопленных кадров, возвращает число добавленных строк
+    int flush();
+    int pendingCount() const { return m_pending.size(); }
+    void clear();
+    
+    const CanFrame &frameAt(int row) const;
+    // Текст ячейки, как в таблице (экспорт)
+    QString cellText(int row, int column) const;
+    
+    // Оформление кадра, общее с таблицей файла записи (CaptureTableModel)
+    static QString frameCellText(const CanFrame &frame, int column);
+    static QVariant frameData(const CanFrame &frame, int column, int role);
+    static QVariant columnHeader(int section, Qt::Orientation orientation, int role);
+    
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    
+    static constexpr int DEFAULT_CAPACITY = 1000000;
+    static constexpr int MAX_CAPACITY = 50000000;
+
+private:
+    int m_capacity;
+    QVector<CanFrame> m_frames;   // Кольцо, растет до m_capacity
+    int m_first;                  // Индекс самой старой строки в m_frames
+    int m_count;
+    QVector<CanFrame> m_pending;  // Кадры до ближайшего flush()
+};
+
+#endif // MESSAGETABLEMODEL_H
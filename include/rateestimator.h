@@ -0,0 +1,52 @@
+#ifndef RATEESTIMATOR_H
+#define RATEESTIMATOR_H
+
+#include <QHash>
+#include <QVector>
+#include "idstatistics.h"
+
+// Скорость сообщений и загрузка шины по скользящему окну. Считается по
+// разности накопленных счетчиков IdStatisticsTable между снимками, поэтому
+// значения не проседают после каждого обновления и не зависят от периода
+// вызова update(). Используется из одного потока.
+class RateEstimator
+{
+public:
+    explicit RateEstimator(quint64 windowNs = DEFAULT_WINDOW_NS);
+    
+    // Номинальная скорость шины, 0 - неизвестна (загрузка не считается)
+    void setBitRate(int kbps);
+    int bitRate() const { return m_bitRateKbps; }
+    
+    // Новый снимок на момент nowNs (CanClock). Заполняет framesPerSecond и
+    // busLoadPercent в ids; totalFrames и totalBits - из IdStatisticsTable.
+    void update(quint64 nowNs, quint64 totalFrames, quint64 totalBits, QVector<IdStatistics> &ids);
+    void reset();
+    
+    double framesPerSecond() const { return m_framesPerSecond; }
+    double busLoadPercent() const { return m_busLoadPercent; }
+    
+    static constexpr quint64 DEFAULT_WINDOW_NS = 1000000000ULL;
+
+private:
+    struct Counters {
+        quint64 frames;
+        quint64 bits;
+    };
+    
+    struct Sample {
+        quint64 timeNs;
+        Counters total;
+        QHash<quint32, Counters> perId; // Ключ - ID и бит направления
+    };
+    
+    double load(quint64 bits, double seconds) const;
+    
+    quint64 m_windowNs;
+    int m_bitRateKbps;
+    QVector<Sample> m_samples;  // По возрастанию времени, первый - база окна
+    double m_framesPerSecond;
+    double m_busLoadPercent;
+};
+
+#endif // RATEESTIMATOR_H
@@ -0,0 +1,65 @@
+#ifndef SCANMATICPARSER_H
+#define SCANMATICPARSER_H
+
+#include <QtGlobal>
+#include <memory>
+#include "canframe.h"
+#include "filterengine.h"
+
+// Разбор потока Scanmatic 2 Pro без промежуточных копий.
+// Формат кадра: 0xAA (старт) + 0x02 (CAN данные) + длина + CAN ID (4 байта, big-endian)
+// + данные (0-8 байт) + 0x55 (конец).
+//
+// Принятые байты записываются в непрерывный буфер, курсор чтения проходит
+// по нему и декодирует кадры на месте в CanFrame. Необработанный хвост переносится
+// в начало буфера один раз на пачку данных (compact()).
+class ScanmaticParser
+{
+public:
+    explicit ScanmaticParser(int capacity = DEFAULT_CAPACITY);
+    
+    ScanmaticParser(const ScanmaticParser &) = delete;
+    ScanmaticParser &operator=(const ScanmaticParser &) = delete;
+    
+    // Изменение размера буфера сбрасывает его содержимое
+    void setCapacity(int capacity);
+    int capacity() const { return m_capacity; }
+    int pending() const { return m_writePos - m_readPos; }
+    void clear();
+    
+    // Запись напрямую в буфер: не более writableBytes() байт по адресу
+    // writePointer(), затем commit() с числом записанных байт
+    quint8 *writePointer() { return m_slab.get() + m_writePos; }
+    int writableBytes() const { return m_capacity - m_writePos; }
+    void commit(int bytes);
+    
+    // Следующий кадр под курсором. false - в буфере нет полного кадра.
+    // Метку времени заполняет вызывающий код. Кадры, отклоненные фильтром,
+    // пропускаются по ID без копирования данных.
+    bool next(CanFrame &frame, FilterEngine *filter = nullptr);
+    
+    // Перенос необработанных байт в начало буфера
+    void compact();
+    
+    // Байты, пропущенные при поиске начала кадра, и кадры без байта конца
+    quint64 skippedBytes() const { return m_skippedBytes; }
+    quint64 malformedFrames() const { return m_malformedFrames; }
+    
+    static constexpr int DEFAULT_CAPACITY = 65536;
+    static constexpr quint8 FRAME_START = 0xAA;
+    static constexpr quint8 FRAME_END = 0x55;
+    static constexpr quint8 TYPE_CAN_DATA = 0x02;
+    static constexpr int HEADER_SIZE = 7;                    // старт + тип + длина + CAN ID
+    static constexpr int MIN_FRAME_SIZE = HEADER_SIZE + 1;     // кадр без данных
+    static constexpr int MAX_FRAME_SIZE = HEADER_SIZE + 8 + 1; // кадр с 8 байтами данных
+
+private:
+    std::unique_ptr<quint8[]> m_slab;
+    int m_capacity;
+    int m_readPos;
+    int m_writePos;
+    quint64 m_skippedBytes;
+    quint64 m_malformedFrames;
+};
+
+#endif // SCANMATICPARSER_H
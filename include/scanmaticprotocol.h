@@ -0,0 +1,27 @@
+#ifndef SCANMATICPROTOCOL_H
+#define SCANMATICPROTOCOL_H
+
+#include <QByteArray>
+#include "canframe.h"
+
+// Команды и кадры протокола Scanmatic 2 Pro, общие для всех транспортов адаптера
+namespace ScanmaticProtocol {
+    constexpr quint8 FRAME_START = 0xAA;
+    constexpr quint8 FRAME_END = 0x55;
+    constexpr quint8 CMD_INIT = 0x01;
+    constexpr quint8 TYPE_CAN_DATA = 0x02;
+    
+    // Код скорости CAN для команды инициализации
+    quint8 speedCode(int baudRateKbps);
+    
+    // Скорость последовательного порта для заданной скорости CAN
+    int serialBaudRate(int baudRateKbps);
+    
+    // 0xAA + 0x01 + код скорости + 0x00 (резерв) + 0x55
+    QByteArray initCommand(int baudRateKbps);
+    
+    // 0xAA + 0x02 + длина + CAN ID (4 байта, big-endian) + данные + 0x55
+    void appendFrame(QByteArray &out, const CanFrame &frame);
+}
+
+#endif // SCANMATICPROTOCOL_H
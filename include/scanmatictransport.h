@@ -0,0 +1,62 @@
+#ifndef SCANMATICTRANSPORT_H
+#define SCANMATICTRANSPORT_H
+
+#include <QByteArray>
+#include <QVector>
+#include <limits>
+#include "cantransport.h"
+#include "scanmaticparser.h"
+
+// Общая часть транспортов адаптера Scanmatic 2 Pro (последовательный порт, USB):
+// разбор потока байт в кадры, кодирование передаваемых кадров и команда инициализации.
+// Наследник реализует только открытие и запись байт в устройство.
+class ScanmaticTransport : public ICanTransport
+{
+    Q_OBJECT
+
+public:
+    explicit ScanmaticTransport(QObject *parent = nullptr);
+    
+    int writeBatch(const CanFrame *frames, int count) override;
+    QString errorString() const override { return m_lastError; }
+    
+    // Размер буфера разбора, применяется при следующем открытии
+    void setBufferSize(int bytes);
+
+protected:
+    // Результат записи байт в устройство
+    enum WriteStatus {
+        WriteOk,        // Записано полностью
+        WriteBusy,      // Ничего не записано: устройство занято, повторить позже
+        WriteFailed     // Ошибка устройства, m_lastError
+    };
+    
+    virtual WriteStatus writeBytes(const QByteArray &bytes) = 0;
+    // Сколько байт можно записать без ожидания; пачка обрезается по целым кадрам
+    virtual qint64 writeSpace() const { return std::numeric_limits<qint64>::max(); }
+    
+    bool sendInitCommand(int baudRateKbps);
+    void resetParser();
+    
+    // Прием без промежуточных копий: запись в writePointer(), затем
+    // commitReceived() с числом байт и меткой времени чтения
+    quint8 *writePointer() { return m_parser.writePointer(); }
+    int writableBytes() const { return m_parser.writableBytes(); }
+    void commitReceived(int bytes, quint64 timestampNs);
+    
+    // Прием готового блока (копируется в буфер разбора частями)
+    void ingest(const char *data, int size, quint64 timestampNs);
+    
+    // Пауза для инициализации адаптера без блокировки событий потока
+    static void settle(int milliseconds);
+    
+    QString m_lastError;
+
+private:
+    ScanmaticParser m_parser;
+    QVector<CanFrame> m_frames;
+    QByteArray m_txBuffer;
+    int m_bufferSize;
+};
+
+#endif // SCANMATICTRANSPORT_H
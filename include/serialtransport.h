@@ -0,0 +1,46 @@
+#ifndef SERIALTRANSPORT_H
+#define SERIALTRANSPORT_H
+
+#include <QSerialPort>
+#include "scanmatictransport.h"
+
+class QTimer;
+
+// Адаптер Scanmatic 2 Pro через виртуальный COM порт
+class SerialTransport : public ScanmaticTransport
+{
+    Q_OBJECT
+
+public:
+    explicit SerialTransport(QObject *parent = nullptr);
+    
+    // Имя порта может содержать описание: "ttyUSB0 (FTDI ...)", "COM3 - USB Serial Port"
+    bool open(const QString &portDisplayName, int baudRateKbps);
+    
+    QString name() const override;
+    bool isOpen() const override;
+    void close() override;
+    
+    void setWriteTimeout(int milliseconds) { m_writeTimeout = milliseconds; }
+
+protected:
+    WriteStatus writeBytes(const QByteArray &bytes) override;
+    qint64 writeSpace() const override;
+
+private:
+    void onReadyRead();
+    void onSerialError(QSerialPort::SerialPortError error);
+    void onBytesWritten();
+    void onWriteTimeout();
+    
+    QSerialPort *m_serialPort;
+    QTimer *m_writeTimer; // Контроль опустошения буфера передачи порта
+    int m_writeTimeout;
+    
+    static constexpr qint64 MAX_PENDING_WRITE = 64 * 1024; // Байт в буфере порта
+    
+    static constexpr quint16 TARGET_VENDOR_ID = 0x20A2;
+    static constexpr quint16 TARGET_PRODUCT_ID = 0x0001;
+};
+
+#endif // SERIALTRANSPORT_H
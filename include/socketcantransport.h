@@ -0,0 +1,64 @@
+#ifndef SOCKETCANTRANSPORT_H
+#define SOCKETCANTRANSPORT_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "cantransport.h"
+
+class QSocketNotifier;
+
+// Интерфейс SocketCAN (Linux): can0, vcan0 и т.п.
+// Чтение и запись пачками через recvmmsg/sendmmsg, метки времени ядра
+// (SO_TIMESTAMPNS), фильтрация на стороне ядра (CAN_RAW_FILTER).
+// Работает в потоке, которому принадлежит объект, через QSocketNotifier.
+class SocketCanTransport : public ICanTransport
+{
+    Q_OBJECT
+
+public:
+    explicit SocketCanTransport(QObject *parent = nullptr);
+    ~SocketCanTransport();
+    
+    bool open(const QString &interfaceName);
+    
+    QString name() const override { return m_interfaceName; }
+    bool isOpen() const override { return m_socket >= 0; }
+    void close() override;
+    
+    // Фильтры CAN_RAW_FILTER. Режим запрета требует CAN_RAW_JOIN_FILTERS;
+    // если ядро его не поддерживает, фильтр не устанавливается.
+    int maxAcceptanceFilters() const override;
+    bool setAcceptanceFilters(const AcceptanceFilters &filters) override;
+    
+    // Отправка пачки кадров вызовами sendmmsg. Возвращает число
+    // отправленных кадров или -1 при ошибке.
+    int writeBatch(const CanFrame *frames, int count) override;
+    
+    QString errorString() const override { return m_lastError; }
+    
+    // Сетевые интерфейсы типа CAN, найденные в /sys/class/net
+    static QStringList availableInterfaces();
+
+private:
+    struct ReceiveBuffers;
+    
+    void onReadyRead();
+    
+    int m_socket;
+    QSocketNotifier *m_notifier;
+    ReceiveBuffers *m_rx;
+    QVector<CanFrame> m_rxFrames;
+    QString m_interfaceName;
+    QString m_lastError;
+    // Счетчик SO_RXQ_OVFL: кадры, потерянные ядром из-за переполнения очереди
+    // сокета, с открытия. Получатель видит прирост за пачку как lostFrames.
+    quint32 m_droppedFrames;
+    
+    static constexpr int RX_BATCH = 64;           // Кадров за один recvmmsg
+    static constexpr int TX_BATCH = 64;           // Кадров за один sendmmsg
+    static constexpr int MAX_BATCHES_PER_READ = 16; // Не занимать поток дольше
+    static constexpr int SOCKET_RCVBUF = 1 << 20;
+};
+
+#endif // SOCKETCANTRANSPORT_H
@@ -0,0 +1,90 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+
+// Ограниченная очередь без блокировок: один поток пишет, один поток читает.
+// Емкость округляется вверх до степени двойки.
+template<typename T>
+class SpscRing
+{
+public:
+    explicit SpscRing(int capacity)
+        : m_capacity(roundUpToPowerOfTwo(capacity))
+        , m_mask(m_capacity - 1)
+        , m_slots(new T[m_capacity])
+        , m_head(0)
+        , m_cachedTail(0)
+        , m_tail(0)
+        , m_cachedHead(0)
+    {
+    }
+    
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+    
+    // Сторона производителя. false - очередь заполнена.
+    bool tryPush(const T &item)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_cachedTail >= m_capacity) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head - m_cachedTail >= m_capacity) {
+                return false;
+            }
+        }
+        m_slots[head & m_mask] = item;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Сторона потребителя. false - очередь пуста.
+    bool tryPop(T &item)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_cachedHead) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail == m_cachedHead) {
+                return false;
+            }
+        }
+        item = std::move(m_slots[tail & m_mask]);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Приблизительное число элементов (точно только для одной из сторон)
+    int size() const
+    {
+        const size_t head = m_head.load(std::memory_order_acquire);
+        const size_t tail = m_tail.load(std::memory_order_acquire);
+        return static_cast<int>(head - tail);
+    }
+    
+    int capacity() const { return static_cast<int>(m_capacity); }
+    bool isEmpty() const { return size() == 0; }
+
+private:
+    static size_t roundUpToPowerOfTwo(int value)
+    {
+        size_t result = 2;
+        while (result < static_cast<size_t>(qMax(2, value))) {
+            result <<= 1;
+        }
+        return result;
+    }
+    
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<T[]> m_slots;
+    
+    // Индексы производителя и потребителя в разных линиях кэша
+    alignas(64) std::atomic<size_t> m_head;
+    size_t m_cachedTail;
+    alignas(64) std::atomic<size_t> m_tail;
+    size_t m_cachedHead;
+};
+
+#endif // SPSCRING_H
@@ -0,0 +1,260 @@
+#ifndef TRACEFILE_H
+#define TRACEFILE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <functional>
+#include <memory>
+#include "canframe.h"
+
+// Форматы файлов трасс для обмена с другими программами
+enum class TraceFormat {
+    Unknown,
+    Capture,     // Собственная запись .canrec (FrameRecorder)
+    Candump,     // Журнал candump -l из can-utils (.log)
+    VectorAsc,   // Текстовый Vector ASC (.asc)
+    VectorBlf    // Двоичный Vector BLF (.blf)
+};
+
+// Потоковое чтение трассы: кадры выдаются пачками, файл целиком в память
+// не загружается. Метки времени переводятся в CanClock через календарное
+// время файла (CanClock::fromNsSinceEpoch), поэтому импортированные кадры
+// отображаются и экспортируются так же, как принятые с шины.
+class TraceReader
+{
+public:
+    virtual ~TraceReader() = default;
+    
+    virtual bool open(const QString &path) = 0;
+    // До maxCount кадров в frames: 0 - конец файла, -1 - ошибка (errorString)
+    virtual int read(CanFrame *frames, int maxCount) = 0;
+    virtual void close() = 0;
+    
+    // Позиция в файле и размер для индикации прогресса
+    virtual qint64 position() const = 0;
+    virtual qint64 size() const = 0;
+    
+    QString errorString() const { return m_lastError; }
+    // Записи, которые нельзя представить CanFrame (CAN FD, поврежденные строки)
+    quint64 skippedRecords() const { return m_skippedRecords; }
+
+protected:
+    QString m_lastError;
+    quint64 m_skippedRecords = 0;
+};
+
+// Потоковая запись трассы. Кадры форматируются в большой буфер и пишутся
+// блоками; close() дописывает хвост и заголовки и должен быть вызван, чтобы
+// файл был полным.
+class TraceWriter
+{
+public:
+    virtual ~TraceWriter() = default;
+    
+    virtual bool open(const QString &path) = 0;
+    virtual bool write(const CanFrame *frames, int count) = 0;
+    virtual bool close() = 0;
+    
+    QString errorString() const { return m_lastError; }
+
+protected:
+    QString m_lastError;
+};
+
+// Формат по расширению файла (для записи)
+TraceFormat traceFormatForFileName(const QString &path);
+// Формат по содержимому начала файла, при неудаче - по расширению (для чтения)
+TraceFormat detectTraceFormat(const QString &path);
+QString traceFormatName(TraceFormat format);
+// Фильтр для QFileDialog со всеми форматами трасс
+QString traceFileFilter();
+
+std::unique_ptr<TraceReader> createTraceReader(TraceFormat format);
+std::unique_ptr<TraceWriter> createTraceWriter(TraceFormat format);
+
+struct TraceConversionStats {
+    quint64 frames = 0;
+    quint64 skippedRecords = 0;
+};
+
+// Преобразование файла трассы пачками по TRACE_BATCH_FRAMES кадров. progress
+// вызывается после каждой пачки с позицией и размером исходного файла,
+// false из него прерывает преобразование.
+bool convertTrace(const QString &sourcePath, const QString &targetPath, TraceConversionStats *stats,
+                  QString *error, const std::function<bool(qint64, qint64)> &progress = nullptr);
+
+constexpr int TRACE_BATCH_FRAMES = 4096;
+
+// Чтение текстового файла блоками по CHUNK_BYTES с выдачей строк без
+// копирования. Строка действительна до следующего вызова readLine().
+class TraceLineInput
+{
+public:
+    bool open(const QString &path, QString *error);
+    void close();
+    
+    // false - конец файла или ошибка чтения (hasError)
+    bool readLine(const char *&begin, const char *&end);
+    bool hasError() const { return m_error; }
+    QString errorString() const { return m_file.errorString(); }
+    
+    qint64 position() const { return m_filePosition - (m_end - m_begin); }
+    qint64 size() const { return m_fileSize; }
+    
+    static constexpr int CHUNK_BYTES = 1024 * 1024;
+
+private:
+    bool refill();
+    
+    QFile m_file;
+    QByteArray m_buffer;
+    int m_begin = 0;
+    int m_end = 0;
+    qint64 m_filePosition = 0;
+    qint64 m_fileSize = 0;
+    bool m_eof = false;
+    bool m_error = false;
+};
+
+// Запись блоками по FLUSH_BYTES в небуферизованный файл
+class TraceOutput
+{
+public:
+    bool open(const QString &path, QString *error);
+    bool close(QString *error);
+    bool isOpen() const { return m_file.isOpen(); }
+    
+    void append(const char *data, int size) { m_buffer.append(data, size); }
+    // Сброс на диск, если буфер заполнен; вызывается после каждой пачки
+    bool flushIfFull(QString *error)
+    {
+        return m_buffer.size() < FLUSH_BYTES || flush(error);
+    }
+    bool flush(QString *error);
+    // Перезапись уже сброшенных данных (заголовки с итогами)
+    bool overwrite(qint64 position, const char *data, int size, QString *error);
+    qint64 size() const { return m_written + m_buffer.size(); }
+    
+    static constexpr int FLUSH_BYTES = 1024 * 1024;
+
+private:
+    QFile m_file;
+    QByteArray m_buffer;
+    qint64 m_written = 0;
+};
+
+// Разбор и форматирование чисел для текстовых форматов без QString и
+// локали: на гигабайтных трассах они определяют скорость преобразования.
+namespace TraceText {
+    inline bool isSpace(char c) { return c == ' ' || c == '\t'; }
+    
+    inline void skipSpaces(const char *&p, const char *end)
+    {
+        while (p < end && isSpace(*p)) {
+            ++p;
+        }
+    }
+    
+    // Слово до пробела или конца строки
+    inline void nextToken(const char *&p, const char *end, const char *&tokenBegin, const char *&tokenEnd)
+    {
+        skipSpaces(p, end);
+        tokenBegin = p;
+        while (p < end && !isSpace(*p)) {
+            ++p;
+        }
+        tokenEnd = p;
+    }
+    
+    inline int hexDigit(char c)
+    {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+    
+    // Число в системе base (16 или 10) до первого недопустимого символа.
+    // Возвращает число цифр, 0 - нет цифр или переполнение 32 бит.
+    inline int parseNumber(const char *&p, const char *end, int base, quint32 &value)
+    {
+        quint64 result = 0;
+        int digits = 0;
+        while (p < end) {
+            const int digit = hexDigit(*p);
+            if (digit < 0 || digit >= base) {
+                break;
+            }
+            result = result * base + digit;
+            if (result > 0xFFFFFFFFULL) {
+                return 0;
+            }
+            ++digits;
+            ++p;
+        }
+        value = static_cast<quint32>(result);
+        return digits;
+    }
+    
+    // Секунды с дробной частью ("1436509053.850870") в наносекундах
+    inline bool parseSeconds(const char *&p, const char *end, qint64 &ns)
+    {
+        const char *start = p;
+        qint64 seconds = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            seconds = seconds * 10 + (*p++ - '0');
+            if (seconds > 9000000000LL) {
+                return false;
+            }
+        }
+        if (p == start) {
+            return false;
+        }
+        qint64 fraction = 0;
+        int fractionDigits = 0;
+        if (p < end && *p == '.') {
+            ++p;
+            while (p < end && *p >= '0' && *p <= '9') {
+                if (fractionDigits < 9) {
+                    fraction = fraction * 10 + (*p - '0');
+                    ++fractionDigits;
+                }
+                ++p;
+            }
+        }
+        for (int i = fractionDigits; i < 9; ++i) {
+            fraction *= 10;
+        }
+        ns = seconds * 1000000000LL + fraction;
+        return true;
+    }
+    
+    inline char *writeDecimal(char *out, quint64 value, int minDigits = 1)
+    {
+        char digits[20];
+        int count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        while (count < minDigits) {
+            digits[count++] = '0';
+        }
+        while (count > 0) {
+            *out++ = digits[--count];
+        }
+        return out;
+    }
+    
+    inline char *writeHex(char *out, quint32 value, int digits)
+    {
+        static const char HEX[] = "0123456789ABCDEF";
+        for (int shift = (digits - 1) * 4; shift >= 0; shift -= 4) {
+            *out++ = HEX[(value >> shift) & 0xF];
+        }
+        return out;
+    }
+}
+
+#endif // TRACEFILE_H
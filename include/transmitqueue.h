@@ -0,0 +1,136 @@
+#ifndef TRANSMITQUEUE_H
+#define TRANSMITQUEUE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "canframe.h"
+
+// Результат отправки кадра: success - кадр принят устройством или драйвером,
+// frame - кадр в том виде, в каком был поставлен (с меткой времени вызывающего)
+using TransmitCallback = std::function<void(bool success, const CanFrame &frame)>;
+// Один callback на много кадров: при постановке копируется указатель,
+// а не std::function, и память на кадр не выделяется
+using TransmitCallbackPtr = std::shared_ptr<const TransmitCallback>;
+
+// Класс приоритета передачи. Кадры старшего класса всегда уходят раньше;
+// внутри класса - по возрастанию CAN ID, как при арбитраже на шине,
+// кадры с одинаковым ID - в порядке постановки.
+enum class TransmitPriority : quint8 {
+    High = 0,     // Диагностические запросы (UDS, OBD2)
+    Normal = 1,   // Ручная отправка
+    Periodic = 2, // Циклическая передача: срок отправки важнее генераторов
+    Bulk = 3,     // Генераторы
+};
+
+// Кадр, ожидающий передачи
+struct TransmitRequest {
+    CanFrame frame;
+    TransmitCallbackPtr callback; // Может быть пустым
+    quint64 sequence;          // Порядок постановки
+    quint64 enqueuedNs;        // CanClock, момент постановки
+    TransmitPriority priority;
+};
+
+struct TransmitStatistics {
+    static constexpr int PRIORITY_COUNT = 4;
+    
+    quint64 queued;   // Поставлено в очередь
+    quint64 sent;     // Принято транспортом
+    quint64 failed;   // Ошибка записи или переполнение очереди
+    quint64 rateLimited; // Кадров, задержанных ограничением частоты ID
+    int pending;      // Ожидают отправки сейчас
+    
+    // По классам приоритета (индекс - TransmitPriority)
+    int pendingPerPriority[PRIORITY_COUNT];
+    int maxDepthPerPriority[PRIORITY_COUNT];    // Наибольшая глубина очереди
+    quint64 averageWaitUs[PRIORITY_COUNT];      // От постановки до записи
+    quint64 maxWaitUs[PRIORITY_COUNT];
+};
+
+// Очередь передачи: кадры ставятся из любого потока, забираются пачкой
+// потоком сбора и отправляются одной записью в устройство.
+// У каждого класса приоритета своя емкость, поэтому заполненный фоновым
+// трафиком класс Bulk не мешает постановке диагностических запросов.
+class TransmitQueue
+{
+public:
+    explicit TransmitQueue(int capacityPerPriority = DEFAULT_CAPACITY);
+    
+    // false - очередь класса заполнена, кадр не принят
+    bool enqueue(const CanFrame &frame, TransmitPriority priority,
+                 const TransmitCallbackPtr &callback = TransmitCallbackPtr());
+    
+    // Забирает до maxCount кадров, готовых к отправке в момент nowNs.
+    // Кадры, задержанные ограничением частоты, остаются в очереди.
+    int take(QVector<TransmitRequest> &requests, int maxCount, quint64 nowNs);
+    
+    // Возврат неотправленных кадров в очередь (транспорт занят)
+    void requeue(const TransmitRequest *requests, int count);
+    
+    // Отбрасывает все ожидающие кадры, их callback вызывается с false
+    void clear();
+    
+    bool isEmpty() const;
+    int pending() const;
+    
+    // Момент (CanClock), когда освободится ближайший задержанный кадр; 0 - таких нет
+    quint64 nextReleaseNs() const;
+    
+    // Не более framesPerSecond кадров с данным ID; 0 - без ограничения
+    void setRateLimit(quint32 id, int framesPerSecond);
+    void clearRateLimits();
+    
+    void reportSent(int count) { m_sent.fetch_add(count, std::memory_order_relaxed); }
+    void reportFailed(int count) { m_failed.fetch_add(count, std::memory_order_relaxed); }
+    TransmitStatistics statistics() const;
+    void resetStatistics();
+    
+    static constexpr int DEFAULT_CAPACITY = 4096;
+    static constexpr int PRIORITY_COUNT = TransmitStatistics::PRIORITY_COUNT;
+
+private:
+    // Кадры ID с ограничением частоты ждут окна в своей очереди вне куч:
+    // в куче находится не больше одного кадра такого ID (голова очереди),
+    // поэтому take() не перебирает задержанные кадры.
+    struct RateLimit {
+        quint64 intervalNs = 0;
+        quint64 nextAllowedNs = 0;
+        bool inHeap = false;                  // Кадр этого ID уже в куче
+        std::deque<TransmitRequest> waiting;  // В порядке постановки
+    };
+    
+    struct WaitStats {
+        quint64 totalNs = 0;
+        quint64 maxNs = 0;
+        quint64 count = 0;
+    };
+    
+    void push(TransmitRequest &&request);
+    void releaseWaiting(quint64 nowNs);
+    void releaseAll(RateLimit &limit);
+    int pendingLocked() const;
+    
+    mutable QMutex m_mutex;
+    // Двоичная куча на класс: вершина - наименьший (ID, порядок постановки)
+    std::vector<TransmitRequest> m_heaps[PRIORITY_COUNT];
+    int m_waiting[PRIORITY_COUNT];        // Кадров класса в очередях RateLimit::waiting
+    QHash<quint32, RateLimit> m_rateLimits;
+    int m_capacity;
+    quint64 m_nextSequence;
+    quint64 m_nextReleaseNs;
+    int m_maxDepth[PRIORITY_COUNT];
+    WaitStats m_wait[PRIORITY_COUNT];
+    
+    std::atomic<quint64> m_queued;
+    std::atomic<quint64> m_sent;
+    std::atomic<quint64> m_failed;
+    std::atomic<quint64> m_rateLimited;
+};
+
+#endif // TRANSMITQUEUE_H
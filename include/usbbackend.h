@@ -0,0 +1,43 @@
+#ifndef USBBACKEND_H
+#define USBBACKEND_H
+
+#include <QByteArray>
+#include <QString>
+#include <functional>
+
+// Устройство за USBDevice: адаптер через libusb (LibusbBackend) или
+// программная замена (UsbLoopbackBackend) для нагрузочных проверок без адаптера
+class UsbBackend
+{
+public:
+    // Вызываются в потоке приема backend'а (поток событий libusb, генератор)
+    using DataHandler = std::function<void(const char *data, int size)>;
+    using ErrorHandler = std::function<void(const QString &error)>;
+    
+    virtual ~UsbBackend() = default;
+    
+    // Открытие устройства и запуск асинхронного приема: transferCount
+    // одновременных запросов bulk IN по transferSize байт
+    virtual bool open(quint16 vendorId, quint16 productId, int transferCount, int transferSize) = 0;
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+    
+    // Синхронная запись bulk OUT. Возвращает число записанных байт или -1.
+    // Меньше data.size() - устройство не приняло остаток за время ожидания.
+    virtual int write(const QByteArray &data) = 0;
+    // Синхронное чтение bulk IN в обход асинхронного приема
+    virtual QByteArray read(int timeoutMs) = 0;
+    virtual QString errorString() const = 0;
+    
+    void setHandlers(const DataHandler &onData, const ErrorHandler &onError)
+    {
+        m_onData = onData;
+        m_onError = onError;
+    }
+
+protected:
+    DataHandler m_onData;
+    ErrorHandler m_onError;
+};
+
+#endif // USBBACKEND_H
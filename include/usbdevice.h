@@ -3,11 +3,9 @@
 
 #include <QObject>
 #include <QByteArray>
-#include <QTimer>
+#include <memory>
 
-// Forward declaration для libusb
-struct libusb_device_handle;
-struct libusb_context;
+class UsbBackend;
 
 class USBDevice : public QObject
 {
@@ -21,31 +19,40 @@ public:
     void close();
     bool isOpen() const;
     
-    bool write(const QByteArray &data);
+    // Число записанных байт или -1, см. UsbBackend::write
+    int write(const QByteArray &data);
     QByteArray read(int timeoutMs = 1000);
     
     QString errorString() const;
+    
+    // Замена устройства (по умолчанию libusb). Открытое устройство закрывается,
+    // новый backend используется со следующего open().
+    void setBackend(std::unique_ptr<UsbBackend> backend);
+    UsbBackend *backend() const { return m_backend.get(); }
+    
+    // Асинхронный прием: количество одновременно отправленных bulk IN
+    // запросов и размер буфера каждого. Применяются при следующем open().
+    void setTransferCount(int count);
+    void setTransferSize(int bytes);
+    int transferCount() const { return m_transferCount; }
+    int transferSize() const { return m_transferSize; }
 
 signals:
+    // Испускается из потока приема backend'а, получатели в других потоках
+    // получают данные через очередь событий
     void dataReceived(const QByteArray &data);
     void errorOccurred(const QString &error);
 
-private slots:
-    void pollUSB();
-
 private:
-    libusb_context *m_context;
-    libusb_device_handle *m_handle;
-    bool m_isOpen;
+    std::unique_ptr<UsbBackend> m_backend;
     quint16 m_vendorId;
     quint16 m_productId;
-    QTimer *m_pollTimer;
-    QString m_lastError;
+    int m_transferCount;
+    int m_transferSize;
     
-    static constexpr int USB_TIMEOUT = 1000; // мс
-    static constexpr int BULK_IN_ENDPOINT = 0x81;  // Обычно для USB Bulk IN
-    static constexpr int BULK_OUT_ENDPOINT = 0x01; // Обычно для USB Bulk OUT
+    static constexpr int DEFAULT_TRANSFER_COUNT = 8;
+    static constexpr int DEFAULT_TRANSFER_SIZE = 4096;
+    static constexpr int MAX_TRANSFER_COUNT = 64;
 };
 
 #endif // USBDEVICE_H
-
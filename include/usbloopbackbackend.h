@@ -0,0 +1,88 @@
+#ifndef USBLOOPBACKBACKEND_H
+#define USBLOOPBACKBACKEND_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <atomic>
+#include "usbbackend.h"
+
+class QThread;
+
+// Программная замена адаптера на стороне USB: поток выдает поток кадров
+// Scanmatic пакетами bulk IN заданного размера и с заданным периодом,
+// записи bulk OUT разбираются (команда инициализации, эхо кадров).
+// Для нагрузочных и длительных проверок connectUSB() и пути приема без устройства.
+class UsbLoopbackBackend : public UsbBackend
+{
+public:
+    struct Config {
+        int frameRate = 10000;          // Кадров/с, 0 - без ограничения
+        int packetSize = 64;            // Байт в пакете bulk IN (не больше transferSize)
+        int packetSizeMax = 0;          // Больше packetSize - размер пакета случайный в диапазоне
+        int packetIntervalUs = 1000;    // Период выдачи пакетов (опрос хоста)
+        bool waitForInit = true;        // Поток кадров только после команды инициализации
+        bool echoWrites = true;         // Отправленные кадры возвращаются в поток приема
+        bool embedTimestamp = true;     // Первые 8 байт данных - CanClock::nowNs() при генерации
+        int writeLatencyUs = 0;         // Задержка каждой записи bulk OUT
+        quint32 firstId = 0x100;
+        int idCount = 16;
+        int dlc = 8;
+    };
+    
+    struct Statistics {
+        quint64 packets;         // Выдано пакетов bulk IN
+        quint64 bytesIn;
+        quint64 framesGenerated;
+        quint64 framesEchoed;
+        quint64 writes;          // Записей bulk OUT
+        quint64 bytesOut;
+        bool initReceived;
+    };
+    
+    UsbLoopbackBackend();
+    explicit UsbLoopbackBackend(const Config &config);
+    ~UsbLoopbackBackend() override;
+    
+    // Применяется при следующем open()
+    void setConfig(const Config &config) { m_config = config; }
+    const Config &config() const { return m_config; }
+    
+    bool open(quint16 vendorId, quint16 productId, int transferCount, int transferSize) override;
+    void close() override;
+    bool isOpen() const override { return m_isOpen; }
+    
+    int write(const QByteArray &data) override;
+    QByteArray read(int timeoutMs) override;
+    QString errorString() const override { return m_lastError; }
+    
+    Statistics statistics() const;
+
+private:
+    void runGenerator();
+    void appendGenerated(QByteArray &stream, int count);
+    
+    Config m_config;
+    std::atomic<bool> m_isOpen;
+    QString m_lastError;
+    int m_transferCount;
+    int m_transferSize;
+    
+    QThread *m_generatorThread;
+    std::atomic<bool> m_stopping;
+    std::atomic<bool> m_initReceived;
+    
+    // Кадры из записей bulk OUT, ожидающие выдачи эхом
+    QMutex m_echoMutex;
+    QByteArray m_echo;
+    
+    std::atomic<quint64> m_packets;
+    std::atomic<quint64> m_bytesIn;
+    std::atomic<quint64> m_framesGenerated;
+    std::atomic<quint64> m_framesEchoed;
+    std::atomic<quint64> m_writes;
+    std::atomic<quint64> m_bytesOut;
+    
+    static constexpr int MAX_BURST_MS = 100; // Предел догоняющей генерации после задержки потока
+};
+
+#endif // USBLOOPBACKBACKEND_H
@@ -0,0 +1,32 @@
+#ifndef USBTRANSPORT_H
+#define USBTRANSPORT_H
+
+#include "scanmatictransport.h"
+
+class USBDevice;
+
+// Адаптер Scanmatic 2 Pro напрямую через libusb (без виртуального COM порта)
+class UsbTransport : public ScanmaticTransport
+{
+    Q_OBJECT
+
+public:
+    explicit UsbTransport(QObject *parent = nullptr);
+    
+    bool open(quint16 vendorId, quint16 productId, int baudRateKbps);
+    
+    QString name() const override;
+    bool isOpen() const override;
+    void close() override;
+    
+    // Настройка асинхронного приема (число запросов, размер буфера)
+    USBDevice *usbDevice() const { return m_usbDevice; }
+
+protected:
+    WriteStatus writeBytes(const QByteArray &bytes) override;
+
+private:
+    USBDevice *m_usbDevice;
+};
+
+#endif // USBTRANSPORT_H
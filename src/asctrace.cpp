@@ -0,0 +1,333 @@
+#include "asctrace.h"
+#include <QDateTime>
+#include <QLocale>
+#include <QStringList>
+#include <cstring>
+
+namespace {
+
+// Дата в заголовке Vector: 12-часовое время с am/pm, английские названия
+const char *const ASC_DATE_FORMAT = "ddd MMM dd hh:mm:ss.zzz ap yyyy";
+
+bool startsWith(const char *p, const char *end, const char *prefix)
+{
+    const size_t length = std::strlen(prefix);
+    return static_cast<size_t>(end - p) >= length && std::memcmp(p, prefix, length) == 0;
+}
+
+bool tokenEquals(const char *token, const char *tokenEnd, const char *text)
+{
+    const size_t length = std::strlen(text);
+    return static_cast<size_t>(tokenEnd - token) == length && std::memcmp(token, text, length) == 0;
+}
+
+// Время из строки date; -1, если формат не распознан (локализованные
+// названия дней и месяцев в файлах немецких версий CANoe)
+qint64 parseAscDate(const QString &text)
+{
+    static const QStringList formats = {
+        ASC_DATE_FORMAT,
+        "ddd MMM d h:mm:ss.zzz ap yyyy",
+        "ddd MMM d h:mm:ss ap yyyy",
+        "ddd MMM d H:mm:ss.zzz yyyy",
+        "ddd MMM d H:mm:ss yyyy"
+    };
+    const QString simplified = text.simplified();
+    for (const QString &format : formats) {
+        const QDateTime dateTime = QLocale::c().toDateTime(simplified, format);
+        if (dateTime.isValid()) {
+            return dateTime.toMSecsSinceEpoch() * 1000000;
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+bool AscReader::open(const QString &path)
+{
+    m_skippedRecords = 0;
+    m_startNs = 0;
+    m_previousNs = 0;
+    m_base = 16;
+    m_relativeTimestamps = false;
+    return m_input.open(path, &m_lastError);
+}
+
+void AscReader::close()
+{
+    m_input.close();
+}
+
+int AscReader::read(CanFrame *frames, int maxCount)
+{
+    int count = 0;
+    const char *begin;
+    const char *end;
+    while (count < maxCount && m_input.readLine(begin, end)) {
+        TraceText::skipSpaces(begin, end);
+        if (begin == end) {
+            continue;
+        }
+        if (*begin < '0' || *begin > '9') {
+            parseHeader(begin, end);
+            continue;
+        }
+        const int result = parseEvent(begin, end, frames[count]);
+        if (result > 0) {
+            ++count;
+        } else if (result < 0) {
+            ++m_skippedRecords;
+        }
+    }
+    if (m_input.hasError()) {
+        m_lastError = QString("Ошибка чтения: %1").arg(m_input.errorString());
+        return -1;
+    }
+    return count;
+}
+
+void AscReader::parseHeader(const char *p, const char *end)
+{
+    using namespace TraceText;
+    
+    if (startsWith(p, end, "date ")) {
+        const qint64 startNs = parseAscDate(QString::fromLatin1(p + 5, static_cast<int>(end - p - 5)));
+        if (startNs >= 0) {
+            m_startNs = startNs;
+            m_previousNs = 0;
+        }
+        return;
+    }
+    if (!startsWith(p, end, "base ")) {
+        return;
+    }
+    
+    // base hex  timestamps absolute
+    const char *token;
+    const char *tokenEnd;
+    nextToken(p, end, token, tokenEnd);
+    nextToken(p, end, token, tokenEnd);
+    m_base = tokenEquals(token, tokenEnd, "dec") ? 10 : 16;
+    nextToken(p, end, token, tokenEnd);
+    if (tokenEquals(token, tokenEnd, "timestamps")) {
+        nextToken(p, end, token, tokenEnd);
+        m_relativeTimestamps = tokenEquals(token, tokenEnd, "relative");
+    }
+}
+
+int AscReader::parseEvent(const char *p, const char *end, CanFrame &frame)
+{
+    using namespace TraceText;
+    
+    qint64 timeNs = 0;
+    if (!parseSeconds(p, end, timeNs)) {
+        return 0;
+    }
+    if (m_relativeTimestamps) {
+        timeNs += m_previousNs;
+        m_previousNs = timeNs;
+    }
+    
+    const char *token;
+    const char *tokenEnd;
+    nextToken(p, end, token, tokenEnd);
+    if (tokenEquals(token, tokenEnd, "CANFD")) {
+        return -1;
+    }
+    // Номер канала; строки без него (Start of measurement и т.п.) - не кадры
+    quint32 channel = 0;
+    const char *cursor = token;
+    if (parseNumber(cursor, tokenEnd, 10, channel) == 0 || cursor != tokenEnd) {
+        return 0;
+    }
+    
+    frame = CanFrame();
+    frame.timestampNs = CanClock::fromNsSinceEpoch(m_startNs + timeNs);
+    
+    nextToken(p, end, token, tokenEnd);
+    if (tokenEquals(token, tokenEnd, "ErrorFrame")) {
+        frame.flags = CanFrame::FLAG_ERROR;
+        return 1;
+    }
+    
+    quint32 id = 0;
+    cursor = token;
+    if (parseNumber(cursor, tokenEnd, m_base, id) == 0) {
+        // Прочие события канала (Statistic:, SV:, J1939TP ...)
+        return 0;
+    }
+    if (cursor < tokenEnd && (*cursor == 'x' || *cursor == 'X')) {
+        frame.flags |= CanFrame::FLAG_EXTENDED;
+        ++cursor;
+    }
+    if (cursor != tokenEnd) {
+        return 0;
+    }
+    if (id > (frame.isExtended() ? 0x1FFFFFFFu : 0x7FFu)) {
+        return -1;
+    }
+    frame.id = id;
+    
+    nextToken(p, end, token, tokenEnd);
+    if (tokenEquals(token, tokenEnd, "Tx")) {
+        frame.flags |= CanFrame::FLAG_TX;
+    } else if (!tokenEquals(token, tokenEnd, "Rx")) {
+        // TxRq и другие служебные записи
+        return 0;
+    }
+    
+    nextToken(p, end, token, tokenEnd);
+    const bool remote = tokenEquals(token, tokenEnd, "r");
+    if (!remote && !tokenEquals(token, tokenEnd, "d")) {
+        return -1;
+    }
+    
+    // DLC записывается в той же системе, что и данные; у удаленного запроса необязателен
+    nextToken(p, end, token, tokenEnd);
+    quint32 dlc = 0;
+    cursor = token;
+    if (token == tokenEnd) {
+        if (!remote) {
+            return -1;
+        }
+    } else if (parseNumber(cursor, tokenEnd, m_base, dlc) == 0 || cursor != tokenEnd || dlc > 8) {
+        return -1;
+    }
+    frame.dlc = static_cast<quint8>(dlc);
+    if (remote) {
+        frame.flags |= CanFrame::FLAG_RTR;
+        return 1;
+    }
+    
+    for (quint32 i = 0; i < dlc; ++i) {
+        nextToken(p, end, token, tokenEnd);
+        quint32 byte = 0;
+        cursor = token;
+        if (parseNumber(cursor, tokenEnd, m_base, byte) == 0 || cursor != tokenEnd || byte > 0xFF) {
+            return -1;
+        }
+        frame.data[i] = static_cast<quint8>(byte);
+    }
+    return 1;
+}
+
+AscWriter::~AscWriter()
+{
+    close();
+}
+
+bool AscWriter::open(const QString &path)
+{
+    m_headerWritten = false;
+    m_startNs = 0;
+    return m_output.open(path, &m_lastError);
+}
+
+void AscWriter::writeHeader(qint64 startNs)
+{
+    // Дата записывается с точностью до миллисекунды: отсчет ведется от нее,
+    // чтобы при чтении восстанавливались те же метки
+    const qint64 startMs = startNs / 1000000 - (startNs % 1000000 < 0 ? 1 : 0);
+    m_startNs = startMs * 1000000;
+    const QByteArray date = QLocale::c().toString(
+        QDateTime::fromMSecsSinceEpoch(startMs), ASC_DATE_FORMAT).toLatin1();
+    
+    QByteArray header;
+    header += "date " + date + "\n";
+    header += "base hex  timestamps absolute\n";
+    header += "internal events logged\n";
+    header += "// version 9.0.0\n";
+    header += "Begin Triggerblock " + date + "\n";
+    header += "   0.000000 Start of measurement\n";
+    m_output.append(header.constData(), header.size());
+    m_headerWritten = true;
+}
+
+bool AscWriter::write(const CanFrame *frames, int count)
+{
+    using namespace TraceText;
+    
+    if (count > 0 && !m_headerWritten) {
+        writeHeader(CanClock::toNsSinceEpoch(frames[0].timestampNs));
+    }
+    
+    char line[128];
+    for (int i = 0; i < count; ++i) {
+        const CanFrame &frame = frames[i];
+        // Кадры раньше начала измерения (нарушенный порядок) - в момент начала
+        const qint64 offsetNs = qMax<qint64>(0, CanClock::toNsSinceEpoch(frame.timestampNs) - m_startNs);
+        
+        char time[32];
+        char *timeEnd = writeDecimal(time, static_cast<quint64>(offsetNs / 1000000000));
+        *timeEnd++ = '.';
+        timeEnd = writeDecimal(timeEnd, static_cast<quint64>(offsetNs % 1000000000 / 1000), 6);
+        const int timeLength = static_cast<int>(timeEnd - time);
+        
+        // Время выровнено вправо по 11 символам, как в файлах CANoe
+        char *out = line;
+        for (int pad = timeLength; pad < 11; ++pad) {
+            *out++ = ' ';
+        }
+        std::memcpy(out, time, timeLength);
+        out += timeLength;
+        std::memcpy(out, " 1  ", 4);
+        out += 4;
+        
+        if (frame.flags & CanFrame::FLAG_ERROR) {
+            std::memcpy(out, "ErrorFrame\n", 11);
+            m_output.append(line, static_cast<int>(out - line) + 11);
+            continue;
+        }
+        
+        // ID без ведущих нулей, 29-битный с суффиксом x, поле шириной 15
+        char *idStart = out;
+        const quint32 id = frame.id & (frame.isExtended() ? 0x1FFFFFFF : 0x7FF);
+        int digits = 1;
+        while (digits < 8 && (id >> (digits * 4)) != 0) {
+            ++digits;
+        }
+        out = writeHex(out, id, digits);
+        if (frame.isExtended()) {
+            *out++ = 'x';
+        }
+        while (out - idStart < 16) {
+            *out++ = ' ';
+        }
+        
+        std::memcpy(out, frame.isTx() ? "Tx   " : "Rx   ", 5);
+        out += 5;
+        
+        const int dlc = qMin<int>(frame.dlc, 8);
+        if (frame.flags & CanFrame::FLAG_RTR) {
+            *out++ = 'r';
+            if (dlc > 0) {
+                *out++ = ' ';
+                out = writeHex(out, dlc, 1);
+            }
+        } else {
+            *out++ = 'd';
+            *out++ = ' ';
+            out = writeHex(out, dlc, 1);
+            for (int byte = 0; byte < dlc; ++byte) {
+                *out++ = ' ';
+                out = writeHex(out, frame.data[byte], 2);
+            }
+        }
+        *out++ = '\n';
+        m_output.append(line, static_cast<int>(out - line));
+    }
+    return m_output.flushIfFull(&m_lastError);
+}
+
+bool AscWriter::close()
+{
+    if (!m_output.isOpen()) {
+        return true;
+    }
+    if (!m_headerWritten) {
+        writeHeader(QDateTime::currentMSecsSinceEpoch() * 1000000);
+    }
+    m_output.append("End TriggerBlock\n", 17);
+    return m_output.close(&m_lastError);
+}
@@ -0,0 +1,452 @@
+#include "blftrace.h"
+#include <QDateTime>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+constexpr int FILE_SIGNATURE_OFFSET = 0;
+constexpr int HEADER_SIZE_OFFSET = 4;
+constexpr int FILE_SIZE_OFFSET = 16;
+constexpr int UNCOMPRESSED_SIZE_OFFSET = 24;
+constexpr int OBJECT_COUNT_OFFSET = 32;
+constexpr int START_TIME_OFFSET = 40;
+constexpr int STOP_TIME_OFFSET = 56;
+
+constexpr int CAN_MESSAGE_OBJECT_SIZE = Blf::OBJECT_HEADER_BASE_SIZE + Blf::OBJECT_HEADER_V1_SIZE + 16;
+constexpr int CAN_ERROR_EXT_OBJECT_SIZE = Blf::OBJECT_HEADER_BASE_SIZE + Blf::OBJECT_HEADER_V1_SIZE + 32;
+
+// Канал в файлах Vector нумеруется с 1
+constexpr quint16 BLF_CHANNEL = 1;
+
+template <typename T>
+T get(const char *p)
+{
+    return qFromLittleEndian<T>(p);
+}
+
+template <typename T>
+void put(char *p, T value)
+{
+    qToLittleEndian<T>(value, p);
+}
+
+void putObjectHeader(char *p, quint16 headerSize, quint32 objectSize, quint32 type)
+{
+    std::memcpy(p, "LOBJ", 4);
+    put<quint16>(p + 4, headerSize);
+    put<quint16>(p + 6, 1);
+    put<quint32>(p + 8, objectSize);
+    put<quint32>(p + 12, type);
+}
+
+// SYSTEMTIME Windows в местном времени: год, месяц, день недели (0 -
+// воскресенье), день, часы, минуты, секунды, миллисекунды
+qint64 readSystemTime(const char *p)
+{
+    const QDate date(get<quint16>(p), get<quint16>(p + 2), get<quint16>(p + 6));
+    const QTime time(get<quint16>(p + 8), get<quint16>(p + 10), get<quint16>(p + 12), get<quint16>(p + 14));
+    const QDateTime dateTime(date, time);
+    return dateTime.isValid() ? dateTime.toMSecsSinceEpoch() * 1000000 : 0;
+}
+
+void writeSystemTime(char *p, qint64 msSinceEpoch)
+{
+    const QDateTime dateTime = QDateTime::fromMSecsSinceEpoch(msSinceEpoch);
+    const QDate date = dateTime.date();
+    const QTime time = dateTime.time();
+    put<quint16>(p, static_cast<quint16>(date.year()));
+    put<quint16>(p + 2, static_cast<quint16>(date.month()));
+    put<quint16>(p + 4, static_cast<quint16>(date.dayOfWeek() % 7));
+    put<quint16>(p + 6, static_cast<quint16>(date.day()));
+    put<quint16>(p + 8, static_cast<quint16>(time.hour()));
+    put<quint16>(p + 10, static_cast<quint16>(time.minute()));
+    put<quint16>(p + 12, static_cast<quint16>(time.second()));
+    put<quint16>(p + 14, static_cast<quint16>(time.msec()));
+}
+
+qint64 floorToMs(qint64 ns)
+{
+    return ns / 1000000 - (ns % 1000000 < 0 ? 1 : 0);
+}
+
+} // namespace
+
+bool BlfReader::open(const QString &path)
+{
+    close();
+    m_skippedRecords = 0;
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_lastError = QString("Не удалось открыть %1: %2").arg(path, m_file.errorString());
+        return false;
+    }
+    
+    const QByteArray header = m_file.read(Blf::FILE_HEADER_SIZE);
+    if (header.size() < STOP_TIME_OFFSET + 16 || !header.startsWith("LOGG")) {
+        m_lastError = QString("%1 не является файлом BLF").arg(path);
+        m_file.close();
+        return false;
+    }
+    const quint32 headerSize = get<quint32>(header.constData() + HEADER_SIZE_OFFSET);
+    m_startNs = readSystemTime(header.constData() + START_TIME_OFFSET);
+    if (headerSize < STOP_TIME_OFFSET + 16 || !m_file.seek(headerSize)) {
+        m_lastError = QString("Поврежденный заголовок BLF: %1").arg(path);
+        m_file.close();
+        return false;
+    }
+    return true;
+}
+
+void BlfReader::close()
+{
+    m_file.close();
+    m_stream.clear();
+    m_streamPos = 0;
+    m_failed = false;
+}
+
+bool BlfReader::loadNextObject()
+{
+    char base[Blf::OBJECT_HEADER_BASE_SIZE];
+    const qint64 objectPos = m_file.pos();
+    // Неполный объект в конце - файл записи, прерванной без закрытия
+    if (m_file.read(base, sizeof(base)) != sizeof(base)) {
+        return false;
+    }
+    const quint32 objectSize = get<quint32>(base + 8);
+    const quint32 type = get<quint32>(base + 12);
+    // Размер из файла проверяется до выделения памяти и чтения
+    if (std::memcmp(base, "LOBJ", 4) != 0 || objectSize < sizeof(base) || objectSize > Blf::MAX_OBJECT_SIZE) {
+        m_lastError = QString("Поврежденный объект BLF по смещению %1").arg(objectPos);
+        m_failed = true;
+        return false;
+    }
+    if (objectSize > m_file.size() - objectPos) {
+        return false;
+    }
+    
+    // Разобранное начало потока больше не нужно
+    if (m_streamPos > 0) {
+        m_stream.remove(0, m_streamPos);
+        m_streamPos = 0;
+    }
+    
+    const int payloadSize = static_cast<int>(objectSize - sizeof(base));
+    if (type == Blf::LOG_CONTAINER) {
+        char container[Blf::CONTAINER_HEADER_SIZE];
+        if (payloadSize < Blf::CONTAINER_HEADER_SIZE
+            || m_file.read(container, sizeof(container)) != sizeof(container)) {
+            return false;
+        }
+        const quint16 method = get<quint16>(container);
+        const quint32 uncompressedSize = get<quint32>(container + 8);
+        const int dataSize = payloadSize - Blf::CONTAINER_HEADER_SIZE;
+        if (uncompressedSize > Blf::MAX_OBJECT_SIZE) {
+            m_lastError = QString("Поврежденный контейнер BLF по смещению %1").arg(objectPos);
+            m_failed = true;
+            return false;
+        }
+        
+        if (method == Blf::ZLIB_DEFLATE) {
+            // qUncompress ждет размер результата в первых 4 байтах (big-endian)
+            m_compressed.resize(4 + dataSize);
+            qToBigEndian<quint32>(uncompressedSize, m_compressed.data());
+            if (m_file.read(m_compressed.data() + 4, dataSize) != dataSize) {
+                return false;
+            }
+            const QByteArray data = qUncompress(reinterpret_cast<const uchar*>(m_compressed.constData()),
+                                                m_compressed.size());
+            if (data.size() != static_cast<int>(uncompressedSize)) {
+                m_lastError = QString("Ошибка распаковки контейнера BLF по смещению %1").arg(objectPos);
+                m_failed = true;
+                return false;
+            }
+            m_stream.append(data);
+        } else if (method == Blf::NO_COMPRESSION) {
+            const int oldSize = m_stream.size();
+            m_stream.resize(oldSize + dataSize);
+            if (m_file.read(m_stream.data() + oldSize, dataSize) != dataSize) {
+                m_stream.resize(oldSize);
+                return false;
+            }
+        } else {
+            m_lastError = QString("Неподдерживаемое сжатие BLF: %1").arg(method);
+            m_failed = true;
+            return false;
+        }
+    } else {
+        // Объект вне контейнера разбирается из того же потока
+        const int oldSize = m_stream.size();
+        m_stream.resize(oldSize + static_cast<int>(objectSize));
+        std::memcpy(m_stream.data() + oldSize, base, sizeof(base));
+        if (m_file.read(m_stream.data() + oldSize + sizeof(base), payloadSize) != payloadSize) {
+            m_stream.resize(oldSize);
+            return false;
+        }
+    }
+    
+    // Объекты верхнего уровня выравниваются на objectSize % 4 байт
+    const int padding = objectSize % 4;
+    if (padding > 0) {
+        m_file.seek(m_file.pos() + padding);
+    }
+    return true;
+}
+
+int BlfReader::parseObject(const char *object, quint32 type, CanFrame &frame)
+{
+    const quint32 objectSize = get<quint32>(object + 8);
+    const quint16 headerSize = get<quint16>(object + 4);
+    const char *payload = object + headerSize;
+    const int payloadSize = static_cast<int>(objectSize) - headerSize;
+    if (headerSize < Blf::OBJECT_HEADER_BASE_SIZE + Blf::OBJECT_HEADER_V1_SIZE || payloadSize < 0) {
+        return 0;
+    }
+    
+    frame = CanFrame();
+    const quint32 timeFlags = get<quint32>(object + 16);
+    const quint64 time = get<quint64>(object + 24);
+    const qint64 timeNs = static_cast<qint64>(timeFlags == Blf::TIME_TEN_MICS ? time * 10000 : time);
+    frame.timestampNs = CanClock::fromNsSinceEpoch(m_startNs + timeNs);
+    
+    switch (type) {
+    case Blf::CAN_MESSAGE:
+    case Blf::CAN_MESSAGE2: {
+        if (payloadSize < 16) {
+            ++m_skippedRecords;
+            return 0;
+        }
+        const quint8 flags = static_cast<quint8>(payload[2]);
+        const quint32 id = get<quint32>(payload + 4);
+        frame.id = id & 0x1FFFFFFF;
+        if (id & Blf::CAN_MSG_EXT) {
+            frame.flags |= CanFrame::FLAG_EXTENDED;
+        }
+        if (flags & Blf::CAN_MSG_DIR_TX) {
+            frame.flags |= CanFrame::FLAG_TX;
+        }
+        if (flags & Blf::CAN_MSG_RTR) {
+            frame.flags |= CanFrame::FLAG_RTR;
+        }
+        // DLC 9-15 классического CAN означает 8 байт
+        frame.dlc = qMin<quint8>(static_cast<quint8>(payload[3]), 8);
+        std::memcpy(frame.data, payload + 8, 8);
+        return 1;
+    }
+    case Blf::CAN_ERROR_EXT:
+        if (payloadSize >= 32) {
+            frame.dlc = qMin<quint8>(static_cast<quint8>(payload[10]), 8);
+            frame.id = get<quint32>(payload + 16) & 0x1FFFFFFF;
+            std::memcpy(frame.data, payload + 24, 8);
+        }
+        frame.flags = CanFrame::FLAG_ERROR;
+        return 1;
+    case Blf::CAN_ERROR:
+        frame.flags = CanFrame::FLAG_ERROR;
+        return 1;
+    case Blf::CAN_FD_MESSAGE:
+    case Blf::CAN_FD_MESSAGE_64:
+        ++m_skippedRecords;
+        return 0;
+    default:
+        // События других шин, маркеры, системные переменные
+        return 0;
+    }
+}
+
+int BlfReader::read(CanFrame *frames, int maxCount)
+{
+    if (m_failed) {
+        return -1;
+    }
+    
+    int count = 0;
+    while (count < maxCount) {
+        const int available = m_stream.size() - m_streamPos;
+        if (available >= Blf::OBJECT_HEADER_BASE_SIZE) {
+            const char *object = m_stream.constData() + m_streamPos;
+            if (std::memcmp(object, "LOBJ", 4) != 0) {
+                // Выравнивание между объектами: ищем следующую сигнатуру
+                const int next = m_stream.indexOf("LOBJ", m_streamPos + 1);
+                if (next >= 0) {
+                    m_streamPos = next;
+                    continue;
+                }
+                m_streamPos = m_stream.size() - 3;
+            } else {
+                const quint32 objectSize = get<quint32>(object + 8);
+                if (objectSize < static_cast<quint32>(Blf::OBJECT_HEADER_BASE_SIZE)
+                    || objectSize > Blf::MAX_OBJECT_SIZE) {
+                    m_streamPos += 4;
+                    continue;
+                }
+                if (objectSize <= static_cast<quint32>(available)) {
+                    if (parseObject(object, get<quint32>(object + 12), frames[count]) > 0) {
+                        ++count;
+                    }
+                    m_streamPos += static_cast<int>(objectSize);
+                    continue;
+                }
+            }
+        }
+        
+        // Объект продолжается в следующем контейнере
+        if (!loadNextObject()) {
+            return (m_failed && count == 0) ? -1 : count;
+        }
+    }
+    return count;
+}
+
+BlfWriter::~BlfWriter()
+{
+    close();
+}
+
+bool BlfWriter::open(const QString &path)
+{
+    if (!m_output.open(path, &m_lastError)) {
+        return false;
+    }
+    m_container.clear();
+    m_container.reserve(MAX_CONTAINER_BYTES + CAN_ERROR_EXT_OBJECT_SIZE);
+    m_started = false;
+    m_startNs = 0;
+    m_lastNs = 0;
+    m_uncompressedSize = Blf::FILE_HEADER_SIZE;
+    m_objectCount = 0;
+    
+    // Итоги в заголовке заполняются при закрытии
+    const QByteArray header(Blf::FILE_HEADER_SIZE, '\0');
+    m_output.append(header.constData(), header.size());
+    return true;
+}
+
+void BlfWriter::appendObject(const CanFrame &frame)
+{
+    const qint64 timeNs = CanClock::toNsSinceEpoch(frame.timestampNs);
+    if (!m_started) {
+        // SYSTEMTIME хранит миллисекунды: отсчет от них, чтобы метки читались обратно точно
+        m_startNs = floorToMs(timeNs) * 1000000;
+        m_started = true;
+    }
+    m_lastNs = qMax(m_lastNs, timeNs);
+    
+    const bool error = frame.flags & CanFrame::FLAG_ERROR;
+    const int objectSize = error ? CAN_ERROR_EXT_OBJECT_SIZE : CAN_MESSAGE_OBJECT_SIZE;
+    char object[CAN_ERROR_EXT_OBJECT_SIZE] = {};
+    putObjectHeader(object, Blf::OBJECT_HEADER_BASE_SIZE + Blf::OBJECT_HEADER_V1_SIZE, objectSize,
+                    error ? Blf::CAN_ERROR_EXT : Blf::CAN_MESSAGE);
+    put<quint32>(object + 16, Blf::TIME_ONE_NANS);
+    put<quint64>(object + 24, static_cast<quint64>(qMax<qint64>(0, timeNs - m_startNs)));
+    
+    char *payload = object + Blf::OBJECT_HEADER_BASE_SIZE + Blf::OBJECT_HEADER_V1_SIZE;
+    put<quint16>(payload, BLF_CHANNEL);
+    const quint8 dlc = qMin<quint8>(frame.dlc, 8);
+    if (error) {
+        payload[10] = static_cast<char>(dlc);
+        put<quint32>(payload + 16, frame.id);
+        std::memcpy(payload + 24, frame.data, 8);
+    } else {
+        quint8 flags = 0;
+        if (frame.isTx()) {
+            flags |= Blf::CAN_MSG_DIR_TX;
+        }
+        if (frame.flags & CanFrame::FLAG_RTR) {
+            flags |= Blf::CAN_MSG_RTR;
+        }
+        payload[2] = static_cast<char>(flags);
+        payload[3] = static_cast<char>(dlc);
+        put<quint32>(payload + 4, frame.isExtended() ? ((frame.id & 0x1FFFFFFF) | Blf::CAN_MSG_EXT)
+                                                      : (frame.id & 0x7FF));
+        std::memcpy(payload + 8, frame.data, 8);
+    }
+    m_container.append(object, objectSize);
+    ++m_objectCount;
+}
+
+bool BlfWriter::flushContainer()
+{
+    if (m_container.isEmpty()) {
+        return true;
+    }
+    
+    QByteArray compressed;
+    const char *data = m_container.constData();
+    int dataSize = m_container.size();
+    quint16 method = Blf::NO_COMPRESSION;
+    if (m_compressionLevel > 0) {
+        // qCompress: 4 байта размера (big-endian), затем поток zlib, как в BLF
+        compressed = qCompress(m_container, m_compressionLevel);
+        data = compressed.constData() + 4;
+        dataSize = compressed.size() - 4;
+        method = Blf::ZLIB_DEFLATE;
+    }
+    
+    const quint32 objectSize = Blf::OBJECT_HEADER_BASE_SIZE + Blf::CONTAINER_HEADER_SIZE + dataSize;
+    char header[Blf::OBJECT_HEADER_BASE_SIZE + Blf::CONTAINER_HEADER_SIZE] = {};
+    putObjectHeader(header, Blf::OBJECT_HEADER_BASE_SIZE, objectSize, Blf::LOG_CONTAINER);
+    put<quint16>(header + Blf::OBJECT_HEADER_BASE_SIZE, method);
+    put<quint32>(header + Blf::OBJECT_HEADER_BASE_SIZE + 8, static_cast<quint32>(m_container.size()));
+    
+    m_output.append(header, sizeof(header));
+    m_output.append(data, dataSize);
+    static const char PADDING[4] = {};
+    m_output.append(PADDING, objectSize % 4);
+    
+    m_uncompressedSize += sizeof(header) + m_container.size();
+    m_container.clear();
+    return m_output.flushIfFull(&m_lastError);
+}
+
+bool BlfWriter::write(const CanFrame *frames, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        appendObject(frames[i]);
+        if (m_container.size() >= MAX_CONTAINER_BYTES && !flushContainer()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QByteArray BlfWriter::fileHeader() const
+{
+    QByteArray header(Blf::FILE_HEADER_SIZE, '\0');
+    char *p = header.data();
+    std::memcpy(p + FILE_SIGNATURE_OFFSET, "LOGG", 4);
+    put<quint32>(p + HEADER_SIZE_OFFSET, Blf::FILE_HEADER_SIZE);
+    // Версия формата двоичного журнала 2.6.8.1
+    p[12] = 2;
+    p[13] = 6;
+    p[14] = 8;
+    p[15] = 1;
+    put<quint64>(p + FILE_SIZE_OFFSET, static_cast<quint64>(m_output.size()));
+    put<quint64>(p + UNCOMPRESSED_SIZE_OFFSET, m_uncompressedSize);
+    put<quint32>(p + OBJECT_COUNT_OFFSET, m_objectCount);
+    
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    writeSystemTime(p + START_TIME_OFFSET, m_started ? m_startNs / 1000000 : nowMs);
+    writeSystemTime(p + STOP_TIME_OFFSET, m_started ? floorToMs(m_lastNs) : nowMs);
+    return header;
+}
+
+bool BlfWriter::close()
+{
+    if (!m_output.isOpen()) {
+        return true;
+    }
+    
+    bool ok = flushContainer();
+    if (ok) {
+        const QByteArray header = fileHeader();
+        ok = m_output.overwrite(0, header.constData(), header.size(), &m_lastError);
+    }
+    QString closeError;
+    if (!m_output.close(&closeError) && ok) {
+        m_lastError = closeError;
+        ok = false;
+    }
+    return ok;
+}
@@ -0,0 +1,188 @@
+#include "candumptrace.h"
+#include <cstring>
+
+namespace {
+
+constexpr quint32 CAN_ERR_FLAG = 0x20000000;   // Бит кадра ошибки в ID SocketCAN
+constexpr int MAX_LINE_BYTES = 128;            // Самая длинная строка классического кадра
+
+} // namespace
+
+bool CandumpReader::open(const QString &path)
+{
+    m_skippedRecords = 0;
+    return m_input.open(path, &m_lastError);
+}
+
+void CandumpReader::close()
+{
+    m_input.close();
+}
+
+int CandumpReader::read(CanFrame *frames, int maxCount)
+{
+    int count = 0;
+    const char *begin;
+    const char *end;
+    while (count < maxCount && m_input.readLine(begin, end)) {
+        const int result = parseLine(begin, end, frames[count]);
+        if (result > 0) {
+            ++count;
+        } else if (result < 0) {
+            ++m_skippedRecords;
+        }
+    }
+    if (m_input.hasError()) {
+        m_lastError = QString("Ошибка чтения: %1").arg(m_input.errorString());
+        return -1;
+    }
+    return count;
+}
+
+int CandumpReader::parseLine(const char *p, const char *end, CanFrame &frame)
+{
+    using namespace TraceText;
+    
+    skipSpaces(p, end);
+    if (p == end || *p != '(') {
+        return 0;
+    }
+    ++p;
+    
+    qint64 timeNs = 0;
+    if (!parseSeconds(p, end, timeNs) || p == end || *p != ')') {
+        return -1;
+    }
+    ++p;
+    
+    // Имя интерфейса не сохраняется
+    const char *token;
+    const char *tokenEnd;
+    nextToken(p, end, token, tokenEnd);
+    skipSpaces(p, end);
+    
+    frame = CanFrame();
+    frame.timestampNs = CanClock::fromNsSinceEpoch(timeNs);
+    
+    quint32 id = 0;
+    const int idDigits = parseNumber(p, end, 16, id);
+    if (idDigits == 0 || p == end || *p != '#') {
+        return -1;
+    }
+    ++p;
+    if (idDigits > 3) {
+        if (id & CAN_ERR_FLAG) {
+            frame.flags |= CanFrame::FLAG_ERROR;
+        } else {
+            frame.flags |= CanFrame::FLAG_EXTENDED;
+        }
+        id &= 0x1FFFFFFF;
+    } else if (id > 0x7FF) {
+        return -1;
+    }
+    frame.id = id;
+    
+    if (p < end && *p == '#') {
+        // CAN FD не помещается в CanFrame
+        return -1;
+    }
+    
+    if (p < end && (*p == 'R' || *p == 'r')) {
+        frame.flags |= CanFrame::FLAG_RTR;
+        ++p;
+        if (p < end && !isSpace(*p)) {
+            const int dlc = hexDigit(*p++);
+            if (dlc < 0 || dlc > 8) {
+                return -1;
+            }
+            frame.dlc = static_cast<quint8>(dlc);
+        }
+    } else {
+        while (p < end && !isSpace(*p)) {
+            // Разделители байтов '.' из вывода candump
+            if (*p == '.') {
+                ++p;
+                continue;
+            }
+            const int high = hexDigit(*p);
+            const int low = p + 1 < end ? hexDigit(p[1]) : -1;
+            if (high < 0 || low < 0 || frame.dlc == 8) {
+                return -1;
+            }
+            frame.data[frame.dlc++] = static_cast<quint8>((high << 4) | low);
+            p += 2;
+        }
+    }
+    
+    // Необязательная метка направления
+    nextToken(p, end, token, tokenEnd);
+    if (tokenEnd - token == 1 && *token == 'T') {
+        frame.flags |= CanFrame::FLAG_TX;
+    }
+    return 1;
+}
+
+CandumpWriter::~CandumpWriter()
+{
+    close();
+}
+
+bool CandumpWriter::open(const QString &path)
+{
+    return m_output.open(path, &m_lastError);
+}
+
+bool CandumpWriter::write(const CanFrame *frames, int count)
+{
+    using namespace TraceText;
+    
+    char line[MAX_LINE_BYTES + 64];
+    for (int i = 0; i < count; ++i) {
+        const CanFrame &frame = frames[i];
+        const qint64 timeNs = qMax<qint64>(0, CanClock::toNsSinceEpoch(frame.timestampNs));
+        
+        char *out = line;
+        *out++ = '(';
+        out = writeDecimal(out, static_cast<quint64>(timeNs / 1000000000));
+        *out++ = '.';
+        out = writeDecimal(out, static_cast<quint64>(timeNs % 1000000000 / 1000), 6);
+        *out++ = ')';
+        *out++ = ' ';
+        const int nameLength = qMin<int>(m_interfaceName.size(), 32);
+        std::memcpy(out, m_interfaceName.constData(), nameLength);
+        out += nameLength;
+        *out++ = ' ';
+        
+        if (frame.flags & CanFrame::FLAG_ERROR) {
+            out = writeHex(out, (frame.id & 0x1FFFFFFF) | CAN_ERR_FLAG, 8);
+        } else if (frame.isExtended()) {
+            out = writeHex(out, frame.id & 0x1FFFFFFF, 8);
+        } else {
+            out = writeHex(out, frame.id & 0x7FF, 3);
+        }
+        *out++ = '#';
+        
+        const int dlc = qMin<int>(frame.dlc, 8);
+        if (frame.flags & CanFrame::FLAG_RTR) {
+            *out++ = 'R';
+            if (dlc > 0) {
+                *out++ = static_cast<char>('0' + dlc);
+            }
+        } else {
+            for (int byte = 0; byte < dlc; ++byte) {
+                out = writeHex(out, frame.data[byte], 2);
+            }
+        }
+        *out++ = '\n';
+        m_output.append(line, static_cast<int>(out - line));
+    }
+    return m_output.flushIfFull(&m_lastError);
+}
+
+bool CandumpWriter::close()
+{
+    if (!m_output.isOpen()) {
+        return true;
+    }
+    return m_output.close(&m_lastError);
+}
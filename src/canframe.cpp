@@ -0,0 +1,69 @@
+#include "canframe.h"
+#include <QByteArray>
+#include <QDateTime>
+#include <cstring>
+
+QByteArray CanFrame::payload() const
+{
+    return QByteArray(reinterpret_cast<const char*>(data), dlc);
+}
+
+CanFrame CanFrame::make(quint32 id, const QByteArray &data, quint64 timestampNs, quint8 flags)
+{
+    CanFrame frame = {};
+    frame.timestampNs = timestampNs;
+    frame.id = id;
+    frame.flags = flags;
+    if (id > 0x7FF) {
+        frame.flags |= FLAG_EXTENDED;
+    }
+    frame.dlc = static_cast<quint8>(qMin(static_cast<int>(data.size()), 8));
+    std::memcpy(frame.data, data.constData(), frame.dlc);
+    return frame;
+}
+
+namespace {
+
+// Соответствие монотонного и календарного времени, фиксируется один раз
+struct ClockAnchor {
+    quint64 monotonicNs;
+    qint64 wallMs;
+    
+    ClockAnchor()
+        : monotonicNs(CanClock::nowNs())
+        , wallMs(QDateTime::currentMSecsSinceEpoch())
+    {
+    }
+};
+
+const ClockAnchor &clockAnchor()
+{
+    static const ClockAnchor anchor;
+    return anchor;
+}
+
+} // namespace
+
+qint64 CanClock::toMSecsSinceEpoch(quint64 timestampNs)
+{
+    const ClockAnchor &anchor = clockAnchor();
+    const qint64 deltaNs = static_cast<qint64>(timestampNs - anchor.monotonicNs);
+    return anchor.wallMs + deltaNs / 1000000;
+}
+
+qint64 CanClock::toNsSinceEpoch(quint64 timestampNs)
+{
+    const ClockAnchor &anchor = clockAnchor();
+    return anchor.wallMs * 1000000 + static_cast<qint64>(timestampNs - anchor.monotonicNs);
+}
+
+quint64 CanClock::fromNsSinceEpoch(qint64 nsSinceEpoch)
+{
+    const ClockAnchor &anchor = clockAnchor();
+    return anchor.monotonicNs + static_cast<quint64>(nsSinceEpoch - anchor.wallMs * 1000000);
+}
+
+QDateTime CanClock::toDateTime(quint64 timestampNs)
+{
+    return QDateTime::fromMSecsSinceEpoch(toMSecsSinceEpoch(timestampNs));
+}
@@ -1,319 +1,187 @@
 #include "caninterface.h"
+#include "serialtransport.h"
+#include "usbtransport.h"
 #include "usbdevice.h"
+#include "usbbackend.h"
+#ifdef Q_OS_LINUX
+#include "socketcantransport.h"
+#endif
+#include "frameconsumer.h"
 #include <QDebug>
+#include <QFileInfo>
 #include <QThread>
-#include <QElapsedTimer>
-#include <QCoreApplication>
+#include <QMetaMethod>
 
 CANInterface::CANInterface(QObject *parent)
     : QObject(parent)
+    , m_txFlushPending(false)
+    , m_batchInterval(0)
     , m_connected(false)
-    , m_useUSB(false)
     , m_currentBaudRate(0)
     , m_readTimeout(5000)
     , m_writeTimeout(1000)
-    , m_maxBufferSize(MAX_BUFFER_SIZE)
     , m_filterEnabled(false)
-    , m_lastSecondMessages(0)
+    , m_sentCount(0)
+    , m_receivedCount(0)
+    , m_errorCount(0)
+    , m_firstMessageNs(0)
+    , m_lastMessageNs(0)
+    , m_rateResetPending(false)
+    , m_messagesPerSecond(0)
+    , m_busLoad(0)
 {
-    m_serialPort = new QSerialPort(this);
-    QObject::connect(m_serialPort, &QSerialPort::readyRead, this, &CANInterface::onDataReceived);
-    QObject::connect(m_serialPort, &QSerialPort::errorOccurred, this, &CANInterface::onSerialError);
+    // Транспорты принадлежат m_ioContext, поэтому их сигналы и прием
+    // обрабатываются в потоке сбора, а не в потоке GUI
+    m_ioContext = new QObject();
+    m_acquisitionThread.setObjectName("CANAcquisitionThread");
+    m_transport = nullptr;
+    
+    m_serialTransport = new SerialTransport(m_ioContext);
+    m_usbTransport = new UsbTransport(m_ioContext);
+    m_transports = {m_serialTransport, m_usbTransport};
+#ifdef Q_OS_LINUX
+    m_socketCanTransport = new SocketCanTransport(m_ioContext);
+    m_transports.append(m_socketCanTransport);
+#else
+    m_socketCanTransport = nullptr;
+#endif
+    
+    // Ошибки уходят подписчикам, потеря устройства закрывает соединение
+    for (ICanTransport *transport : m_transports) {
+        transport->setSink(this);
+        QObject::connect(transport, &ICanTransport::errorOccurred, this, &CANInterface::errorOccurred);
+        QObject::connect(transport, &ICanTransport::deviceLost, m_ioContext, [this, transport]() {
+            if (m_transport == transport) {
+                closeDevice();
+            }
+        }, Qt::QueuedConnection);
+    }
     
-    m_usbDevice = new USBDevice(this);
-    QObject::connect(m_usbDevice, &USBDevice::dataReceived, this, &CANInterface::onUSBDataReceived);
-    QObject::connect(m_usbDevice, &USBDevice::errorOccurred, this, &CANInterface::errorOccurred);
+    m_recorder = new FrameRecorder(this);
+    QObject::connect(m_recorder, &FrameRecorder::errorOccurred, this, &CANInterface::errorOccurred);
+    QObject::connect(m_recorder, &FrameRecorder::finished, this, &CANInterface::recordingFinished);
     
-    // Таймер для обновления статистики
+    // Повтор записи, если транспорт принял не все кадры (очередь ядра заполнена)
+    // или кадры ждут окна ограничения частоты
+    m_txRetryTimer = new QTimer(m_ioContext);
+    m_txRetryTimer->setSingleShot(true);
+    m_txRetryTimer->setTimerType(Qt::PreciseTimer);
+    QObject::connect(m_txRetryTimer, &QTimer::timeout, m_ioContext, [this]() { flushTransmitQueue(); });
+    
+    // Досылка накопленной пачки, если новых данных больше нет
+    m_batchTimer = new QTimer(m_ioContext);
+    m_batchTimer->setSingleShot(true);
+    QObject::connect(m_batchTimer, &QTimer::timeout, m_ioContext, [this]() { flushBatch(); });
+    m_batchClock.start();
+    
+    // Публикация статистики с фиксированным периодом, а не на каждую пачку кадров
     m_statsTimer = new QTimer(this);
     QObject::connect(m_statsTimer, &QTimer::timeout, this, &CANInterface::updateStatistics);
-    m_statsTimer->start(1000); // Обновление каждую секунду
+    m_statsTimer->start(DEFAULT_STATISTICS_INTERVAL);
     
     // Инициализация статистики
     resetStatistics();
+    
+    setAcquisitionThreadEnabled(true);
 }
 
 CANInterface::~CANInterface()
 {
-    disconnect();
+    if (isAcquisitionThreadEnabled()) {
+        QMetaObject::invokeMethod(m_ioContext, [this]() { closeDevice(); }, Qt::BlockingQueuedConnection);
+        m_acquisitionThread.quit();
+        m_acquisitionThread.wait();
+    } else {
+        closeDevice();
+    }
+    m_recorder->stop();
+    m_recorder->waitForFinished();
+    delete m_ioContext;
 }
 
 bool CANInterface::connect(const QString &portDisplayName, int baudRateKbps)
 {
-    if (!m_serialPort) {
-        emit errorOccurred("Ошибка: серийный порт не инициализирован");
-        return false;
-    }
-    
-    if (portDisplayName.isEmpty()) {
-        emit errorOccurred("Ошибка: имя порта не указано");
-        return false;
-    }
-    
-    if (m_connected) {
-        disconnect();
-    }
-    
-    // Извлекаем реальное имя порта из строки с описанием
-    // Формат: "ttyUSB0 (FTDI Serial Converter)" -> "ttyUSB0"
-    // Или: "COM3 - USB Serial Port" -> "COM3"
-    QString portName = portDisplayName.trimmed();
-    int spaceIndex = portName.indexOf(' ');
-    if (spaceIndex > 0) {
-        portName = portName.left(spaceIndex);
-    }
-    
-    if (portName.isEmpty()) {
-        emit errorOccurred("Ошибка: не удалось извлечь имя порта");
-        return false;
-    }
-    
-    // Проверка доступности порта
-    QSerialPortInfo portInfo(portName);
-    if (portInfo.isNull()) {
-        // Попробуем найти порт по VID/PID если порт не найден по имени
-        const quint16 targetVendorId = 0x20A2;
-        const quint16 targetProductId = 0x0001;
-        
-        bool foundByVidPid = false;
-        const auto allPorts = QSerialPortInfo::availablePorts();
-        for (const QSerialPortInfo &info : allPorts) {
-            if (info.vendorIdentifier() == targetVendorId && 
-                info.productIdentifier() == targetProductId) {
-                portInfo = info;
-                foundByVidPid = true;
-                qDebug() << "Найден адаптер по VID/PID:" << info.portName();
-                break;
-            }
-        }
-        
-        if (!foundByVidPid) {
-            QString errorMsg = QString("Порт %1 не найден в системе.\n\n").arg(portName);
-            errorMsg += "Проверьте:\n";
-            errorMsg += "1. Подключено ли устройство USB (VID:20A2 PID:0001)\n";
-            errorMsg += "2. Установлены ли драйверы для устройства\n";
-            errorMsg += "3. Создается ли виртуальный COM порт при подключении\n";
-            errorMsg += "4. Если устройство не создает COM порт, может потребоваться специальный драйвер или протокол";
-            emit errorOccurred(errorMsg);
-            return false;
-        }
-    }
-    
-    m_serialPort->setPort(portInfo);
-    
-    // Дополнительная диагностика
-    qDebug() << "Подключение к порту:" << portInfo.portName();
-    qDebug() << "VID:" << QString::number(portInfo.vendorIdentifier(), 16);
-    qDebug() << "PID:" << QString::number(portInfo.productIdentifier(), 16);
-    qDebug() << "Описание:" << portInfo.description();
-    qDebug() << "Производитель:" << portInfo.manufacturer();
-    
-    // Scanmatic 2 Pro использует стандартные скорости последовательного порта
-    // Маппинг скоростей CAN на скорости последовательного порта
-    int serialBaudRate = 115200; // По умолчанию
-    switch (baudRateKbps) {
-        case 125:  serialBaudRate = 57600;  break;
-        case 250:  serialBaudRate = 115200; break;
-        case 500:  serialBaudRate = 230400; break;
-        case 1000: serialBaudRate = 460800; break;
-        default:   serialBaudRate = 115200; break;
-    }
-    m_serialPort->setBaudRate(serialBaudRate);
-    m_serialPort->setDataBits(QSerialPort::Data8);
-    m_serialPort->setParity(QSerialPort::NoParity);
-    m_serialPort->setStopBits(QSerialPort::OneStop);
-    m_serialPort->setFlowControl(QSerialPort::NoFlowControl);
-    
     m_currentBaudRate = baudRateKbps;
-    
-    qDebug() << "Попытка открыть порт:" << portName << "со скоростью" << serialBaudRate;
-    
-    if (m_serialPort->open(QIODevice::ReadWrite)) {
-        qDebug() << "Порт успешно открыт";
-        // Очистка буферов порта перед использованием
-        m_serialPort->clear();
-        m_buffer.clear();
-        
-        // Задержка для инициализации устройства после открытия порта
-        // Используем QCoreApplication::processEvents чтобы не блокировать UI
-        QElapsedTimer delayTimer;
-        delayTimer.start();
-        while (delayTimer.elapsed() < 100) {
-            QCoreApplication::processEvents();
-        }
-        
-        // Отправка команды инициализации для Scanmatic 2 Pro
-        // Формат: 0xAA (старт) + 0x01 (команда инициализации) + CAN скорость + 0x55 (конец)
-        QByteArray initCmd;
-        initCmd.append(FRAME_START);
-        initCmd.append(static_cast<quint8>(0x01)); // Команда инициализации
-        // Маппинг скорости CAN на код команды
-        quint8 speedCode = 0x01; // По умолчанию 250
-        switch (baudRateKbps) {
-            case 125:  speedCode = 0x00; break;
-            case 250:  speedCode = 0x01; break;
-            case 500:  speedCode = 0x02; break;
-            case 1000: speedCode = 0x03; break;
-            default:   speedCode = 0x01; break;
-        }
-        initCmd.append(speedCode);
-        initCmd.append(static_cast<quint8>(0x00)); // Резерв
-        initCmd.append(FRAME_END);
-        
-        // Очистка выходного буфера перед отправкой
-        m_serialPort->clear(QSerialPort::Output);
-        
-        qint64 bytesWritten = m_serialPort->write(initCmd);
-        if (bytesWritten != initCmd.size()) {
-            emit errorOccurred(QString("Ошибка записи команды инициализации: записано %1 из %2 байт")
-                              .arg(bytesWritten).arg(initCmd.size()));
-            m_serialPort->close();
-            return false;
+    return activateTransport(m_serialTransport, [&]() {
+        return m_serialTransport->open(portDisplayName, baudRateKbps);
+    });
+}
+
+bool CANInterface::connectUSB(quint16 vendorId, quint16 productId, int baudRateKbps)
+{
+    m_currentBaudRate = baudRateKbps;
+    return activateTransport(m_usbTransport, [&]() {
+        return m_usbTransport->open(vendorId, productId, baudRateKbps);
+    });
+}
+
+bool CANInterface::connectSocketCan(const QString &interfaceName)
+{
+#ifdef Q_OS_LINUX
+    // Скорость задана в ip link и здесь неизвестна: загрузка шины не считается
+    m_currentBaudRate = 0;
+    return activateTransport(m_socketCanTransport, [&]() {
+        return m_socketCanTransport->open(interfaceName);
+    });
+#else
+    Q_UNUSED(interfaceName);
+    emit errorOccurred("SocketCAN доступен только в Linux");
+    return false;
+#endif
+}
+
+bool CANInterface::activateTransport(ICanTransport *transport, const std::function<bool()> &open)
+{
+    return runInAcquisitionThread([&]() {
+        if (m_connected) {
+            closeDevice();
         }
         
-        // Увеличенный таймаут для инициализации (5 секунд)
-        if (!m_serialPort->waitForBytesWritten(5000)) {
-            emit errorOccurred("Таймаут при инициализации адаптера. Проверьте подключение устройства.");
-            m_serialPort->close();
+        if (!open()) {
+            emit errorOccurred(transport->errorString());
             return false;
         }
         
-        // Дополнительная задержка после отправки команды инициализации
-        // Используем QCoreApplication::processEvents чтобы не блокировать UI
-        QElapsedTimer delayTimer2;
-        delayTimer2.start();
-        while (delayTimer2.elapsed() < 200) {
-            QCoreApplication::processEvents();
-        }
-        
-        // Очистка входного буфера после инициализации
-        m_serialPort->clear(QSerialPort::Input);
-        
+        m_transport = transport;
         m_connected = true;
+        pushDownFilters();
+        m_idStats.clear();
         resetStatistics();
         emit connectionStatusChanged(true);
-        qDebug() << "Подключение к адаптеру установлено успешно";
+        qDebug() << "Подключение установлено:" << transport->name();
         return true;
-    } else {
-        QString errorMsg = QString("Не удалось открыть порт %1: %2")
-                          .arg(portName)
-                          .arg(m_serialPort->errorString());
-        
-        // Дополнительная диагностика
-        if (m_serialPort->error() == QSerialPort::PermissionError) {
-            errorMsg += "\nВозможно, недостаточно прав доступа. Попробуйте запустить с правами администратора или добавить пользователя в группу dialout (Linux).";
-        } else if (m_serialPort->error() == QSerialPort::DeviceNotFoundError) {
-            errorMsg += QString("\nУстройство не найдено. Проверьте:\n"
-                              "- Подключено ли устройство USB (VID:20A2 PID:0001)\n"
-                              "- Установлены ли драйверы\n"
-                              "- Определяется ли порт в системе (lsusb / dmesg на Linux)");
-        } else if (m_serialPort->error() == QSerialPort::OpenError) {
-            errorMsg += "\nПорт уже открыт другим приложением.";
-        }
-        
-        emit errorOccurred(errorMsg);
-        qDebug() << "Ошибка открытия порта:" << errorMsg;
-        return false;
-    }
+    });
 }
 
-bool CANInterface::connectUSB(quint16 vendorId, quint16 productId, int baudRateKbps)
+void CANInterface::disconnect()
 {
-    if (!m_usbDevice) {
-        emit errorOccurred("USB устройство не инициализировано");
-        return false;
-    }
-    
-    if (m_connected) {
-        disconnect();
-    }
-    
-    m_currentBaudRate = baudRateKbps;
-    
-    qDebug() << "Попытка подключения к USB устройству VID:" << QString::number(vendorId, 16) 
-             << "PID:" << QString::number(productId, 16);
-    
-    if (!m_usbDevice->open(vendorId, productId)) {
-        emit errorOccurred(QString("Не удалось открыть USB устройство: %1").arg(m_usbDevice->errorString()));
-        return false;
-    }
-    
-    // Очистка буфера
-    m_buffer.clear();
-    
-    // Задержка для инициализации устройства
-    QElapsedTimer delayTimer;
-    delayTimer.start();
-    while (delayTimer.elapsed() < 100) {
-        QCoreApplication::processEvents();
-    }
-    
-    // Отправка команды инициализации для адаптера
-    // Формат: 0xAA (старт) + 0x01 (команда инициализации) + CAN скорость + 0x55 (конец)
-    QByteArray initCmd;
-    initCmd.append(FRAME_START);
-    initCmd.append(static_cast<quint8>(0x01)); // Команда инициализации
-    // Маппинг скорости CAN на код команды
-    quint8 speedCode = 0x01; // По умолчанию 250
-    switch (baudRateKbps) {
-        case 125:  speedCode = 0x00; break;
-        case 250:  speedCode = 0x01; break;
-        case 500:  speedCode = 0x02; break;
-        case 1000: speedCode = 0x03; break;
-        default:   speedCode = 0x01; break;
-    }
-    initCmd.append(speedCode);
-    initCmd.append(static_cast<quint8>(0x00)); // Резерв
-    initCmd.append(FRAME_END);
-    
-    if (!m_usbDevice->write(initCmd)) {
-        emit errorOccurred(QString("Ошибка записи команды инициализации: %1").arg(m_usbDevice->errorString()));
-        m_usbDevice->close();
-        return false;
-    }
-    
-    // Дополнительная задержка после отправки команды инициализации
-    QElapsedTimer delayTimer2;
-    delayTimer2.start();
-    while (delayTimer2.elapsed() < 200) {
-        QCoreApplication::processEvents();
-    }
-    
-    m_connected = true;
-    m_useUSB = true;
-    resetStatistics();
-    emit connectionStatusChanged(true);
-    qDebug() << "Подключение к USB адаптеру установлено успешно";
-    return true;
+    runInAcquisitionThread([this]() {
+        closeDevice();
+        return true;
+    });
 }
 
-void CANInterface::disconnect()
+void CANInterface::closeDevice()
 {
-    if (m_useUSB) {
-        if (m_usbDevice) {
-            m_usbDevice->close();
-        }
-    } else {
-        if (m_serialPort && m_serialPort->isOpen()) {
-            m_serialPort->close();
-        }
+    ICanTransport *transport = m_transport.exchange(nullptr);
+    if (transport) {
+        transport->close();
     }
     m_connected = false;
-    m_useUSB = false;
-    m_buffer.clear();
+    m_txRetryTimer->stop();
+    m_txQueue.clear();
+    flushBatch();
     emit connectionStatusChanged(false);
 }
 
 bool CANInterface::isConnected() const
 {
-    if (m_useUSB) {
-        return m_connected && m_usbDevice && m_usbDevice->isOpen();
-    } else {
-        return m_connected && m_serialPort->isOpen();
-    }
+    const ICanTransport *transport = m_transport;
+    return m_connected && transport && transport->isOpen();
 }
 
-bool CANInterface::sendMessage(quint32 canId, const QByteArray &data)
+bool CANInterface::sendMessage(quint32 canId, const QByteArray &data,
+                               TransmitPriority priority, const TransmitCallbackPtr &callback)
 {
     if (!isConnected()) {
         emit errorOccurred("Адаптер не подключен");
@@ -323,90 +191,137 @@ bool CANInterface::sendMessage(quint32 canId, const QByteArray &data)
     // Валидация CAN ID (стандартный 11 бит или расширенный 29 бит)
     if (canId > 0x1FFFFFFF) {
         emit errorOccurred(QString("Неверный CAN ID: 0x%1 (максимум 29 бит)").arg(canId, 0, 16));
-        m_stats.errorsCount++;
+        countErrors();
         return false;
     }
     
     if (data.size() > 8) {
         emit errorOccurred(QString("CAN сообщение не может содержать более 8 байт (получено: %1)").arg(data.size()));
-        m_stats.errorsCount++;
+        countErrors();
         return false;
     }
     
-    QByteArray frame = buildCanFrame(canId, data);
-    if (frame.isEmpty()) {
-        emit errorOccurred("Ошибка построения CAN кадра");
-        m_stats.errorsCount++;
+    // Запись выполняется в потоке сбора, вызывающий поток не ждет устройство
+    const CanFrame frame = CanFrame::make(canId, data, CanClock::nowNs(), CanFrame::FLAG_TX);
+    if (!m_txQueue.enqueue(frame, priority, callback)) {
+        emit errorOccurred(QString("Очередь передачи переполнена (%1 кадров)").arg(m_txQueue.pending()));
+        countErrors();
         return false;
     }
+    scheduleTransmit();
+    return true;
+}
+
+int CANInterface::sendFrames(const CanFrame *frames, int count, TransmitPriority priority,
+                             const TransmitCallbackPtr &callback)
+{
+    if (!isConnected()) {
+        return 0;
+    }
     
-    // Отправка через USB или Serial
-    bool success = false;
-    
-    if (m_useUSB) {
-        if (!m_usbDevice || !m_usbDevice->isOpen()) {
-            emit errorOccurred("USB устройство не открыто");
-            m_stats.errorsCount++;
-            return false;
+    int queued = 0;
+    for (int i = 0; i < count; ++i) {
+        CanFrame frame = frames[i];
+        if (frame.id > 0x1FFFFFFF || frame.dlc > 8) {
+            continue;
         }
-        
-        success = m_usbDevice->write(frame);
-        if (!success) {
-            emit errorOccurred(QString("Ошибка записи в USB: %1").arg(m_usbDevice->errorString()));
-            m_stats.errorsCount++;
-            return false;
+        frame.flags |= CanFrame::FLAG_TX;
+        if (m_txQueue.enqueue(frame, priority, callback)) {
+            ++queued;
         }
-    } else {
-        if (!m_serialPort) {
-            emit errorOccurred("Ошибка: серийный порт не инициализирован");
-            m_stats.errorsCount++;
-            return false;
+    }
+    
+    if (queued < count) {
+        countErrors(count - queued);
+    }
+    if (queued > 0) {
+        scheduleTransmit();
+    }
+    return queued;
+}
+
+void CANInterface::scheduleTransmit()
+{
+    // Одна запись в очереди событий на любое количество поставленных кадров
+    if (m_txFlushPending.exchange(true)) {
+        return;
+    }
+    
+    QMetaObject::invokeMethod(m_ioContext, [this]() {
+        m_txFlushPending = false;
+        flushTransmitQueue();
+    }, Qt::QueuedConnection);
+}
+
+void CANInterface::flushTransmitQueue()
+{
+    ICanTransport *transport = m_transport;
+    if (!transport || !transport->isOpen()) {
+        m_txQueue.clear();
+        return;
+    }
+    
+    bool transportBusy = false;
+    while (true) {
+        // Кадры забираются в порядке приоритета и арбитража, см. TransmitQueue
+        const quint64 now = CanClock::nowNs();
+        m_txBatch.clear();
+        const int count = m_txQueue.take(m_txBatch, MAX_TX_BATCH, now);
+        if (count == 0) {
+            break;
         }
         
-        if (!m_serialPort->isOpen()) {
-            emit errorOccurred("Порт не открыт");
-            m_stats.errorsCount++;
-            return false;
+        // Все кадры пачки уходят одной записью, метка времени - момент записи
+        m_txFrames.resize(count);
+        for (int i = 0; i < count; ++i) {
+            m_txFrames[i] = m_txBatch[i].frame;
+            m_txFrames[i].timestampNs = now;
         }
         
-        qint64 bytesWritten = m_serialPort->write(frame);
-        
-        if (bytesWritten == frame.size()) {
-            // Увеличенный таймаут для записи (3 секунды вместо 1)
-            int writeTimeout = qMax(m_writeTimeout, 3000);
-            success = m_serialPort->waitForBytesWritten(writeTimeout);
-            if (!success) {
-                QString errorMsg = QString("Таймаут при записи в порт: %1").arg(m_serialPort->errorString());
-                emit errorOccurred(errorMsg);
-                m_stats.errorsCount++;
-                
-                // Проверка, не отключилось ли устройство
-                if (m_serialPort->error() == QSerialPort::ResourceError) {
-                    disconnect();
+        const int written = transport->writeBatch(m_txFrames.constData(), count);
+        if (written < 0) {
+            // Ошибка устройства: пачка и остаток очереди считаются неотправленными
+            emit errorOccurred(transport->errorString());
+            countErrors(count);
+            m_txQueue.reportFailed(count);
+            for (const TransmitRequest &request : m_txBatch) {
+                if (request.callback) {
+                    (*request.callback)(false, request.frame);
                 }
-                return false;
             }
-        } else {
-            emit errorOccurred(QString("Ошибка записи в порт: записано %1 из %2 байт. Ошибка: %3")
-                              .arg(bytesWritten).arg(frame.size()).arg(m_serialPort->errorString()));
-            m_stats.errorsCount++;
-            return false;
+            m_txQueue.clear();
+            break;
         }
-    }
-    
-    if (success) {
-        // Обновление статистики
-        m_stats.messagesSent++;
-        m_stats.messagesPerId[canId]++;
-        if (m_stats.firstMessageTime.isNull()) {
-            m_stats.firstMessageTime = QDateTime::currentDateTime();
+        
+        countFrames(m_sentCount, written, now, now);
+        for (int i = 0; i < written; ++i) {
+            m_idStats.record(m_txFrames[i]);
+        }
+        m_recorder->append(m_txFrames.constData(), written);
+        m_txQueue.reportSent(written);
+        for (int i = 0; i < written; ++i) {
+            if (m_txBatch[i].callback) {
+                (*m_txBatch[i].callback)(true, m_txBatch[i].frame);
+            }
+        }
+        
+        if (written < count) {
+            // Транспорт занят (очередь ядра или буфер порта заполнены, NAK USB):
+            // остаток отправится позже
+            m_txQueue.requeue(m_txBatch.constData() + written, count - written);
+            m_txRetryTimer->start(TX_RETRY_INTERVAL);
+            transportBusy = true;
+            break;
         }
-        m_stats.lastMessageTime = QDateTime::currentDateTime();
-        emit statisticsUpdated();
-        return true;
     }
     
-    return false;
+    // Остались только кадры, ждущие окна ограничения частоты
+    const quint64 releaseNs = m_txQueue.nextReleaseNs();
+    if (!transportBusy && releaseNs != 0) {
+        const quint64 now = CanClock::nowNs();
+        const quint64 delayMs = releaseNs > now ? (releaseNs - now + 999999) / 1000000 : 0;
+        m_txRetryTimer->start(static_cast<int>(qMax<quint64>(delayMs, TX_RETRY_INTERVAL)));
+    }
 }
 
 QStringList CANInterface::getAvailablePorts() const
@@ -427,6 +342,19 @@ QStringList CANInterface::getAvailablePorts() const
     ports.append("USB (прямое подключение VID:20A2 PID:0001)");
     foundTargetDevice = true; // Предполагаем что USB доступен
     
+#ifdef Q_OS_LINUX
+    // Интерфейсы SocketCAN (can0, vcan0 и т.д.)
+    const QStringList canInterfaces = SocketCanTransport::availableInterfaces();
+    for (const QString &interfaceName : canInterfaces) {
+        ports.append(QString("%1%2").arg(SOCKETCAN_PORT_PREFIX, interfaceName));
+    }
+    
+    // Псевдотерминал симулятора не попадает в список последовательных портов
+    if (QFileInfo::exists(SIMULATOR_PORT)) {
+        ports.append(QString("%1 (симулятор Scanmatic)").arg(SIMULATOR_PORT));
+    }
+#endif
+    
     for (const QSerialPortInfo &portInfo : portInfos) {
         QString portName = portInfo.portName();
         QString description = portInfo.description();
@@ -502,54 +430,293 @@ void CANInterface::refreshPortList()
 
 void CANInterface::setFilterEnabled(bool enabled)
 {
-    m_filterEnabled = enabled;
+    {
+        QWriteLocker locker(&m_filterLock);
+        m_filterEnabled = enabled;
+    }
+    rebuildFilter();
 }
 
 void CANInterface::addFilterId(quint32 id, bool allow)
 {
-    m_filterIds[id] = allow;
+    addFilterRule(FilterRule::exact(id, allow));
+}
+
+void CANInterface::addFilterMask(quint32 code, quint32 mask, bool allow)
+{
+    addFilterRule(FilterRule::mask(code, mask, allow));
+}
+
+void CANInterface::addFilterRange(quint32 firstId, quint32 lastId, bool allow)
+{
+    addFilterRule(FilterRule::range(qMin(firstId, lastId), qMax(firstId, lastId), allow));
+}
+
+void CANInterface::addFilterRule(const FilterRule &rule)
+{
+    {
+        QWriteLocker locker(&m_filterLock);
+        // Новое правило для того же ID заменяет прежнее
+        if (rule.kind == FilterRule::ExactId) {
+            m_filterRules.removeIf([&rule](const FilterRule &existing) {
+                return existing.kind == FilterRule::ExactId && existing.first == rule.first;
+            });
+        }
+        m_filterRules.append(rule);
+    }
+    rebuildFilter();
 }
 
 void CANInterface::clearFilters()
 {
-    m_filterIds.clear();
+    {
+        QWriteLocker locker(&m_filterLock);
+        m_filterRules.clear();
+    }
+    rebuildFilter();
 }
 
-bool CANInterface::isMessageFiltered(quint32 id) const
+QVector<FilterRule> CANInterface::filterRules() const
+{
+    QReadLocker locker(&m_filterLock);
+    return m_filterRules;
+}
+
+QVector<quint64> CANInterface::filterRuleHits() const
+{
+    const QVector<FilterRule> rules = filterRules();
+    QVector<quint64> hits(rules.size(), 0);
+    std::shared_ptr<FilterEngine> engine = std::atomic_load(&m_filterEngine);
+    if (engine) {
+        for (int i = 0; i < rules.size(); ++i) {
+            const int index = engine->rules().indexOf(rules[i]);
+            if (index >= 0) {
+                hits[i] = engine->hits(index);
+            }
+        }
+    }
+    return hits;
+}
+
+bool CANInterface::setFilterExpression(const QString &expression, QString *error)
+{
+    std::shared_ptr<FilterExpression> compiled;
+    if (!expression.trimmed().isEmpty()) {
+        compiled = std::make_shared<FilterExpression>();
+        if (!compiled->compile(expression)) {
+            if (error) {
+                *error = QString("%1 (позиция %2)").arg(compiled->errorString()).arg(compiled->errorPosition() + 1);
+            }
+            return false;
+        }
+    }
+    
+    {
+        QWriteLocker locker(&m_filterLock);
+        m_filterExpression = compiled;
+    }
+    rebuildFilter();
+    return true;
+}
+
+QString CANInterface::filterExpression() const
+{
+    QReadLocker locker(&m_filterLock);
+    return m_filterExpression ? m_filterExpression->expression() : QString();
+}
+
+void CANInterface::rebuildFilter()
 {
-    if (!m_filterEnabled) {
-        return false; // Фильтр отключен, пропускаем все
+    // Правила компилируются в вызывающем потоке, в поток сбора уходит готовый набор
+    std::shared_ptr<FilterEngine> engine;
+    std::shared_ptr<const FilterExpression> expression;
+    {
+        QReadLocker locker(&m_filterLock);
+        if (m_filterEnabled) {
+            engine = std::make_shared<FilterEngine>(m_filterRules);
+            expression = m_filterExpression;
+        }
     }
     
-    if (m_filterIds.contains(id)) {
-        return !m_filterIds[id]; // Если в списке и false - фильтруем
+    std::shared_ptr<FilterEngine> previous = std::atomic_load(&m_filterEngine);
+    if (engine && previous) {
+        engine->inheritHits(*previous);
     }
     
-    // Если ID нет в списке, пропускаем (можно изменить логику)
-    return false;
+    QMetaObject::invokeMethod(m_ioContext, [this, engine, expression]() {
+        installFilter(engine, expression);
+        pushDownFilters();
+    }, Qt::QueuedConnection);
+}
+
+void CANInterface::installFilter(const std::shared_ptr<FilterEngine> &engine,
+                                 const std::shared_ptr<const FilterExpression> &expression)
+{
+    // Транспорты проверяют фильтр только в этом потоке, поэтому прежний
+    // набор освобождается без ожидания, как только его не держат читатели счетчиков
+    for (ICanTransport *transport : m_transports) {
+        transport->setFilter(engine.get());
+    }
+    std::atomic_store(&m_filterEngine, engine);
+    m_activeExpression = expression;
+}
+
+void CANInterface::pushDownFilters()
+{
+    // Правила по ID переносятся в устройство или ядро, насколько их выражают
+    // фильтры приема транспорта: лишние кадры не передаются по линии и не
+    // разбираются. Набор правил в транспорте по-прежнему проверяет каждый
+    // кадр, поэтому частичный перенос не меняет результат.
+    ICanTransport *transport = m_transport;
+    if (!transport || !transport->isOpen() || transport->maxAcceptanceFilters() <= 0) {
+        return;
+    }
+    
+    AcceptanceFilters filters;
+    std::shared_ptr<FilterEngine> engine = std::atomic_load(&m_filterEngine);
+    if (engine) {
+        filters = engine->acceptanceFilters(transport->maxAcceptanceFilters());
+    }
+    
+    if (!transport->setAcceptanceFilters(filters)) {
+        qDebug() << "Фильтры приема не установлены в" << transport->name() << "- фильтрация в приложении";
+    } else if (filters.mode != AcceptanceFilters::AcceptAll) {
+        qDebug() << "Фильтры приема в" << transport->name() << ":" << filters.masks.size()
+                 << (filters.mode == AcceptanceFilters::AcceptMatching ? "разрешающих" : "запрещающих");
+    }
+}
+
+bool CANInterface::isMessageFiltered(quint32 id) const
+{
+    std::shared_ptr<FilterEngine> engine = std::atomic_load(&m_filterEngine);
+    return engine && !engine->decide(id);
 }
 
 Statistics CANInterface::getStatistics() const
 {
+    QMutexLocker locker(&m_statsMutex);
     return m_stats;
 }
 
 void CANInterface::resetStatistics()
 {
-    m_stats.messagesSent = 0;
-    m_stats.messagesReceived = 0;
-    m_stats.errorsCount = 0;
-    m_stats.firstMessageTime = QDateTime();
-    m_stats.lastMessageTime = QDateTime();
-    m_stats.messagesPerId.clear();
-    m_lastSecondMessages = 0;
-    m_lastSecondTime = QDateTime::currentDateTime();
+    m_sentCount.store(0, std::memory_order_relaxed);
+    m_receivedCount.store(0, std::memory_order_relaxed);
+    m_errorCount.store(0, std::memory_order_relaxed);
+    m_firstMessageNs.store(0, std::memory_order_relaxed);
+    m_lastMessageNs.store(0, std::memory_order_relaxed);
+    m_idStats.reset();
+    m_rateResetPending.store(true);
+    {
+        QMutexLocker locker(&m_statsMutex);
+        m_stats = Statistics();
+        m_idSnapshot.clear();
+        m_messagesPerSecond = 0;
+        m_busLoad = 0;
+    }
+    m_txQueue.resetStatistics();
     emit statisticsUpdated();
 }
 
+void CANInterface::setStatisticsInterval(int milliseconds)
+{
+    QMetaObject::invokeMethod(m_statsTimer, [this, milliseconds]() {
+        m_statsTimer->setInterval(qMax(1, milliseconds));
+    });
+}
+
+int CANInterface::statisticsInterval() const
+{
+    return m_statsTimer->interval();
+}
+
 quint64 CANInterface::getMessagesPerSecond() const
 {
-    return m_lastSecondMessages;
+    QMutexLocker locker(&m_statsMutex);
+    return static_cast<quint64>(qRound64(m_messagesPerSecond));
+}
+
+double CANInterface::getBusLoad() const
+{
+    QMutexLocker locker(&m_statsMutex);
+    return m_busLoad;
+}
+
+QVector<IdStatistics> CANInterface::idStatistics() const
+{
+    QMutexLocker locker(&m_statsMutex);
+    return m_idSnapshot;
+}
+
+void CANInterface::latestIdStatistics(QVector<IdStatistics> &result) const
+{
+    m_idStats.snapshot(result);
+}
+
+TransmitStatistics CANInterface::getTransmitStatistics() const
+{
+    return m_txQueue.statistics();
+}
+
+bool CANInterface::startRecording(const FrameRecorder::Config &config)
+{
+    FrameRecorder::Config recorderConfig = config;
+    if (recorderConfig.bitrateKbps == 0) {
+        recorderConfig.bitrateKbps = m_currentBaudRate;
+    }
+    if (!m_recorder->start(recorderConfig)) {
+        emit errorOccurred(m_recorder->errorString());
+        return false;
+    }
+    return true;
+}
+
+void CANInterface::stopRecording()
+{
+    m_recorder->stop();
+}
+
+bool CANInterface::isRecording() const
+{
+    return m_recorder->isRecording();
+}
+
+bool CANInterface::isRecordingFinishing() const
+{
+    return m_recorder->isFinishing();
+}
+
+FrameRecorder::Statistics CANInterface::recordingStatistics() const
+{
+    return m_recorder->statistics();
+}
+
+void CANInterface::setTransmitRateLimit(quint32 canId, int framesPerSecond)
+{
+    m_txQueue.setRateLimit(canId, framesPerSecond);
+    scheduleTransmit();
+}
+
+void CANInterface::clearTransmitRateLimits()
+{
+    m_txQueue.clearRateLimits();
+    scheduleTransmit();
+}
+
+void CANInterface::countErrors(quint64 count)
+{
+    m_errorCount.fetch_add(count, std::memory_order_relaxed);
+}
+
+void CANInterface::countFrames(std::atomic<quint64> &counter, quint64 count, quint64 firstNs, quint64 lastNs)
+{
+    if (count == 0) {
+        return;
+    }
+    counter.fetch_add(count, std::memory_order_relaxed);
+    quint64 expected = 0;
+    m_firstMessageNs.compare_exchange_strong(expected, firstNs, std::memory_order_relaxed);
+    m_lastMessageNs.store(lastNs, std::memory_order_relaxed);
 }
 
 void CANInterface::setReadTimeout(int milliseconds)
@@ -560,219 +727,241 @@ void CANInterface::setReadTimeout(int milliseconds)
 void CANInterface::setWriteTimeout(int milliseconds)
 {
     m_writeTimeout = milliseconds;
+    m_serialTransport->setWriteTimeout(milliseconds);
 }
 
 void CANInterface::setMaxBufferSize(int size)
 {
-    m_maxBufferSize = qMax(1024, size); // Минимум 1KB
+    // Вступает в силу при следующем подключении
+    m_serialTransport->setBufferSize(size);
+    m_usbTransport->setBufferSize(size);
 }
 
-void CANInterface::updateStatistics()
+void CANInterface::setBatchInterval(int milliseconds)
 {
-    QDateTime now = QDateTime::currentDateTime();
-    if (m_lastSecondTime.isValid()) {
-        qint64 elapsed = m_lastSecondTime.msecsTo(now);
-        if (elapsed >= 1000) {
-            m_lastSecondMessages = 0;
-            m_lastSecondTime = now;
-        }
-    } else {
-        m_lastSecondTime = now;
-    }
+    m_batchInterval = qMax(0, milliseconds);
 }
 
-bool CANInterface::validateFrame(const QByteArray &frame) const
+void CANInterface::setUSBReceiveBuffers(int transferCount, int transferSize)
 {
-    if (frame.size() < 8) return false; // Минимальный размер кадра
-    if (static_cast<quint8>(frame[0]) != FRAME_START) return false;
-    if (static_cast<quint8>(frame[frame.size() - 1]) != FRAME_END) return false;
-    return true;
+    // Вступает в силу при следующем connectUSB()
+    m_usbTransport->usbDevice()->setTransferCount(transferCount);
+    m_usbTransport->usbDevice()->setTransferSize(transferSize);
 }
 
-void CANInterface::onDataReceived()
+void CANInterface::setUSBBackend(std::unique_ptr<UsbBackend> backend)
 {
-    if (!m_serialPort || !m_serialPort->isOpen()) {
+    // Вступает в силу при следующем connectUSB()
+    if (m_transport == m_usbTransport) {
+        disconnect();
+    }
+    m_usbTransport->usbDevice()->setBackend(std::move(backend));
+}
+
+void CANInterface::setAcquisitionThreadEnabled(bool enabled)
+{
+    if (enabled == isAcquisitionThreadEnabled()) {
         return;
     }
     
-    QByteArray data = m_serialPort->readAll();
-    if (data.isEmpty()) {
-        return;
+    if (m_connected) {
+        disconnect();
     }
     
-    // Защита от переполнения буфера
-    if (m_buffer.size() + data.size() > m_maxBufferSize) {
-        emit errorOccurred(QString("Переполнение буфера! Очистка. Размер: %1 байт").arg(m_buffer.size()));
-        m_buffer.clear();
-        m_stats.errorsCount++;
+    if (enabled) {
+        m_acquisitionThread.start(QThread::HighPriority);
+        m_ioContext->moveToThread(&m_acquisitionThread);
+    } else {
+        // moveToThread() вызывается из потока, которому объект принадлежит
+        QThread *guiThread = thread();
+        QMetaObject::invokeMethod(m_ioContext, [this, guiThread]() {
+            m_ioContext->moveToThread(guiThread);
+        }, Qt::BlockingQueuedConnection);
+        m_acquisitionThread.quit();
+        m_acquisitionThread.wait();
+    }
+}
+
+bool CANInterface::isAcquisitionThreadEnabled() const
+{
+    return m_acquisitionThread.isRunning();
+}
+
+FrameConsumer *CANInterface::createConsumer(const QString &name, int capacity)
+{
+    FrameConsumer *consumer = new FrameConsumer(name, capacity, this);
+    QMutexLocker locker(&m_consumersMutex);
+    m_consumers.append(consumer);
+    return consumer;
+}
+
+void CANInterface::removeConsumer(FrameConsumer *consumer)
+{
+    {
+        // После снятия блокировки поток сбора больше не обращается к очереди
+        QMutexLocker locker(&m_consumersMutex);
+        m_consumers.removeAll(consumer);
+    }
+    delete consumer;
+}
+
+void CANInterface::deliverToConsumers(const QVector<CanFrame> &frames)
+{
+    QMutexLocker locker(&m_consumersMutex);
+    for (FrameConsumer *consumer : m_consumers) {
+        for (const CanFrame &frame : frames) {
+            consumer->push(frame);
+        }
+        consumer->notify();
+    }
+}
+
+bool CANInterface::runInAcquisitionThread(const std::function<bool()> &function)
+{
+    if (QThread::currentThread() == m_ioContext->thread()) {
+        return function();
+    }
+    
+    // Вызывающий поток блокируется, как в деструкторе. Вложенный цикл событий
+    // здесь недопустим: такт UI, нажатия кнопок и закрытие окна вошли бы
+    // в CANInterface повторно посреди переключения транспорта. Сигналы из
+    // потока сбора доставляются в очередь и обрабатываются после возврата.
+    bool result = false;
+    QMetaObject::invokeMethod(m_ioContext, [&]() {
+        result = function();
+    }, Qt::BlockingQueuedConnection);
+    return result;
+}
+
+void CANInterface::updateStatistics()
+{
+    // Снимок и расчет скоростей вне блокировки: таблица по ID без блокировок,
+    // оценщик используется только здесь
+    const quint64 now = CanClock::nowNs();
+    const quint64 totalFrames = m_idStats.totalFrames();
+    const quint64 totalBits = m_idStats.totalBits();
+    QVector<IdStatistics> idSnapshot = m_idStats.snapshot();
+    if (m_rateResetPending.exchange(false)) {
+        m_rateEstimator.reset();
+    }
+    m_rateEstimator.setBitRate(m_currentBaudRate);
+    m_rateEstimator.update(now, totalFrames, totalBits, idSnapshot);
+    
+    Statistics stats;
+    stats.messagesSent = m_sentCount.load(std::memory_order_relaxed);
+    stats.messagesReceived = m_receivedCount.load(std::memory_order_relaxed);
+    stats.errorsCount = m_errorCount.load(std::memory_order_relaxed);
+    stats.firstMessageTimeNs = m_firstMessageNs.load(std::memory_order_relaxed);
+    stats.lastMessageTimeNs = m_lastMessageNs.load(std::memory_order_relaxed);
+    
+    bool changed;
+    {
+        QMutexLocker locker(&m_statsMutex);
+        changed = stats.messagesSent != m_stats.messagesSent
+                  || stats.messagesReceived != m_stats.messagesReceived
+                  || stats.errorsCount != m_stats.errorsCount
+                  || m_rateEstimator.framesPerSecond() != m_messagesPerSecond
+                  || m_rateEstimator.busLoadPercent() != m_busLoad;
+        m_stats = stats;
+        m_idSnapshot = std::move(idSnapshot);
+        m_messagesPerSecond = m_rateEstimator.framesPerSecond();
+        m_busLoad = m_rateEstimator.busLoadPercent();
+    }
+    
+    // Без трафика подписчики не будят GUI
+    if (changed) {
         emit statisticsUpdated();
     }
-    
-    m_buffer.append(data);
-    parseReceivedData(m_buffer);
 }
 
-void CANInterface::parseReceivedData(QByteArray &buffer)
+void CANInterface::onFramesReceived(const CanFrame *frames, int count, quint64 lostFrames)
 {
-    // Парсинг протокола Scanmatic 2 Pro
-    // Формат кадра: 0xAA (старт) + тип (0x02 для CAN данных) + длина + CAN ID (4 байта) + данные (до 8 байт) + 0x55 (конец)
-    
-    if (buffer.isEmpty()) {
+    if (!m_connected) {
         return;
     }
     
-    while (buffer.size() >= 3) {
-        int startIndex = buffer.indexOf(FRAME_START);
-        if (startIndex == -1) {
-            buffer.clear();
-            break;
-        }
-        
-        if (startIndex > 0) {
-            buffer.remove(0, startIndex);
-        }
-        
-        if (buffer.size() < 3) {
-            break;
-        }
-        
-        quint8 frameType = static_cast<quint8>(buffer[1]);
-        quint8 dataLength = static_cast<quint8>(buffer[2]);
-        
-        // Минимальный размер кадра: старт (1) + тип (1) + длина (1) + CAN ID (4) + данные (0-8) + конец (1)
-        int minFrameSize = 3 + 4 + 1; // минимум с CAN ID и концом
-        int maxFrameSize = 3 + 4 + 8 + 1; // максимум с 8 байтами данных
-        
-        if (frameType == 0x02 && dataLength <= 8) { // CAN данные
-            int expectedFrameSize = 3 + 4 + dataLength + 1; // старт + тип + длина + CAN ID + данные + конец
-            
-            if (buffer.size() < expectedFrameSize) {
-                // Недостаточно данных, ждем еще
-                break;
-            }
-            
-            int endIndex = -1;
-            for (int i = 3 + 4 + dataLength; i < buffer.size(); ++i) {
-                if (static_cast<quint8>(buffer[i]) == FRAME_END) {
-                    endIndex = i;
-                    break;
-                }
-            }
-            
-            if (endIndex == -1) {
-                // Конец кадра не найден, возможно данные еще не пришли
-                if (buffer.size() > maxFrameSize) {
-                    // Слишком много данных без конца кадра, возможно ошибка
-                    buffer.remove(0, 1); // Удаляем первый байт и пробуем снова
-                }
-                break;
-            }
-            
-            // Извлекаем CAN ID (4 байта после длины)
-            quint32 canId = 0;
-            canId |= static_cast<quint32>(static_cast<quint8>(buffer[3])) << 24;
-            canId |= static_cast<quint32>(static_cast<quint8>(buffer[4])) << 16;
-            canId |= static_cast<quint32>(static_cast<quint8>(buffer[5])) << 8;
-            canId |= static_cast<quint32>(static_cast<quint8>(buffer[6]));
-            
-            // Извлекаем данные
-            QByteArray canData = buffer.mid(7, dataLength);
-            
-            // Проверка фильтра
-            if (isMessageFiltered(canId)) {
-                // Сообщение отфильтровано, удаляем из буфера но не обрабатываем
-                buffer.remove(0, endIndex + 1);
-                continue;
-            }
-            
-            // Валидация кадра
-            QByteArray frame = buffer.mid(0, endIndex + 1);
-            if (!validateFrame(frame)) {
-                emit errorOccurred(QString("Получен невалидный кадр для ID 0x%1").arg(canId, 0, 16));
-                m_stats.errorsCount++;
-                buffer.remove(0, 1); // Пропускаем байт
-                continue;
-            }
-            
-            QDateTime timestamp = QDateTime::currentDateTime();
-            
-            // Обновление статистики
-            m_stats.messagesReceived++;
-            m_stats.messagesPerId[canId]++;
-            if (!m_stats.firstMessageTime.isValid()) {
-                m_stats.firstMessageTime = timestamp;
-            }
-            m_stats.lastMessageTime = timestamp;
-            m_lastSecondMessages++;
-            emit statisticsUpdated();
-            
-            QString message = formatCanMessage(canId, canData);
-            emit messageReceived(message);
-            emit messageReceivedDetailed(canId, canData, timestamp);
-            
-            // Удаляем обработанный кадр из буфера
-            buffer.remove(0, endIndex + 1);
-        } else {
-            // Неизвестный тип кадра или ошибка, пропускаем байт
-            buffer.remove(0, 1);
+    // Фильтр по ID уже применен транспортом при декодировании,
+    // выражение по содержимому проверяется до публикации кадров
+    const FilterExpression *expression = m_activeExpression.get();
+    m_received.clear();
+    for (int i = 0; i < count; ++i) {
+        if (!expression || expression->matches(frames[i])) {
+            m_received.append(frames[i]);
         }
     }
+    publishReceived(lostFrames);
 }
 
-QByteArray CANInterface::buildCanFrame(quint32 canId, const QByteArray &data)
+void CANInterface::publishReceived(quint64 lostFrames)
 {
-    QByteArray frame;
+    if (m_received.isEmpty() && lostFrames == 0) {
+        return;
+    }
     
-    frame.append(FRAME_START);                    // Старт кадра
-    frame.append(0x02);                           // Тип: CAN данные
-    frame.append(static_cast<quint8>(data.size())); // Длина данных
+    // Сигналы на каждый кадр испускаются только при наличии получателей
+    if (isSignalConnected(QMetaMethod::fromSignal(&CANInterface::messageReceived))) {
+        for (const CanFrame &frame : m_received) {
+            emit messageReceived(formatCanMessage(frame));
+        }
+    }
+    if (isSignalConnected(QMetaMethod::fromSignal(&CANInterface::messageReceivedDetailed))) {
+        for (const CanFrame &frame : m_received) {
+            emit messageReceivedDetailed(frame);
+        }
+    }
     
-    // CAN ID (4 байта, big-endian)
-    frame.append(static_cast<quint8>((canId >> 24) & 0xFF));
-    frame.append(static_cast<quint8>((canId >> 16) & 0xFF));
-    frame.append(static_cast<quint8>((canId >> 8) & 0xFF));
-    frame.append(static_cast<quint8>(canId & 0xFF));
+    // Только счетчики, публикует их таймер статистики
+    for (const CanFrame &frame : m_received) {
+        m_idStats.record(frame);
+    }
+    if (lostFrames > 0) {
+        countErrors(lostFrames);
+    }
+    if (!m_received.isEmpty()) {
+        m_recorder->append(m_received.constData(), m_received.size());
+        countFrames(m_receivedCount, m_received.size(), m_received.first().timestampNs, m_received.last().timestampNs);
+    }
     
-    // Данные
-    frame.append(data);
+    if (m_received.isEmpty()) {
+        return;
+    }
     
-    frame.append(FRAME_END);                     // Конец кадра
+    // Одна передача потребителям на пачку прочитанных данных
+    deliverToConsumers(m_received);
     
-    return frame;
-}
-
-QString CANInterface::formatCanMessage(quint32 canId, const QByteArray &data)
-{
-    QString dataStr;
-    for (int i = 0; i < data.size(); ++i) {
-        if (i > 0) dataStr += " ";
-        dataStr += QString("%1").arg(static_cast<quint8>(data[i]), 2, 16, QChar('0')).toUpper();
+    // Пакетный сигнал для подписчиков без собственной очереди
+    if (isSignalConnected(QMetaMethod::fromSignal(&CANInterface::framesReceived))) {
+        m_batch += m_received;
+        const int interval = m_batchInterval;
+        const qint64 elapsed = m_batchClock.elapsed();
+        if (interval <= 0 || elapsed >= interval) {
+            flushBatch();
+        } else if (!m_batchTimer->isActive()) {
+            m_batchTimer->start(static_cast<int>(interval - elapsed));
+        }
     }
-    
-    return QString("ID=0x%1, Данные=%2")
-           .arg(canId, 0, 16).arg(dataStr);
 }
 
-void CANInterface::onSerialError(QSerialPort::SerialPortError error)
+void CANInterface::flushBatch()
 {
-    if (error == QSerialPort::ResourceError) {
-        emit errorOccurred("Критическая ошибка порта. Возможно, устройство отключено.");
-        disconnect();
-    } else if (error != QSerialPort::NoError) {
-        emit errorOccurred(QString("Ошибка порта: %1").arg(m_serialPort->errorString()));
+    m_batchTimer->stop();
+    if (m_batch.isEmpty()) {
+        return;
     }
+    
+    emit framesReceived(m_batch);
+    m_batch.clear();
+    m_batchClock.restart();
 }
 
-void CANInterface::onUSBDataReceived(const QByteArray &data)
+QString CANInterface::formatCanMessage(const CanFrame &frame)
 {
-    if (!m_connected || !m_useUSB) {
-        return;
+    QString dataStr;
+    for (int i = 0; i < frame.dlc; ++i) {
+        if (i > 0) dataStr += " ";
+        dataStr += QString("%1").arg(frame.data[i], 2, 16, QChar('0')).toUpper();
     }
     
-    // Добавляем данные в буфер
-    m_buffer.append(data);
-    
-    // Парсим полученные данные
-    parseReceivedData(m_buffer);
+    return QString("ID=0x%1, Данные=%2")
+           .arg(frame.id, 0, 16).arg(dataStr);
 }
-
@@ -0,0 +1,66 @@
+#include "capturetablemodel.h"
+#include "messagetablemodel.h"
+#include <limits>
+
+CaptureTableModel::CaptureTableModel(QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_capture(nullptr)
+    , m_allFrames(true)
+{
+}
+
+void CaptureTableModel::setCapture(const MappedCapture *capture)
+{
+    beginResetModel();
+    m_capture = capture;
+    m_allFrames = true;
+    m_rows.clear();
+    m_rows.squeeze();
+    endResetModel();
+}
+
+void CaptureTableModel::setSelection(const CaptureSelection &selection)
+{
+    beginResetModel();
+    m_allFrames = selection.allIds && !selection.timeRange;
+    m_rows.clear();
+    if (m_capture && !m_allFrames) {
+        m_rows = m_capture->select(selection);
+    }
+    endResetModel();
+}
+
+CanFrame CaptureTableModel::frameAt(int row) const
+{
+    return m_capture->frameAt(m_allFrames ? static_cast<quint32>(row) : m_rows[row]);
+}
+
+int CaptureTableModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid() || !m_capture) {
+        return 0;
+    }
+    if (m_allFrames) {
+        // Строки модели - int: в таблице видны первые 2^31-1 кадров
+        return static_cast<int>(qMin<quint64>(m_capture->frameCount(), std::numeric_limits<int>::max()));
+    }
+    return m_rows.size();
+}
+
+int CaptureTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : MessageTableModel::COLUMN_COUNT;
+}
+
+QVariant CaptureTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rowCount()) {
+        return QVariant();
+    }
+    return MessageTableModel::frameData(frameAt(index.row()), index.column(), role);
+}
+
+QVariant CaptureTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    return MessageTableModel::columnHeader(section, orientation, role);
+}
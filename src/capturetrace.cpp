@@ -0,0 +1,106 @@
+#include "capturetrace.h"
+#include <cstring>
+
+bool CaptureReader::open(const QString &path)
+{
+    close();
+    m_skippedRecords = 0;
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        m_lastError = QString("Не удалось открыть %1: %2").arg(path, m_file.errorString());
+        return false;
+    }
+    
+    if (m_file.read(reinterpret_cast<char*>(&m_header), sizeof(m_header)) != sizeof(m_header)
+        || std::memcmp(m_header.magic, CaptureFileHeader::CAPTURE_MAGIC, sizeof(m_header.magic)) != 0) {
+        m_lastError = QString("%1 не является файлом записи").arg(path);
+        m_file.close();
+        return false;
+    }
+    // Более новые версии могут дописывать поля в конец заголовка и записи
+    if (m_header.recordSize < sizeof(CanFrame) || m_header.headerSize < sizeof(CaptureFileHeader)
+        || !m_file.seek(m_header.headerSize)) {
+        m_lastError = QString("Неподдерживаемый формат записи %1 (версия %2)").arg(path).arg(m_header.version);
+        m_file.close();
+        return false;
+    }
+    return true;
+}
+
+void CaptureReader::close()
+{
+    m_file.close();
+    m_header = CaptureFileHeader();
+}
+
+int CaptureReader::read(CanFrame *frames, int maxCount)
+{
+    if (maxCount <= 0) {
+        return 0;
+    }
+    
+    const int recordSize = static_cast<int>(m_header.recordSize);
+    qint64 bytesRead;
+    if (recordSize == sizeof(CanFrame)) {
+        bytesRead = m_file.read(reinterpret_cast<char*>(frames), static_cast<qint64>(maxCount) * recordSize);
+    } else {
+        m_records.resize(maxCount * recordSize);
+        bytesRead = m_file.read(m_records.data(), m_records.size());
+    }
+    if (bytesRead < 0) {
+        m_lastError = QString("Ошибка чтения: %1").arg(m_file.errorString());
+        return -1;
+    }
+    
+    // Неполная последняя запись - файл, запись в который была прервана
+    const int count = static_cast<int>(bytesRead / recordSize);
+    if (recordSize != sizeof(CanFrame)) {
+        for (int i = 0; i < count; ++i) {
+            std::memcpy(&frames[i], m_records.constData() + i * recordSize, sizeof(CanFrame));
+        }
+    }
+    
+    // Метки CanClock записавшего процесса переводятся в текущие через календарное время
+    const qint64 fileEpochNs = m_header.wallClockMs * 1000000;
+    for (int i = 0; i < count; ++i) {
+        const qint64 offsetNs = static_cast<qint64>(frames[i].timestampNs - m_header.monotonicNs);
+        frames[i].timestampNs = CanClock::fromNsSinceEpoch(fileEpochNs + offsetNs);
+    }
+    return count;
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    close();
+}
+
+bool CaptureWriter::open(const QString &path)
+{
+    if (!m_output.open(path, &m_lastError)) {
+        return false;
+    }
+    
+    CaptureFileHeader header = {};
+    std::memcpy(header.magic, CaptureFileHeader::CAPTURE_MAGIC, sizeof(header.magic));
+    header.version = CaptureFileHeader::CAPTURE_VERSION;
+    header.headerSize = sizeof(CaptureFileHeader);
+    header.recordSize = sizeof(CanFrame);
+    header.monotonicNs = CanClock::nowNs();
+    header.wallClockMs = CanClock::toMSecsSinceEpoch(header.monotonicNs);
+    m_output.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    return true;
+}
+
+bool CaptureWriter::write(const CanFrame *frames, int count)
+{
+    m_output.append(reinterpret_cast<const char*>(frames), count * static_cast<int>(sizeof(CanFrame)));
+    return m_output.flushIfFull(&m_lastError);
+}
+
+bool CaptureWriter::close()
+{
+    if (!m_output.isOpen()) {
+        return true;
+    }
+    return m_output.close(&m_lastError);
+}
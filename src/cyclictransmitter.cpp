@@ -0,0 +1,350 @@
+#include "cyclictransmitter.h"
+#include "caninterface.h"
+#include <QThread>
+#include <QDebug>
+#include <chrono>
+#include <thread>
+
+#ifdef Q_OS_LINUX
+#include <time.h>
+#include <cerrno>
+#endif
+
+namespace {
+
+// Округление до шага колеса, не меньше одного шага
+quint64 roundToTick(quint64 ns)
+{
+    const quint64 ticks = (ns + CyclicTransmitter::TICK_NS / 2) / CyclicTransmitter::TICK_NS;
+    return qMax<quint64>(ticks, 1) * CyclicTransmitter::TICK_NS;
+}
+
+} // namespace
+
+CyclicTransmitter::CyclicTransmitter(CANInterface *canInterface, QObject *parent)
+    : QObject(parent)
+    , m_canInterface(canInterface)
+    , m_thread(nullptr)
+    , m_running(false)
+    , m_stopping(false)
+    , m_startNs(0)
+    , m_currentTick(0)
+    , m_nextHandle(0)
+{
+}
+
+CyclicTransmitter::~CyclicTransmitter()
+{
+    stop();
+}
+
+int CyclicTransmitter::addMessage(quint32 canId, const QByteArray &data, int periodUs, int phaseUs)
+{
+    if (canId > 0x1FFFFFFF || data.size() > 8 || periodUs <= 0 || phaseUs < 0) {
+        return -1;
+    }
+    
+    Message message = {};
+    message.frame = CanFrame::make(canId, data, 0, CanFrame::FLAG_TX);
+    message.periodNs = roundToTick(static_cast<quint64>(periodUs) * 1000);
+    message.phaseNs = (static_cast<quint64>(phaseUs) * 1000 + TICK_NS / 2) / TICK_NS * TICK_NS;
+    message.writeStats = std::make_shared<WriteStats>();
+    message.onWritten = makeWriteCallback(message.writeStats);
+    
+    QMutexLocker locker(&m_mutex);
+    const int handle = m_nextHandle++;
+    Message &stored = m_messages[handle];
+    stored = message;
+    if (m_running) {
+        stored.deadlineNs = firstDeadline(stored, CanClock::nowNs());
+        schedule(handle, stored);
+    }
+    return handle;
+}
+
+void CyclicTransmitter::removeMessage(int handle)
+{
+    // Запись в колесе удаляется при обработке слота
+    QMutexLocker locker(&m_mutex);
+    m_messages.remove(handle);
+}
+
+void CyclicTransmitter::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_messages.clear();
+    for (std::vector<int> &slot : m_wheel) {
+        slot.clear();
+    }
+}
+
+void CyclicTransmitter::setPayload(int handle, const QByteArray &data)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_messages.find(handle);
+    if (it != m_messages.end() && data.size() <= 8) {
+        Message &message = it.value();
+        message.frame = CanFrame::make(message.frame.id, data, 0, CanFrame::FLAG_TX);
+    }
+}
+
+void CyclicTransmitter::addHook(int handle, const PayloadHook &hook)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_messages.find(handle);
+    if (it != m_messages.end() && hook) {
+        it.value().hooks.append(hook);
+    }
+}
+
+void CyclicTransmitter::start()
+{
+    if (m_running) {
+        return;
+    }
+    
+    {
+        // Фазы всех сообщений отсчитываются от одной границы шага
+        QMutexLocker locker(&m_mutex);
+        const quint64 now = CanClock::nowNs();
+        m_startNs = (now + ADD_LEAD_NS) / TICK_NS * TICK_NS;
+        m_currentTick = now / TICK_NS;
+        for (std::vector<int> &slot : m_wheel) {
+            slot.clear();
+        }
+        for (auto it = m_messages.begin(); it != m_messages.end(); ++it) {
+            it.value().deadlineNs = firstDeadline(it.value(), now);
+            schedule(it.key(), it.value());
+        }
+    }
+    
+    m_stopping = false;
+    m_running = true;
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName("CyclicTransmitThread");
+    m_thread->start(QThread::TimeCriticalPriority);
+}
+
+void CyclicTransmitter::stop()
+{
+    if (!m_thread) {
+        return;
+    }
+    
+    // Поток просыпается не реже MAX_SLEEP_NS и проверяет флаг
+    m_stopping = true;
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    m_running = false;
+}
+
+quint64 CyclicTransmitter::firstDeadline(const Message &message, quint64 nowNs) const
+{
+    // Ближайший момент расписания start + phase + k * period не раньше nowNs + ADD_LEAD_NS
+    const quint64 base = m_startNs + message.phaseNs;
+    const quint64 earliest = nowNs + ADD_LEAD_NS;
+    if (base >= earliest) {
+        return base;
+    }
+    const quint64 periods = (earliest - base + message.periodNs - 1) / message.periodNs;
+    return base + periods * message.periodNs;
+}
+
+void CyclicTransmitter::schedule(int handle, Message &message)
+{
+    m_wheel[(message.deadlineNs / TICK_NS) % WHEEL_SIZE].push_back(handle);
+}
+
+void CyclicTransmitter::run()
+{
+    while (!m_stopping) {
+        const quint64 now = CanClock::nowNs();
+        const quint64 nowTick = now / TICK_NS;
+        quint64 wakeNs;
+        {
+            QMutexLocker locker(&m_mutex);
+            // После долгого сна обрабатываются все пропущенные шаги по порядку
+            while (m_currentTick <= nowTick) {
+                processTick(m_currentTick, now);
+                ++m_currentTick;
+            }
+            wakeNs = nextWakeNs(now);
+        }
+        sleepUntil(wakeNs);
+    }
+}
+
+quint64 CyclicTransmitter::nextWakeNs(quint64 nowNs) const
+{
+    // Ближайший непустой слот в пределах MAX_SLEEP_NS
+    const quint64 lastTick = (nowNs + MAX_SLEEP_NS) / TICK_NS;
+    for (quint64 tick = m_currentTick; tick < lastTick; ++tick) {
+        if (!m_wheel[tick % WHEEL_SIZE].empty()) {
+            return tick * TICK_NS;
+        }
+    }
+    return nowNs + MAX_SLEEP_NS;
+}
+
+void CyclicTransmitter::processTick(quint64 tick, quint64 nowNs)
+{
+    std::vector<int> &slot = m_wheel[tick % WHEEL_SIZE];
+    if (slot.empty()) {
+        return;
+    }
+    
+    m_slotBuffer.swap(slot);
+    for (int handle : m_slotBuffer) {
+        auto it = m_messages.find(handle);
+        if (it == m_messages.end()) {
+            continue; // Сообщение удалено
+        }
+        
+        Message &message = it.value();
+        if (message.deadlineNs / TICK_NS != tick) {
+            // Срок на одном из следующих оборотов колеса
+            slot.push_back(handle);
+            continue;
+        }
+        
+        fire(message, nowNs);
+        schedule(handle, message);
+    }
+    m_slotBuffer.clear();
+}
+
+void CyclicTransmitter::fire(Message &message, quint64 nowNs)
+{
+    CanFrame frame = message.frame;
+    for (const PayloadHook &hook : message.hooks) {
+        hook(frame, message.sendCount);
+    }
+    message.sendCount++;
+    
+    // Срок по расписанию едет с кадром в метке времени: при записи в
+    // устройство поток сбора заменяет ее моментом записи
+    frame.timestampNs = message.deadlineNs;
+    if (m_canInterface->sendFrames(&frame, 1, TransmitPriority::Periodic, message.onWritten) != 1) {
+        message.writeStats->failed.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    // Если поток опоздал больше чем на период, пропущенные отправки не догоняются
+    quint64 next = message.deadlineNs + message.periodNs;
+    if (next <= nowNs) {
+        const quint64 missed = (nowNs - message.deadlineNs) / message.periodNs;
+        message.missedCycles += missed;
+        next = message.deadlineNs + (missed + 1) * message.periodNs;
+    }
+    message.deadlineNs = next;
+}
+
+TransmitCallbackPtr CyclicTransmitter::makeWriteCallback(const std::shared_ptr<WriteStats> &stats)
+{
+    // Опоздание считается в момент записи в устройство: callback вызывается
+    // потоком сбора сразу после записи пачки. Кадр может быть записан и после
+    // удаления сообщения, поэтому итоги принадлежат callback'у вместе с ним.
+    return std::make_shared<const TransmitCallback>([stats](bool success, const CanFrame &frame) {
+        if (!success) {
+            stats->failed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        const quint64 deadlineNs = frame.timestampNs;
+        const quint64 writtenNs = CanClock::nowNs();
+        const quint64 lateNs = writtenNs > deadlineNs ? writtenNs - deadlineNs : 0;
+        stats->lateTotalNs.fetch_add(lateNs, std::memory_order_relaxed);
+        quint64 maxNs = stats->lateMaxNs.load(std::memory_order_relaxed);
+        while (lateNs > maxNs && !stats->lateMaxNs.compare_exchange_weak(maxNs, lateNs, std::memory_order_relaxed)) {
+        }
+        stats->sent.fetch_add(1, std::memory_order_relaxed);
+    });
+}
+
+void CyclicTransmitter::sleepUntil(quint64 deadlineNs)
+{
+#ifdef Q_OS_LINUX
+    // Абсолютное время CLOCK_MONOTONIC не накапливает ошибку от цикла к циклу
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(deadlineNs / 1000000000ULL);
+    ts.tv_nsec = static_cast<long>(deadlineNs % 1000000000ULL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+#else
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(deadlineNs))));
+#endif
+}
+
+QVector<CyclicStatistics> CyclicTransmitter::statistics() const
+{
+    QVector<CyclicStatistics> result;
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_messages.constBegin(); it != m_messages.constEnd(); ++it) {
+        const Message &message = it.value();
+        CyclicStatistics stats;
+        stats.handle = it.key();
+        stats.id = message.frame.id;
+        stats.periodUs = static_cast<int>(message.periodNs / 1000);
+        const WriteStats &writeStats = *message.writeStats;
+        stats.sent = writeStats.sent.load(std::memory_order_relaxed);
+        stats.failed = writeStats.failed.load(std::memory_order_relaxed);
+        stats.missedCycles = message.missedCycles;
+        stats.averageJitterUs = stats.sent > 0
+            ? writeStats.lateTotalNs.load(std::memory_order_relaxed) / stats.sent / 1000 : 0;
+        stats.maxJitterUs = writeStats.lateMaxNs.load(std::memory_order_relaxed) / 1000;
+        result.append(stats);
+    }
+    return result;
+}
+
+void CyclicTransmitter::resetStatistics()
+{
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_messages.begin(); it != m_messages.end(); ++it) {
+        Message &message = it.value();
+        message.missedCycles = 0;
+        message.writeStats->reset();
+    }
+}
+
+void CyclicTransmitter::WriteStats::reset()
+{
+    sent = 0;
+    failed = 0;
+    lateTotalNs = 0;
+    lateMaxNs = 0;
+}
+
+CyclicTransmitter::PayloadHook CyclicTransmitter::counterHook(int byteIndex, quint8 mask)
+{
+    // Значение счетчика сдвигается к младшему биту маски
+    int shift = 0;
+    while (mask != 0 && !(mask & (1 << shift))) {
+        ++shift;
+    }
+    
+    return [byteIndex, mask, shift](CanFrame &frame, quint64 sendCount) {
+        if (byteIndex < 0 || byteIndex >= frame.dlc) {
+            return;
+        }
+        const quint8 value = static_cast<quint8>(sendCount << shift) & mask;
+        frame.data[byteIndex] = static_cast<quint8>((frame.data[byteIndex] & ~mask) | value);
+    };
+}
+
+CyclicTransmitter::PayloadHook CyclicTransmitter::checksumHook(int byteIndex, bool useXor)
+{
+    return [byteIndex, useXor](CanFrame &frame, quint64) {
+        if (byteIndex < 0 || byteIndex >= frame.dlc) {
+            return;
+        }
+        quint8 checksum = 0;
+        for (int i = 0; i < frame.dlc; ++i) {
+            if (i == byteIndex) {
+                continue;
+            }
+            checksum = useXor ? (checksum ^ frame.data[i]) : static_cast<quint8>(checksum + frame.data[i]);
+        }
+        frame.data[byteIndex] = checksum;
+    };
+}
@@ -1,5 +1,6 @@
 #include "diagnosticprotocol.h"
 #include "caninterface.h"
+#include "frameconsumer.h"
 #include <QDebug>
 #include <QEventLoop>
 
@@ -16,8 +17,25 @@ DiagnosticProtocol::DiagnosticProtocol(CANInterface *canInterface, QObject *pare
     connect(m_responseTimer, &QTimer::timeout, this, &DiagnosticProtocol::onResponseTimeout);
     
     if (m_canInterface) {
-        connect(m_canInterface, &CANInterface::messageReceivedDetailed,
-                this, &DiagnosticProtocol::onCanMessageReceived);
+        m_consumer = m_canInterface->createConsumer("diagnostics", DIAGNOSTIC_QUEUE_CAPACITY);
+        connect(m_consumer, &FrameConsumer::framesAvailable,
+                this, &DiagnosticProtocol::onFramesAvailable);
+    }
+}
+
+DiagnosticProtocol::~DiagnosticProtocol()
+{
+    // Очередь принадлежит CANInterface; если он уже удален, QPointer пуст
+    if (m_consumer) {
+        m_canInterface->removeConsumer(m_consumer);
+    }
+}
+
+void DiagnosticProtocol::onFramesAvailable()
+{
+    CanFrame frame;
+    while (m_consumer && m_consumer->pop(frame)) {
+        onCanFrameReceived(frame);
     }
 }
 
@@ -38,7 +56,8 @@ bool DiagnosticProtocol::sendRequest(const QByteArray &request)
     m_lastResponse.clear();
     m_responseTimer->start(m_timeout);
     
-    bool sent = m_canInterface->sendMessage(m_requestId, frame);
+    // Диагностический запрос не ждет за фоновым трафиком
+    bool sent = m_canInterface->sendMessage(m_requestId, frame, TransmitPriority::High);
     if (!sent) {
         m_waitingForResponse = false;
         m_responseTimer->stop();
@@ -64,23 +83,23 @@ bool DiagnosticProtocol::parseResponse(const QByteArray &data, QByteArray &respo
     return true;
 }
 
-void DiagnosticProtocol::onCanMessageReceived(quint32 id, const QByteArray &data, const QDateTime &timestamp)
+void DiagnosticProtocol::onCanFrameReceived(const CanFrame &frame)
 {
-    Q_UNUSED(timestamp);
-    
     if (!m_waitingForResponse) {
         return;
     }
     
     // Проверяем, что это ответ на наш запрос
+    const quint32 id = frame.id;
     if (id != m_responseId && id != (m_responseId + 1) && id != (m_responseId + 2) && id != (m_responseId + 3)) {
         // OBD-II может использовать несколько ID для ответов (0x7E8-0x7EB)
         // UDS обычно использует один ID, но может быть расширен
         return;
     }
     
+    // Копия данных создается только для кадров-ответов
     QByteArray responseData;
-    if (parseResponse(data, responseData)) {
+    if (parseResponse(frame.payload(), responseData)) {
         m_responseTimer->stop();
         m_waitingForResponse = false;
         m_lastResponse = responseData;
@@ -0,0 +1,108 @@
+#include "eventlogview.h"
+#include <QScrollBar>
+#include <QTextCursor>
+#include <QTextDocument>
+
+EventLogView::EventLogView(QWidget *parent)
+    : QPlainTextEdit(parent)
+    , m_channels(AllChannels)
+{
+    setReadOnly(true);
+    setUndoRedoEnabled(false);
+    setLineWrapMode(QPlainTextEdit::NoWrap);
+    setMaximumBlockCount(DEFAULT_MAXIMUM_LINES);
+}
+
+void EventLogView::setMaximumLines(int lines)
+{
+    setMaximumBlockCount(qMax(1, lines));
+}
+
+void EventLogView::setChannelEnabled(Channel channel, bool enabled)
+{
+    if (enabled) {
+        m_channels |= channel;
+    } else {
+        m_channels &= ~channel;
+    }
+}
+
+void EventLogView::append(Channel channel, const QString &tag, const QString &message, const QColor &tagColor)
+{
+    if (!(m_channels & channel)) {
+        return;
+    }
+    
+    // Строки сверх лимита журнала все равно были бы вытеснены при выводе.
+    // Очередь растет до двух лимитов и затем обрезается до одного: старые
+    // строки удаляются одним сдвигом на limit добавлений, а не на каждое.
+    const int limit = maximumBlockCount();
+    if (m_pending.size() >= limit * 2) {
+        m_pending.remove(0, m_pending.size() - limit + 1);
+    }
+    m_pending.append({QTime::currentTime(), channel, tag, message, tagColor});
+}
+
+QTextCharFormat EventLogView::tagFormat(const Line &line) const
+{
+    QTextCharFormat format;
+    format.setFontWeight(QFont::Bold);
+    if (line.tagColor.isValid()) {
+        format.setForeground(line.tagColor);
+        return format;
+    }
+    
+    // Цвета для темной темы
+    switch (line.channel) {
+    case RxChannel:
+        format.setForeground(QColor("#CE9178")); // Оранжево-коричневый
+        break;
+    case TxChannel:
+        format.setForeground(QColor("#4EC9B0")); // Бирюзовый
+        break;
+    case ErrorChannel:
+        format.setForeground(QColor("#F48771")); // Мягкий красный
+        break;
+    default:
+        format.setForeground(QColor("#CCCCCC")); // Светло-серый
+        break;
+    }
+    return format;
+}
+
+void EventLogView::flush()
+{
+    if (m_pending.isEmpty()) {
+        return;
+    }
+    
+    // Прокрутка следует за новыми строками, только если пользователь внизу
+    QScrollBar *scrollBar = verticalScrollBar();
+    const bool atBottom = scrollBar->value() == scrollBar->maximum();
+    
+    const int first = qMax(0, static_cast<int>(m_pending.size()) - maximumBlockCount());
+    QTextCursor cursor(document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.beginEditBlock();
+    for (int i = first; i < m_pending.size(); ++i) {
+        const Line &line = m_pending[i];
+        if (!document()->isEmpty()) {
+            cursor.insertBlock();
+        }
+        cursor.insertText(QString("[%1] ").arg(line.time.toString("hh:mm:ss.zzz")), m_textFormat);
+        cursor.insertText(line.tag, tagFormat(line));
+        cursor.insertText(" " + line.message, m_textFormat);
+    }
+    cursor.endEditBlock();
+    m_pending.clear();
+    
+    if (atBottom) {
+        scrollBar->setValue(scrollBar->maximum());
+    }
+}
+
+void EventLogView::clearLog()
+{
+    m_pending.clear();
+    clear();
+}
@@ -0,0 +1,216 @@
+#include "filterengine.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+using Mask = AcceptanceFilters::Mask;
+
+constexpr quint32 ID_MASK = 0x1FFFFFFF;
+
+// Правило как объединение пар код/маска: диапазон раскладывается
+// на выровненные блоки размером в степень двойки
+QVector<Mask> ruleMasks(const FilterRule &rule)
+{
+    QVector<Mask> masks;
+    switch (rule.kind) {
+        case FilterRule::ExactId:
+            if (rule.first <= ID_MASK) {
+                masks.append({rule.first, ID_MASK});
+            }
+            break;
+        case FilterRule::MaskCode:
+            // Условие на биты старше 29-го не выполняется ни для одного ID
+            if ((rule.first & rule.second & ~ID_MASK) == 0) {
+                masks.append({rule.first & rule.second & ID_MASK, rule.second & ID_MASK});
+            }
+            break;
+        case FilterRule::IdRange: {
+            quint64 low = rule.first;
+            const quint64 high = qMin<quint64>(rule.second, ID_MASK);
+            while (low <= high) {
+                quint64 size = low == 0 ? quint64(ID_MASK) + 1 : (low & (~low + 1));
+                while (low + size - 1 > high) {
+                    size >>= 1;
+                }
+                masks.append({static_cast<quint32>(low), static_cast<quint32>(~(size - 1)) & ID_MASK});
+                low += size;
+            }
+            break;
+        }
+    }
+    return masks;
+}
+
+bool overlaps(const QVector<Mask> &a, const QVector<Mask> &b)
+{
+    for (const Mask &x : a) {
+        for (const Mask &y : b) {
+            if (((x.code ^ y.code) & x.mask & y.mask) == 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+bool FilterRule::matches(quint32 id) const
+{
+    switch (kind) {
+        case ExactId:  return id == first;
+        case MaskCode: return (id & second) == (first & second);
+        case IdRange:  return id >= first && id <= second;
+    }
+    return false;
+}
+
+bool FilterRule::operator==(const FilterRule &other) const
+{
+    return kind == other.kind && first == other.first && second == other.second && allow == other.allow;
+}
+
+FilterEngine::FilterEngine(const QVector<FilterRule> &rules)
+    : m_rules(rules)
+    , m_hits(new std::atomic<quint64>[qMax(1, static_cast<int>(rules.size()))])
+    , m_unmatched(0)
+{
+    for (int i = 0; i < m_rules.size(); ++i) {
+        m_hits[i].store(0, std::memory_order_relaxed);
+    }
+    
+    // Точные правила: при повторе ID действует последнее
+    std::fill(m_standardRule, m_standardRule + STANDARD_ID_COUNT, NO_RULE);
+    QVector<int> patternRules;
+    for (int i = 0; i < m_rules.size(); ++i) {
+        const FilterRule &rule = m_rules[i];
+        if (rule.kind == FilterRule::ExactId) {
+            if (rule.first < STANDARD_ID_COUNT) {
+                m_standardRule[rule.first] = i;
+            } else {
+                m_extendedExact.insert(rule.first, i);
+            }
+        } else {
+            patternRules.append(i);
+            const bool standardOnly = rule.kind == FilterRule::IdRange && rule.second < STANDARD_ID_COUNT;
+            if (!standardOnly) {
+                m_extendedRules.append(i);
+            }
+        }
+    }
+    
+    // Остальные 11-битные ID - первая совпавшая маска или диапазон
+    std::memset(m_standardAccept, 0, sizeof(m_standardAccept));
+    for (quint32 id = 0; id < STANDARD_ID_COUNT; ++id) {
+        int &match = m_standardRule[id];
+        if (match == NO_RULE) {
+            for (int i : patternRules) {
+                if (m_rules[i].matches(id)) {
+                    match = i;
+                    break;
+                }
+            }
+        }
+        
+        if (match == NO_RULE || m_rules[match].allow) {
+            m_standardAccept[id >> 6] |= quint64(1) << (id & 63);
+        }
+    }
+}
+
+int FilterEngine::findExtendedRule(quint32 id) const
+{
+    auto exact = m_extendedExact.constFind(id);
+    if (exact != m_extendedExact.constEnd()) {
+        return exact.value();
+    }
+    
+    for (int i : m_extendedRules) {
+        if (m_rules[i].matches(id)) {
+            return i;
+        }
+    }
+    return NO_RULE;
+}
+
+bool FilterEngine::decide(quint32 id, int *ruleIndex) const
+{
+    const int rule = id < STANDARD_ID_COUNT ? m_standardRule[id] : findExtendedRule(id);
+    if (ruleIndex) {
+        *ruleIndex = rule;
+    }
+    return rule == NO_RULE || m_rules[rule].allow;
+}
+
+void FilterEngine::inheritHits(const FilterEngine &previous)
+{
+    for (int i = 0; i < m_rules.size(); ++i) {
+        const int index = previous.m_rules.indexOf(m_rules[i]);
+        if (index >= 0) {
+            m_hits[i].store(previous.hits(index), std::memory_order_relaxed);
+        }
+    }
+    m_unmatched.store(previous.unmatchedHits(), std::memory_order_relaxed);
+}
+
+AcceptanceFilters FilterEngine::acceptanceFilters(int maxMasks) const
+{
+    AcceptanceFilters result;
+    QVector<QVector<Mask>> masks;
+    bool denyAll = false;
+    for (const FilterRule &rule : m_rules) {
+        masks.append(ruleMasks(rule));
+        if (!rule.allow && rule.kind != FilterRule::ExactId) {
+            for (const Mask &mask : masks.last()) {
+                denyAll = denyAll || mask.mask == 0;
+            }
+        }
+    }
+    
+    // Все ID запрещены: пропускаются только совпавшие с разрешающими правилами
+    if (denyAll) {
+        QVector<Mask> allowed;
+        for (int i = 0; i < m_rules.size(); ++i) {
+            if (m_rules[i].allow) {
+                allowed += masks[i];
+            }
+        }
+        if (allowed.size() <= maxMasks) {
+            result.mode = AcceptanceFilters::AcceptMatching;
+            result.masks = allowed;
+            return result;
+        }
+    }
+    
+    // Иначе запреты, которые не перекрыты точным разрешением или более
+    // ранним разрешающим правилом. Неполный список допустим: он только
+    // отбрасывает меньше кадров.
+    for (int i = 0; i < m_rules.size(); ++i) {
+        const FilterRule &rule = m_rules[i];
+        if (rule.allow || masks[i].isEmpty()) {
+            continue;
+        }
+        
+        bool shadowed = false;
+        for (int j = 0; j < m_rules.size() && !shadowed; ++j) {
+            const FilterRule &other = m_rules[j];
+            if (rule.kind == FilterRule::ExactId) {
+                // Для точных правил действует последнее с тем же ID
+                shadowed = j > i && other.kind == FilterRule::ExactId && other.first == rule.first;
+            } else if (other.allow) {
+                const bool precedes = other.kind == FilterRule::ExactId || j < i;
+                shadowed = precedes && overlaps(masks[i], masks[j]);
+            }
+        }
+        
+        if (!shadowed && result.masks.size() + masks[i].size() <= maxMasks) {
+            result.masks += masks[i];
+        }
+    }
+    
+    if (!result.masks.isEmpty()) {
+        result.mode = AcceptanceFilters::RejectMatching;
+    }
+    return result;
+}
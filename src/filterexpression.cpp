@@ -0,0 +1,353 @@
+#include "filterexpression.h"
+#include <QByteArray>
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+// Разбор рекурсивным спуском с генерацией кода на лету
+class Compiler
+{
+public:
+    Compiler(const QByteArray &text, QVector<FilterExpression::Instruction> &code)
+        : m_text(text.constData())
+        , m_pos(0)
+        , m_code(code)
+        , m_failed(false)
+        , m_errorPosition(0)
+    {
+    }
+    
+    bool compile()
+    {
+        skipSpaces();
+        if (!m_text[m_pos]) {
+            return fail("Пустое выражение");
+        }
+        toBool(parseOr());
+        skipSpaces();
+        if (!m_failed && m_text[m_pos]) {
+            fail("Лишние символы в конце выражения");
+        }
+        return !m_failed;
+    }
+    
+    QString error() const { return m_error; }
+    int errorPosition() const { return m_errorPosition; }
+
+private:
+    using Op = FilterExpression::Opcode;
+    
+    // Результат подвыражения: логический (0/1) или значение. У значения -
+    // наибольший использованный байт данных, проверка длины кадра для него
+    // добавляется при сравнении или приведении к логическому.
+    struct Result {
+        bool isBool;
+        int maxByte;
+    };
+    
+    static Result boolean() { return {true, -1}; }
+    static Result value(int maxByte = -1) { return {false, maxByte}; }
+    
+    bool fail(const QString &message)
+    {
+        if (!m_failed) {
+            m_failed = true;
+            m_error = message;
+            m_errorPosition = m_pos;
+        }
+        return false;
+    }
+    
+    void skipSpaces()
+    {
+        while (m_text[m_pos] && std::isspace(static_cast<unsigned char>(m_text[m_pos]))) {
+            ++m_pos;
+        }
+    }
+    
+    bool accept(const char *token)
+    {
+        skipSpaces();
+        const int length = static_cast<int>(std::strlen(token));
+        if (std::strncmp(m_text + m_pos, token, length) != 0) {
+            return false;
+        }
+        m_pos += length;
+        return true;
+    }
+    
+    bool expect(const char *token)
+    {
+        return accept(token) || fail(QString("Ожидается '%1'").arg(token));
+    }
+    
+    void add(Op op, quint32 arg = 0)
+    {
+        // Операция с константой, положенной последней, сливается в одну инструкцию
+        static const struct { Op op; Op constOp; } fused[] = {
+            {Op::BitAnd, Op::BitAndConst}, {Op::Equal, Op::EqualConst},
+            {Op::NotEqual, Op::NotEqualConst}, {Op::Less, Op::LessConst},
+            {Op::LessEqual, Op::LessEqualConst}, {Op::Greater, Op::GreaterConst},
+            {Op::GreaterEqual, Op::GreaterEqualConst},
+        };
+        if (!m_code.isEmpty() && m_code.last().op == Op::PushConst) {
+            for (const auto &pair : fused) {
+                if (pair.op == op) {
+                    m_code.last().op = pair.constOp;
+                    return;
+                }
+            }
+        }
+        m_code.append({op, arg});
+    }
+    
+    void requireBytes(int maxByte)
+    {
+        if (maxByte >= 0) {
+            add(Op::RequireDlc, static_cast<quint32>(maxByte));
+        }
+    }
+    
+    void toBool(const Result &result)
+    {
+        if (!result.isBool) {
+            add(Op::ToBool);
+            requireBytes(result.maxByte);
+        }
+    }
+    
+    Result parseOr()
+    {
+        Result result = parseAnd();
+        while (!m_failed && accept("||")) {
+            toBool(result);
+            toBool(parseAnd());
+            add(Op::BitOr);
+            result = boolean();
+        }
+        return result;
+    }
+    
+    Result parseAnd()
+    {
+        Result result = parseUnary();
+        while (!m_failed && accept("&&")) {
+            toBool(result);
+            toBool(parseUnary());
+            add(Op::BitAnd);
+            result = boolean();
+        }
+        return result;
+    }
+    
+    Result parseUnary()
+    {
+        skipSpaces();
+        if (m_text[m_pos] == '!' && m_text[m_pos + 1] != '=') {
+            ++m_pos;
+            toBool(parseUnary());
+            add(Op::Not);
+            return boolean();
+        }
+        return parseComparison();
+    }
+    
+    Result parseComparison()
+    {
+        const Result left = parseBitAnd();
+        static const struct { const char *token; Op op; } comparisons[] = {
+            {"==", Op::Equal}, {"!=", Op::NotEqual}, {"<=", Op::LessEqual},
+            {">=", Op::GreaterEqual}, {"<", Op::Less}, {">", Op::Greater},
+        };
+        for (const auto &comparison : comparisons) {
+            if (accept(comparison.token)) {
+                const Result right = parseBitAnd();
+                add(comparison.op);
+                requireBytes(qMax(left.maxByte, right.maxByte));
+                return boolean();
+            }
+        }
+        return left;
+    }
+    
+    Result parseBitAnd()
+    {
+        Result result = parsePrimary();
+        for (;;) {
+            skipSpaces();
+            if (m_failed || m_text[m_pos] != '&' || m_text[m_pos + 1] == '&') {
+                return result;
+            }
+            ++m_pos;
+            const Result right = parsePrimary();
+            add(Op::BitAnd);
+            result = value(qMax(result.maxByte, right.maxByte));
+        }
+    }
+    
+    Result parsePrimary()
+    {
+        skipSpaces();
+        const char c = m_text[m_pos];
+        
+        if (c == '(') {
+            ++m_pos;
+            const Result result = parseOr();
+            expect(")");
+            return result;
+        }
+        
+        if (std::isdigit(static_cast<unsigned char>(c))) {
+            quint32 number = 0;
+            if (parseNumber(number)) {
+                add(Op::PushConst, number);
+            }
+            return value();
+        }
+        
+        if (std::isalpha(static_cast<unsigned char>(c))) {
+            const int start = m_pos;
+            while (std::isalnum(static_cast<unsigned char>(m_text[m_pos])) || m_text[m_pos] == '_') {
+                ++m_pos;
+            }
+            const QByteArray name(m_text + start, m_pos - start);
+            
+            if (name == "id") {
+                add(Op::LoadId);
+                return value();
+            }
+            if (name == "dlc") {
+                add(Op::LoadDlc);
+                return value();
+            }
+            if (name == "ext") {
+                add(Op::LoadExtended);
+                return boolean();
+            }
+            if (name == "data" || name == "word") {
+                const bool isWord = name == "word";
+                quint32 index = 0;
+                if (!expect("[") || !parseNumber(index) || !expect("]")) {
+                    return value();
+                }
+                if (index > (isWord ? 6u : 7u)) {
+                    fail(QString("Индекс байта вне диапазона 0-%1").arg(isWord ? 6 : 7));
+                    return value();
+                }
+                add(isWord ? Op::LoadWord : Op::LoadByte, index);
+                
+                if (!isWord && accept(".")) {
+                    quint32 bit = 0;
+                    if (parseNumber(bit) && bit > 7) {
+                        fail("Номер бита вне диапазона 0-7");
+                    }
+                    m_code.append({Op::BitAndConst, 1u << (bit & 7)});
+                }
+                return value(static_cast<int>(index) + (isWord ? 1 : 0));
+            }
+            
+            m_pos = start;
+            fail(QString("Неизвестное имя '%1'").arg(QString::fromLatin1(name)));
+            return value();
+        }
+        
+        fail(c ? "Ожидается значение" : "Неожиданный конец выражения");
+        return value();
+    }
+    
+    bool parseNumber(quint32 &value)
+    {
+        skipSpaces();
+        const char *start = m_text + m_pos;
+        char *end = nullptr;
+        const bool hex = start[0] == '0' && (start[1] == 'x' || start[1] == 'X');
+        if (!std::isdigit(static_cast<unsigned char>(start[0]))) {
+            return fail("Ожидается число");
+        }
+        const unsigned long long parsed = std::strtoull(start, &end, hex ? 16 : 10);
+        if (end == start + (hex ? 2 : 0) || parsed > 0xFFFFFFFFull) {
+            return fail("Неверное число");
+        }
+        m_pos += static_cast<int>(end - start);
+        value = static_cast<quint32>(parsed);
+        return true;
+    }
+    
+    const char *m_text;
+    int m_pos;
+    QVector<FilterExpression::Instruction> &m_code;
+    bool m_failed;
+    QString m_error;
+    int m_errorPosition;
+};
+
+// Глубина стека при выполнении, -1 - код некорректен
+int stackDepth(const QVector<FilterExpression::Instruction> &code)
+{
+    int depth = 0;
+    int maxDepth = 0;
+    for (const FilterExpression::Instruction &instruction : code) {
+        switch (instruction.op) {
+            case FilterExpression::PushConst:
+            case FilterExpression::LoadId:
+            case FilterExpression::LoadDlc:
+            case FilterExpression::LoadExtended:
+            case FilterExpression::LoadByte:
+            case FilterExpression::LoadWord:
+                ++depth;
+                break;
+            case FilterExpression::BitAnd:
+            case FilterExpression::BitOr:
+            case FilterExpression::Equal:
+            case FilterExpression::NotEqual:
+            case FilterExpression::Less:
+            case FilterExpression::LessEqual:
+            case FilterExpression::Greater:
+            case FilterExpression::GreaterEqual:
+                --depth;
+                break;
+            default:
+                break;
+        }
+        if (depth < 1) {
+            return -1;
+        }
+        maxDepth = qMax(maxDepth, depth);
+    }
+    return depth == 1 ? maxDepth : -1;
+}
+
+} // namespace
+
+FilterExpression::FilterExpression()
+    : m_errorPosition(-1)
+{
+}
+
+bool FilterExpression::compile(const QString &expression)
+{
+    m_code.clear();
+    m_expression = expression;
+    m_lastError.clear();
+    m_errorPosition = -1;
+    
+    const QByteArray text = expression.toLatin1();
+    QVector<Instruction> code;
+    Compiler compiler(text, code);
+    if (!compiler.compile()) {
+        m_lastError = compiler.error();
+        m_errorPosition = compiler.errorPosition();
+        return false;
+    }
+    
+    const int depth = stackDepth(code);
+    if (depth < 0 || depth > MAX_STACK) {
+        m_lastError = depth < 0 ? "Ошибка компиляции выражения" : "Слишком сложное выражение";
+        m_errorPosition = 0;
+        return false;
+    }
+    
+    m_code = code;
+    return true;
+}
@@ -0,0 +1,48 @@
+#include "frameconsumer.h"
+
+FrameConsumer::FrameConsumer(const QString &name, int capacity, QObject *parent)
+    : QObject(parent)
+    , m_name(name)
+    , m_ring(capacity)
+    , m_overflows(0)
+    , m_notifyPending(false)
+{
+}
+
+bool FrameConsumer::push(const CanFrame &frame)
+{
+    if (!m_ring.tryPush(frame)) {
+        m_overflows.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void FrameConsumer::notify()
+{
+    // Одно уведомление в очереди событий на любое количество кадров
+    if (m_notifyPending.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    
+    QMetaObject::invokeMethod(this, [this]() {
+        m_notifyPending.store(false, std::memory_order_release);
+        emit framesAvailable();
+    }, Qt::QueuedConnection);
+}
+
+bool FrameConsumer::pop(CanFrame &frame)
+{
+    return m_ring.tryPop(frame);
+}
+
+int FrameConsumer::drain(QVector<CanFrame> &frames, int maxCount)
+{
+    int count = 0;
+    CanFrame frame;
+    while ((maxCount < 0 || count < maxCount) && m_ring.tryPop(frame)) {
+        frames.append(frame);
+        ++count;
+    }
+    return count;
+}
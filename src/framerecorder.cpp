@@ -0,0 +1,309 @@
+#include "framerecorder.h"
+#include <QThread>
+#include <QDir>
+#include <QDateTime>
+#include <QtAlgorithms>
+#include <cstring>
+
+FrameRecorder::FrameRecorder(QObject *parent)
+    : QObject(parent)
+    , m_writerThread(nullptr)
+    , m_recording(false)
+    , m_stopping(false)
+    , m_failed(false)
+    , m_active(nullptr)
+    , m_sequence(0)
+    , m_fileStartNs(0)
+    , m_framesRecorded(0)
+    , m_bytesWritten(0)
+    , m_framesDropped(0)
+    , m_filesCreated(0)
+{
+}
+
+FrameRecorder::~FrameRecorder()
+{
+    stop();
+    waitForFinished();
+    qDeleteAll(m_buffers);
+}
+
+bool FrameRecorder::start(const Config &config)
+{
+    if (isRecording() || isFinishing()) {
+        QMutexLocker locker(&m_mutex);
+        m_lastError = isRecording() ? QString("Запись уже идет")
+                                    : QString("Предыдущая запись еще сохраняется на диск");
+        return false;
+    }
+    
+    Config normalized = config;
+    // Буфер вмещает целое число кадров: файлы режутся только по границам кадров
+    const int frameSize = static_cast<int>(sizeof(CanFrame));
+    normalized.bufferBytes = qMax(frameSize, config.bufferBytes / frameSize * frameSize);
+    normalized.maxBuffers = qMax(2, config.maxBuffers);
+    normalized.flushIntervalMs = qMax(10, config.flushIntervalMs);
+    
+    if (!QDir().mkpath(normalized.directory)) {
+        QMutexLocker locker(&m_mutex);
+        m_lastError = QString("Не удалось создать каталог записи: %1").arg(normalized.directory);
+        return false;
+    }
+    
+    {
+        // takeFreeBuffer() читает m_config под блокировкой из потока сбора
+        QMutexLocker locker(&m_mutex);
+        m_config = normalized;
+        qDeleteAll(m_buffers);
+        m_buffers.clear();
+        m_free.clear();
+        m_full.clear();
+        m_active = nullptr;
+        m_stopping = false;
+        m_failed = false;
+        m_lastError.clear();
+        m_framesRecorded = 0;
+        m_bytesWritten = 0;
+        m_framesDropped = 0;
+        m_filesCreated = 0;
+        
+        // Двойная буферизация: один буфер заполняется, другой пишется
+        m_active = takeFreeBuffer();
+        m_free.append(takeFreeBuffer());
+    }
+    
+    m_sequence = 0;
+    if (!openNextFile()) {
+        return false;
+    }
+    
+    m_recording.store(true, std::memory_order_release);
+    QThread *thread = QThread::create([this]() { runWriter(); });
+    thread->setObjectName("CANRecorderThread");
+    // Объект потока удаляется в потоке FrameRecorder после завершения записи
+    connect(thread, &QThread::finished, this, &FrameRecorder::finished);
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    m_writerThread = thread;
+    thread->start();
+    return true;
+}
+
+void FrameRecorder::stop()
+{
+    // Поток UI не ждет диск: сброс буферов (до maxBuffers * bufferBytes)
+    // и закрытие файла выполняет поток записи
+    if (!m_recording.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    
+    QMutexLocker locker(&m_mutex);
+    m_stopping = true;
+    m_bufferReady.wakeAll();
+}
+
+void FrameRecorder::waitForFinished()
+{
+    if (m_writerThread) {
+        m_writerThread->wait();
+        delete m_writerThread;
+    }
+}
+
+bool FrameRecorder::isFinishing() const
+{
+    return m_writerThread && !m_writerThread->isFinished();
+}
+
+QString FrameRecorder::errorString() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_lastError;
+}
+
+FrameRecorder::Buffer *FrameRecorder::takeFreeBuffer()
+{
+    if (!m_free.isEmpty()) {
+        Buffer *buffer = m_free.takeLast();
+        buffer->used = 0;
+        return buffer;
+    }
+    if (m_buffers.size() >= m_config.maxBuffers) {
+        return nullptr;
+    }
+    
+    Buffer *buffer = new Buffer;
+    buffer->data.resize(m_config.bufferBytes);
+    buffer->used = 0;
+    m_buffers.append(buffer);
+    return buffer;
+}
+
+void FrameRecorder::append(const CanFrame *frames, int count)
+{
+    if (count <= 0 || !m_recording.load(std::memory_order_acquire)) {
+        return;
+    }
+    
+    // Под блокировкой только копирование пачки и обмен буферов
+    QMutexLocker locker(&m_mutex);
+    if (m_stopping || m_failed) {
+        m_framesDropped += count;
+        return;
+    }
+    
+    const int frameSize = static_cast<int>(sizeof(CanFrame));
+    int copied = 0;
+    while (copied < count) {
+        if (!m_active) {
+            // Диск не успевает и все буферы заняты
+            m_active = takeFreeBuffer();
+            if (!m_active) {
+                m_framesDropped += count - copied;
+                return;
+            }
+        }
+        
+        const int space = (m_active->data.size() - m_active->used) / frameSize;
+        const int chunk = qMin(space, count - copied);
+        std::memcpy(m_active->data.data() + m_active->used, frames + copied, chunk * frameSize);
+        m_active->used += chunk * frameSize;
+        copied += chunk;
+        
+        if (m_active->used == m_active->data.size()) {
+            m_full.append(m_active);
+            m_active = takeFreeBuffer();
+            m_bufferReady.wakeOne();
+        }
+    }
+}
+
+void FrameRecorder::runWriter()
+{
+    QMutexLocker locker(&m_mutex);
+    while (true) {
+        if (m_full.isEmpty() && !m_stopping) {
+            // Частично заполненный буфер уходит на диск по таймауту
+            if (!m_bufferReady.wait(&m_mutex, m_config.flushIntervalMs) && m_full.isEmpty()
+                && m_active && m_active->used > 0) {
+                m_full.append(m_active);
+                m_active = takeFreeBuffer();
+            }
+        }
+        if (m_stopping && m_active && m_active->used > 0) {
+            m_full.append(m_active);
+            m_active = nullptr;
+        }
+        if (m_full.isEmpty()) {
+            if (m_stopping) {
+                break;
+            }
+            continue;
+        }
+        
+        Buffer *buffer = m_full.takeFirst();
+        const bool failed = m_failed;
+        locker.unlock();
+        const bool written = !failed && writeBuffer(*buffer);
+        locker.relock();
+        
+        const quint64 frames = buffer->used / sizeof(CanFrame);
+        if (written) {
+            m_framesRecorded += frames;
+            m_bytesWritten += buffer->used;
+        } else {
+            m_framesDropped += frames;
+        }
+        buffer->used = 0;
+        m_free.append(buffer);
+        if (!m_active && !m_stopping) {
+            m_active = takeFreeBuffer();
+        }
+    }
+    
+    locker.unlock();
+    m_file.close();
+}
+
+bool FrameRecorder::writeBuffer(const Buffer &buffer)
+{
+    // Ротация до записи буфера: файл не превышает предел, если буфер меньше предела
+    const bool sizeExceeded = m_config.maxFileBytes > 0
+        && m_file.size() > static_cast<qint64>(sizeof(CaptureFileHeader))
+        && m_file.size() + buffer.used > m_config.maxFileBytes;
+    const bool timeExceeded = m_config.maxFileSeconds > 0
+        && CanClock::nowNs() - m_fileStartNs >= static_cast<quint64>(m_config.maxFileSeconds) * 1000000000ULL;
+    if ((sizeExceeded || timeExceeded) && !openNextFile()) {
+        return false;
+    }
+    
+    if (m_file.write(buffer.data.constData(), buffer.used) != buffer.used) {
+        fail(QString("Ошибка записи %1: %2").arg(m_file.fileName(), m_file.errorString()));
+        return false;
+    }
+    return true;
+}
+
+bool FrameRecorder::openNextFile()
+{
+    m_file.close();
+    
+    const QString name = QString("%1_%2_%3%4")
+                         .arg(m_config.prefix,
+                              QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"))
+                         .arg(m_sequence, 3, 10, QChar('0'))
+                         .arg(FILE_SUFFIX);
+    m_file.setFileName(QDir(m_config.directory).filePath(name));
+    
+    // Без буфера QFile: данные уже собраны в большие блоки
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        fail(QString("Не удалось создать файл записи %1: %2").arg(m_file.fileName(), m_file.errorString()));
+        return false;
+    }
+    
+    CaptureFileHeader header = {};
+    std::memcpy(header.magic, CaptureFileHeader::CAPTURE_MAGIC, sizeof(header.magic));
+    header.version = CaptureFileHeader::CAPTURE_VERSION;
+    header.headerSize = sizeof(CaptureFileHeader);
+    header.recordSize = sizeof(CanFrame);
+    header.bitrateKbps = static_cast<quint32>(qMax(0, m_config.bitrateKbps));
+    header.monotonicNs = CanClock::nowNs();
+    header.wallClockMs = CanClock::toMSecsSinceEpoch(header.monotonicNs);
+    header.sequence = m_sequence;
+    if (m_file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != sizeof(header)) {
+        fail(QString("Ошибка записи %1: %2").arg(m_file.fileName(), m_file.errorString()));
+        return false;
+    }
+    
+    m_fileStartNs = header.monotonicNs;
+    ++m_sequence;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_currentFile = m_file.fileName();
+        ++m_filesCreated;
+    }
+    emit fileStarted(m_file.fileName());
+    return true;
+}
+
+void FrameRecorder::fail(const QString &error)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_failed = true;
+        m_lastError = error;
+    }
+    emit errorOccurred(error);
+}
+
+FrameRecorder::Statistics FrameRecorder::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+    Statistics stats;
+    stats.framesRecorded = m_framesRecorded;
+    stats.bytesWritten = m_bytesWritten;
+    stats.framesDropped = m_framesDropped;
+    stats.filesCreated = m_filesCreated;
+    stats.buffersAllocated = m_buffers.size();
+    stats.currentFile = m_currentFile;
+    return stats;
+}
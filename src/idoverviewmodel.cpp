@@ -0,0 +1,177 @@
+#include "idoverviewmodel.h"
+#include <QBrush>
+#include <QColor>
+
+IdOverviewModel::IdOverviewModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+bool IdOverviewModel::sameRow(const IdStatistics &a, const IdStatistics &b)
+{
+    return a.id == b.id && a.tx == b.tx;
+}
+
+void IdOverviewModel::update(const QVector<IdStatistics> &snapshot)
+{
+    // Снимок продолжает текущие строки, если первые ID совпадают. Иначе
+    // таблица была очищена или обнулена - модель строится заново.
+    const int common = qMin(m_rows.size(), snapshot.size());
+    bool continues = snapshot.size() >= m_rows.size();
+    for (int row = 0; continues && row < common; ++row) {
+        continues = sameRow(m_rows[row], snapshot[row]);
+    }
+    if (!continues) {
+        beginResetModel();
+        m_rows = snapshot;
+        endResetModel();
+        return;
+    }
+    
+    // Одно уведомление на диапазон строк с новыми кадрами
+    int firstChanged = -1;
+    int lastChanged = -1;
+    for (int row = 0; row < common; ++row) {
+        if (m_rows[row].frames != snapshot[row].frames) {
+            m_rows[row] = snapshot[row];
+            if (firstChanged < 0) {
+                firstChanged = row;
+            }
+            lastChanged = row;
+        }
+    }
+    if (firstChanged >= 0) {
+        emit dataChanged(index(firstChanged, 0), index(lastChanged, COLUMN_COUNT - 1));
+    }
+    
+    if (snapshot.size() > common) {
+        beginInsertRows(QModelIndex(), common, snapshot.size() - 1);
+        for (int row = common; row < snapshot.size(); ++row) {
+            m_rows.append(snapshot[row]);
+        }
+        endInsertRows();
+    }
+}
+
+void IdOverviewModel::clear()
+{
+    beginResetModel();
+    m_rows.clear();
+    endResetModel();
+}
+
+int IdOverviewModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+int IdOverviewModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : COLUMN_COUNT;
+}
+
+QVariant IdOverviewModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows.size()) {
+        return QVariant();
+    }
+    const IdStatistics &stats = m_rows[index.row()];
+    
+    if (role == SortRole) {
+        switch (index.column()) {
+        case IdColumn:
+            return stats.id;
+        case DirectionColumn:
+            return stats.tx;
+        case CountColumn:
+            return stats.frames;
+        case CycleColumn:
+            return stats.cyclePeriodNs;
+        case JitterColumn:
+            return stats.jitterNs;
+        default:
+            role = Qt::DisplayRole;
+            break;
+        }
+    }
+    
+    if (role == Qt::DisplayRole) {
+        static const char HEX[] = "0123456789ABCDEF";
+        const int dlc = qMin<int>(stats.dlc, 8);
+        switch (index.column()) {
+        case IdColumn:
+            return QString("0x%1").arg(stats.id, (stats.flags & CanFrame::FLAG_EXTENDED) ? 8 : 3, 16, QChar('0')).toUpper();
+        case DirectionColumn:
+            return stats.tx ? QStringLiteral("TX") : QStringLiteral("RX");
+        case CountColumn:
+            return stats.frames;
+        case DataColumn: {
+            QString text(qMax(0, dlc * 3 - 1), QChar(' '));
+            for (int i = 0; i < dlc; ++i) {
+                text[i * 3] = QChar(HEX[stats.data[i] >> 4]);
+                text[i * 3 + 1] = QChar(HEX[stats.data[i] & 0x0F]);
+            }
+            return text;
+        }
+        case ChangesColumn: {
+            // Отметки под изменившимися байтами колонки данных
+            QString text(qMax(0, dlc * 3 - 1), QChar(' '));
+            for (int i = 0; i < dlc; ++i) {
+                if (stats.changedMask & (1 << i)) {
+                    text[i * 3] = QChar('^');
+                    text[i * 3 + 1] = QChar('^');
+                }
+            }
+            return text;
+        }
+        case CycleColumn:
+            return stats.cyclePeriodNs ? QString::number(stats.cyclePeriodNs / 1e6, 'f', 1) : QString();
+        case JitterColumn:
+            return stats.cyclePeriodNs ? QString::number(stats.jitterNs / 1e6, 'f', 2) : QString();
+        default:
+            return QVariant();
+        }
+    }
+    
+    // Подсветка кадров с изменившимся содержимым
+    if (role == Qt::ForegroundRole) {
+        if (index.column() == DataColumn && stats.changedMask) {
+            return QBrush(QColor("#DCDCAA"));
+        }
+        if (index.column() == DirectionColumn) {
+            return stats.tx ? QBrush(QColor("#4EC9B0")) : QBrush(QColor("#CE9178"));
+        }
+    }
+    
+    if (role == Qt::TextAlignmentRole && (index.column() == CountColumn || index.column() == CycleColumn
+                                          || index.column() == JitterColumn)) {
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    }
+    return QVariant();
+}
+
+QVariant IdOverviewModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    
+    switch (section) {
+    case IdColumn:
+        return QStringLiteral("ID");
+    case DirectionColumn:
+        return QStringLiteral("Напр.");
+    case CountColumn:
+        return QStringLiteral("Кадров");
+    case DataColumn:
+        return QStringLiteral("Данные");
+    case ChangesColumn:
+        return QStringLiteral("Изменения");
+    case CycleColumn:
+        return QStringLiteral("Период, мс");
+    case JitterColumn:
+        return QStringLiteral("Джиттер, мс");
+    default:
+        return QVariant();
+    }
+}
@@ -0,0 +1,259 @@
+#include "idstatistics.h"
+#include <algorithm>
+#include <cstring>
+
+// Запись ID, выровнена по строке кэша. Первая строка - поля, которые
+// меняются на каждый кадр, во второй - экстремумы периода и гистограмма.
+struct alignas(64) IdStatisticsTable::Entry {
+    std::atomic<quint64> frames;
+    std::atomic<quint64> bytes;
+    std::atomic<quint64> bits;
+    std::atomic<quint64> lastNs;
+    std::atomic<quint64> lastData;
+    std::atomic<quint32> lastFrameInfo;   // DLC | флаги << 8 | маска изменений << 16
+    std::atomic<quint32> epoch;
+    std::atomic<quint64> cycleNs;         // Сглаженный период для обзора по ID
+    std::atomic<quint64> jitterNs;
+    
+    std::atomic<quint64> minPeriodNs;
+    std::atomic<quint64> maxPeriodNs;
+    std::atomic<quint64> firstNs;
+    quint32 key;
+    std::atomic<quint64> dlcHistogram[9];
+};
+
+namespace {
+
+// Один писатель: обновление без атомарных операций с блокировкой шины
+inline void store(std::atomic<quint64> &counter, quint64 value)
+{
+    counter.store(value, std::memory_order_relaxed);
+}
+
+inline quint64 load(const std::atomic<quint64> &counter)
+{
+    return counter.load(std::memory_order_relaxed);
+}
+
+inline void increment(std::atomic<quint64> &counter, quint64 delta = 1)
+{
+    store(counter, load(counter) + delta);
+}
+
+// Ключ записи: ID и направление, 0 - свободная ячейка индекса
+inline quint32 makeKey(const CanFrame &frame)
+{
+    return ((frame.id & 0x1FFFFFFF) | (frame.isTx() ? 0x40000000u : 0u)) + 1;
+}
+
+// Байты кадра в одном слове, байты за DLC обнулены
+inline quint64 packData(const CanFrame &frame, int dlc)
+{
+    quint64 data;
+    std::memcpy(&data, frame.data, sizeof(data));
+    return dlc >= 8 ? data : data & ((1ULL << (8 * dlc)) - 1);
+}
+
+// Маска ненулевых байтов слова: бит i - байт i
+inline quint32 nonZeroBytes(quint64 value)
+{
+    value |= value >> 4;
+    value |= value >> 2;
+    value |= value >> 1;
+    value &= 0x0101010101010101ULL;
+    return static_cast<quint32>((value * 0x0102040810204080ULL) >> 56);
+}
+
+} // namespace
+
+IdStatisticsTable::IdStatisticsTable(int capacity)
+    : m_capacity(qMax(1, capacity))
+    , m_entries(new Entry[m_capacity])
+    , m_count(0)
+    , m_indexMask(0)
+    , m_lastKey(0)
+    , m_lastEntry(nullptr)
+    , m_epoch(1)
+    , m_untracked(0)
+    , m_totalFrames(0)
+    , m_totalBits(0)
+{
+    // Индекс заполнен не более чем наполовину
+    quint32 indexSize = 1;
+    while (indexSize < static_cast<quint32>(m_capacity) * 2) {
+        indexSize <<= 1;
+    }
+    m_indexMask = indexSize - 1;
+    m_index.reset(new qint32[indexSize]);
+    m_indexKeys.reset(new quint32[indexSize]);
+    clear();
+}
+
+IdStatisticsTable::~IdStatisticsTable() = default;
+
+void IdStatisticsTable::clear()
+{
+    m_count.store(0, std::memory_order_release);
+    std::fill(m_indexKeys.get(), m_indexKeys.get() + m_indexMask + 1, 0u);
+    m_lastKey = 0;
+    m_lastEntry = nullptr;
+    m_untracked.store(0, std::memory_order_relaxed);
+    m_totalFrames.store(0, std::memory_order_relaxed);
+    m_totalBits.store(0, std::memory_order_relaxed);
+    m_epoch.fetch_add(1, std::memory_order_release);
+}
+
+void IdStatisticsTable::reset()
+{
+    m_untracked.store(0, std::memory_order_relaxed);
+    m_epoch.fetch_add(1, std::memory_order_release);
+}
+
+IdStatisticsTable::Entry *IdStatisticsTable::find(quint32 key)
+{
+    quint32 slot = (key * 0x9E3779B1u) & m_indexMask;
+    while (m_indexKeys[slot] != 0) {
+        if (m_indexKeys[slot] == key) {
+            return &m_entries[m_index[slot]];
+        }
+        slot = (slot + 1) & m_indexMask;
+    }
+    return insert(key, static_cast<int>(slot));
+}
+
+IdStatisticsTable::Entry *IdStatisticsTable::insert(quint32 key, int slot)
+{
+    const int count = m_count.load(std::memory_order_relaxed);
+    if (count >= m_capacity) {
+        return nullptr;
+    }
+    
+    // Запись заполняется до публикации счетчика записей
+    Entry &entry = m_entries[count];
+    entry.key = key;
+    entry.epoch.store(0, std::memory_order_relaxed);
+    m_indexKeys[slot] = key;
+    m_index[slot] = count;
+    m_count.store(count + 1, std::memory_order_release);
+    return &entry;
+}
+
+void IdStatisticsTable::record(const CanFrame &frame)
+{
+    const int bits = frame.bitLength();
+    increment(m_totalFrames);
+    increment(m_totalBits, bits);
+    
+    const quint32 key = makeKey(frame);
+    Entry *entry = key == m_lastKey ? m_lastEntry : find(key);
+    if (!entry) {
+        increment(m_untracked);
+        return;
+    }
+    m_lastKey = key;
+    m_lastEntry = entry;
+    
+    const quint8 dlc = qMin<quint8>(frame.dlc, 8);
+    const quint64 data = packData(frame, dlc);
+    const quint64 timestampNs = frame.timestampNs;
+    const quint32 epoch = m_epoch.load(std::memory_order_acquire);
+    quint32 changedMask = 0;
+    if (entry->epoch.load(std::memory_order_relaxed) != epoch) {
+        // Первый кадр ID после обнуления
+        store(entry->frames, 0);
+        store(entry->bytes, 0);
+        store(entry->bits, 0);
+        store(entry->minPeriodNs, 0);
+        store(entry->maxPeriodNs, 0);
+        store(entry->firstNs, timestampNs);
+        store(entry->lastNs, timestampNs);
+        store(entry->cycleNs, 0);
+        store(entry->jitterNs, 0);
+        for (std::atomic<quint64> &bucket : entry->dlcHistogram) {
+            store(bucket, 0);
+        }
+        entry->epoch.store(epoch, std::memory_order_release);
+    } else {
+        // Кадры одного чтения имеют одну метку времени, нулевой период не учитывается
+        const quint64 lastNs = load(entry->lastNs);
+        if (timestampNs > lastNs) {
+            const quint64 period = timestampNs - lastNs;
+            const quint64 minPeriod = load(entry->minPeriodNs);
+            if (minPeriod == 0 || period < minPeriod) {
+                store(entry->minPeriodNs, period);
+            }
+            if (period > load(entry->maxPeriodNs)) {
+                store(entry->maxPeriodNs, period);
+            }
+            store(entry->lastNs, timestampNs);
+            
+            // Скользящие средние периода и его отклонения, вес нового значения 1/8
+            const qint64 cycle = static_cast<qint64>(load(entry->cycleNs));
+            if (cycle == 0) {
+                store(entry->cycleNs, period);
+            } else {
+                const qint64 deviation = qAbs(static_cast<qint64>(period) - cycle);
+                const qint64 jitter = static_cast<qint64>(load(entry->jitterNs));
+                store(entry->cycleNs, static_cast<quint64>(cycle + (static_cast<qint64>(period) - cycle) / 8));
+                store(entry->jitterNs, static_cast<quint64>(jitter + (deviation - jitter) / 8));
+            }
+        }
+        changedMask = nonZeroBytes(data ^ load(entry->lastData)) & ((1u << dlc) - 1);
+    }
+    store(entry->lastData, data);
+    entry->lastFrameInfo.store(dlc | (static_cast<quint32>(frame.flags) << 8) | (changedMask << 16),
+                               std::memory_order_relaxed);
+    
+    increment(entry->frames);
+    increment(entry->bytes, dlc);
+    increment(entry->bits, bits);
+    increment(entry->dlcHistogram[dlc]);
+}
+
+QVector<IdStatistics> IdStatisticsTable::snapshot() const
+{
+    QVector<IdStatistics> result;
+    snapshot(result);
+    return result;
+}
+
+void IdStatisticsTable::snapshot(QVector<IdStatistics> &result) const
+{
+    const int count = m_count.load(std::memory_order_acquire);
+    const quint32 epoch = m_epoch.load(std::memory_order_acquire);
+    
+    result.clear();
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const Entry &entry = m_entries[i];
+        if (entry.epoch.load(std::memory_order_acquire) != epoch) {
+            continue;
+        }
+        
+        IdStatistics stats;
+        stats.id = (entry.key - 1) & 0x1FFFFFFF;
+        stats.tx = ((entry.key - 1) & 0x40000000u) != 0;
+        stats.frames = load(entry.frames);
+        stats.bytes = load(entry.bytes);
+        stats.bits = load(entry.bits);
+        stats.firstTimestampNs = load(entry.firstNs);
+        stats.lastTimestampNs = load(entry.lastNs);
+        stats.minPeriodNs = load(entry.minPeriodNs);
+        stats.maxPeriodNs = load(entry.maxPeriodNs);
+        for (int dlc = 0; dlc < 9; ++dlc) {
+            stats.dlcHistogram[dlc] = load(entry.dlcHistogram[dlc]);
+        }
+        stats.framesPerSecond = 0;
+        stats.busLoadPercent = 0;
+        
+        const quint64 data = load(entry.lastData);
+        std::memcpy(stats.data, &data, sizeof(stats.data));
+        const quint32 info = entry.lastFrameInfo.load(std::memory_order_relaxed);
+        stats.dlc = static_cast<quint8>(info & 0xFF);
+        stats.flags = static_cast<quint8>((info >> 8) & 0xFF);
+        stats.changedMask = static_cast<quint8>((info >> 16) & 0xFF);
+        stats.cyclePeriodNs = load(entry.cycleNs);
+        stats.jitterNs = load(entry.jitterNs);
+        result.append(stats);
+    }
+}
@@ -0,0 +1,314 @@
+#include "libusbbackend.h"
+#include <QDebug>
+#include <QThread>
+#include <libusb-1.0/libusb.h>
+
+// Один асинхронный bulk IN запрос вместе со своим буфером.
+// backend == nullptr - слот брошен при остановке, пока запрос был в работе:
+// он освобождается сам, когда libusb наконец вернет запрос.
+struct LibusbBackend::TransferSlot {
+    LibusbBackend *backend;
+    libusb_transfer *transfer;
+    QByteArray buffer;
+    bool active;      // Запрос отправлен и еще не вернулся окончательно
+    
+    void retire()
+    {
+        active = false;
+        backend->m_activeTransfers--;
+    }
+    
+    static void LIBUSB_CALL onTransferComplete(libusb_transfer *transfer);
+};
+
+void LIBUSB_CALL LibusbBackend::TransferSlot::onTransferComplete(libusb_transfer *transfer)
+{
+    // Вызывается в потоке событий libusb
+    TransferSlot *slot = static_cast<TransferSlot*>(transfer->user_data);
+    LibusbBackend *backend = slot->backend;
+    if (!backend) {
+        libusb_free_transfer(transfer);
+        delete slot;
+        return;
+    }
+    
+    switch (transfer->status) {
+        case LIBUSB_TRANSFER_COMPLETED:
+            if (transfer->actual_length > 0 && backend->m_onData) {
+                backend->m_onData(slot->buffer.constData(), transfer->actual_length);
+            }
+            break;
+        case LIBUSB_TRANSFER_TIMED_OUT:
+            break;
+        case LIBUSB_TRANSFER_CANCELLED:
+            slot->retire();
+            return;
+        case LIBUSB_TRANSFER_NO_DEVICE:
+            slot->retire();
+            if (!backend->m_stopping) {
+                backend->reportError("USB устройство отключено");
+            }
+            return;
+        default:
+            // Ошибка или STALL: слот выводится из работы, остальные продолжают прием
+            slot->retire();
+            if (!backend->m_stopping) {
+                backend->reportError(QString("Ошибка приема USB (статус %1)").arg(transfer->status));
+            }
+            return;
+    }
+    
+    // Повторная отправка запроса, пока прием не остановлен
+    if (backend->m_stopping || libusb_submit_transfer(transfer) != LIBUSB_SUCCESS) {
+        slot->retire();
+    }
+}
+
+LibusbBackend::LibusbBackend()
+    : m_context(nullptr)
+    , m_handle(nullptr)
+    , m_isOpen(false)
+    , m_eventThread(nullptr)
+    , m_stopping(false)
+    , m_activeTransfers(0)
+{
+    // Инициализация libusb
+    int result = libusb_init(&m_context);
+    if (result < 0) {
+        m_lastError = QString("Ошибка инициализации libusb: %1").arg(libusb_error_name(result));
+        qDebug() << m_lastError;
+    }
+}
+
+LibusbBackend::~LibusbBackend()
+{
+    close();
+    if (m_context) {
+        libusb_exit(m_context);
+        m_context = nullptr;
+    }
+}
+
+void LibusbBackend::reportError(const QString &error)
+{
+    if (m_onError) {
+        m_onError(error);
+    }
+}
+
+bool LibusbBackend::open(quint16 vendorId, quint16 productId, int transferCount, int transferSize)
+{
+    if (!m_context) {
+        m_lastError = "libusb не инициализирован";
+        return false;
+    }
+    
+    if (m_isOpen) {
+        close();
+    }
+    
+    // Поиск устройства
+    m_handle = libusb_open_device_with_vid_pid(m_context, vendorId, productId);
+    if (!m_handle) {
+        m_lastError = QString("Устройство VID:%1 PID:%2 не найдено")
+                     .arg(vendorId, 4, 16, QChar('0'))
+                     .arg(productId, 4, 16, QChar('0'));
+        return false;
+    }
+    
+    // Освобождение интерфейса если он занят драйвером
+    int result = libusb_set_auto_detach_kernel_driver(m_handle, 1);
+    if (result != LIBUSB_SUCCESS && result != LIBUSB_ERROR_NOT_SUPPORTED) {
+        qDebug() << "Предупреждение: не удалось установить auto-detach:" << libusb_error_name(result);
+    }
+    
+    // Попытка заявить интерфейс (обычно интерфейс 0)
+    result = libusb_claim_interface(m_handle, 0);
+    if (result < 0) {
+        m_lastError = QString("Не удалось заявить интерфейс: %1").arg(libusb_error_name(result));
+        libusb_close(m_handle);
+        m_handle = nullptr;
+        return false;
+    }
+    
+    m_isOpen = true;
+    
+    if (!startReceiving(transferCount, transferSize)) {
+        const QString error = m_lastError;
+        close();
+        m_lastError = error;
+        return false;
+    }
+    
+    qDebug() << "USB устройство успешно открыто";
+    return true;
+}
+
+void LibusbBackend::close()
+{
+    stopReceiving();
+    
+    if (m_handle) {
+        libusb_release_interface(m_handle, 0);
+        libusb_close(m_handle);
+        m_handle = nullptr;
+    }
+    
+    m_isOpen = false;
+    qDebug() << "USB устройство закрыто";
+}
+
+bool LibusbBackend::isOpen() const
+{
+    return m_isOpen && m_handle != nullptr;
+}
+
+int LibusbBackend::write(const QByteArray &data)
+{
+    if (!isOpen()) {
+        m_lastError = "Устройство не открыто";
+        return -1;
+    }
+    
+    int transferred = 0;
+    int result = libusb_bulk_transfer(m_handle, BULK_OUT_ENDPOINT,
+                                      const_cast<unsigned char*>(reinterpret_cast<const unsigned char*>(data.constData())),
+                                      data.size(), &transferred, USB_TIMEOUT);
+    
+    // Таймаут (устройство отвечает NAK) - не ошибка: принятая часть возвращается,
+    // остаток можно записать позже
+    if (result < 0 && result != LIBUSB_ERROR_TIMEOUT) {
+        m_lastError = QString("Ошибка записи USB: %1").arg(libusb_error_name(result));
+        return -1;
+    }
+    
+    if (transferred != data.size()) {
+        m_lastError = QString("Записано %1 из %2 байт").arg(transferred).arg(data.size());
+    }
+    return transferred;
+}
+
+QByteArray LibusbBackend::read(int timeoutMs)
+{
+    // Синхронное чтение в обход асинхронного приема.
+    // Пока работает поток событий, данные забирают асинхронные запросы.
+    QByteArray data;
+    if (!isOpen()) {
+        return data;
+    }
+    
+    unsigned char buffer[512]; // Буфер для чтения
+    int transferred = 0;
+    int result = libusb_bulk_transfer(m_handle, BULK_IN_ENDPOINT,
+                                      buffer, sizeof(buffer), &transferred, timeoutMs);
+    
+    if (result == LIBUSB_SUCCESS && transferred > 0) {
+        data = QByteArray(reinterpret_cast<const char*>(buffer), transferred);
+    } else if (result != LIBUSB_ERROR_TIMEOUT) {
+        m_lastError = QString("Ошибка чтения USB: %1").arg(libusb_error_name(result));
+        reportError(m_lastError);
+    }
+    
+    return data;
+}
+
+bool LibusbBackend::startReceiving(int transferCount, int transferSize)
+{
+    m_stopping = false;
+    m_activeTransfers = 0;
+    
+    for (int i = 0; i < transferCount; ++i) {
+        libusb_transfer *transfer = libusb_alloc_transfer(0);
+        if (!transfer) {
+            m_lastError = "Не удалось выделить USB запрос";
+            stopReceiving();
+            return false;
+        }
+        
+        TransferSlot *slot = new TransferSlot;
+        slot->backend = this;
+        slot->transfer = transfer;
+        slot->buffer.resize(transferSize);
+        slot->active = false;
+        m_transfers.append(slot);
+        
+        // Таймаут 0: запрос ждет данных без ограничения по времени
+        libusb_fill_bulk_transfer(transfer, m_handle, BULK_IN_ENDPOINT,
+                                  reinterpret_cast<unsigned char*>(slot->buffer.data()),
+                                  slot->buffer.size(), &TransferSlot::onTransferComplete,
+                                  slot, 0);
+        
+        int result = libusb_submit_transfer(transfer);
+        if (result != LIBUSB_SUCCESS) {
+            m_lastError = QString("Не удалось запустить прием USB: %1").arg(libusb_error_name(result));
+            stopReceiving();
+            return false;
+        }
+        slot->active = true;
+        m_activeTransfers++;
+    }
+    
+    // Отдельный поток обрабатывает события libusb, таймер GUI не используется
+    m_eventThread = QThread::create([this]() { runEventLoop(); });
+    m_eventThread->setObjectName("USBEventThread");
+    m_eventThread->start(QThread::TimeCriticalPriority);
+    return true;
+}
+
+void LibusbBackend::stopReceiving()
+{
+    m_stopping = true;
+    
+    for (TransferSlot *slot : m_transfers) {
+        libusb_cancel_transfer(slot->transfer);
+    }
+    
+    if (m_eventThread) {
+        // Поток завершится, когда все отмененные запросы вернутся
+        m_eventThread->wait();
+        delete m_eventThread;
+        m_eventThread = nullptr;
+    }
+    
+    // Если поток не запускался или вышел по ошибке, дожидаемся отмены здесь.
+    // Ошибки обработки событий не прерывают ожидание: запрос можно освободить
+    // только после того, как libusb его вернул.
+    for (int i = 0; i < STOP_WAIT_STEPS && m_activeTransfers > 0 && m_context; ++i) {
+        struct timeval timeout = {0, STOP_WAIT_STEP_US};
+        const int result = libusb_handle_events_timeout_completed(m_context, &timeout, nullptr);
+        if (result < 0 && result != LIBUSB_ERROR_INTERRUPTED) {
+            qDebug() << "Ошибка обработки событий libusb при остановке:" << libusb_error_name(result);
+        }
+    }
+    
+    // Запросы, которые так и не вернулись, намеренно не освобождаются:
+    // поздний вызов onTransferComplete писал бы в освобожденную память
+    int abandoned = 0;
+    for (TransferSlot *slot : m_transfers) {
+        if (slot->active) {
+            slot->backend = nullptr;
+            abandoned++;
+            continue;
+        }
+        libusb_free_transfer(slot->transfer);
+        delete slot;
+    }
+    if (abandoned > 0) {
+        qDebug() << "USB: отмененные запросы не вернулись, оставлены без освобождения:" << abandoned;
+    }
+    m_transfers.clear();
+    m_activeTransfers = 0;
+}
+
+void LibusbBackend::runEventLoop()
+{
+    // Короткий таймаут нужен только для проверки флага остановки
+    while (!m_stopping || m_activeTransfers > 0) {
+        struct timeval timeout = {0, 100000}; // 100 мс
+        int result = libusb_handle_events_timeout_completed(m_context, &timeout, nullptr);
+        if (result < 0 && result != LIBUSB_ERROR_INTERRUPTED) {
+            qDebug() << "Ошибка обработки событий libusb:" << libusb_error_name(result);
+            break;
+        }
+    }
+}
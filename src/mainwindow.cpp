@@ -4,12 +4,16 @@
 #include <QRegularExpression>
 #include <QRegularExpressionValidator>
 #include <QHeaderView>
+#include <QScrollBar>
+#include <QSortFilterProxyModel>
 #include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSignalBlocker>
 #include <QTextStream>
 #include <QKeyEvent>
 #include <QCloseEvent>
 #include <QSettings>
-#include <QTableWidgetItem>
 #include <QAbstractItemView>
 #include <QBrush>
 #include <QColor>
@@ -18,11 +22,21 @@
 #include <QTabWidget>
 #include <QTextBrowser>
 #include <QEventLoop>
+#include <QProgressDialog>
 #include "udsprotocol.h"
 #include "obd2protocol.h"
+#include "frameconsumer.h"
+#include "messagetablemodel.h"
+#include "eventlogview.h"
+#include "idoverviewmodel.h"
+#include "capturetablemodel.h"
+#include "tracefile.h"
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
+    , m_viewingFile(false)
+    , m_statsDirty(false)
+    , m_uiLagNs(0)
     , m_isConnected(false)
     , m_useTableView(true)
 {
@@ -31,16 +45,16 @@ MainWindow::MainWindow(QWidget *parent)
     loadSettings();
     
     m_canInterface = new CANInterface(this);
-    connect(m_canInterface, &CANInterface::messageReceived, 
-            this, &MainWindow::onCanMessageReceived);
-    connect(m_canInterface, &CANInterface::messageReceivedDetailed,
-            this, &MainWindow::onCanMessageReceivedDetailed);
+    // Принятые кадры забираются из собственной очереди UI по такту отрисовки
+    m_uiConsumer = m_canInterface->createConsumer("ui");
     connect(m_canInterface, &CANInterface::connectionStatusChanged, 
             this, &MainWindow::onConnectionStatusChanged);
     connect(m_canInterface, &CANInterface::errorOccurred, 
             this, &MainWindow::onErrorOccurred);
     connect(m_canInterface, &CANInterface::statisticsUpdated,
             this, &MainWindow::onStatisticsUpdated);
+    connect(m_canInterface, &CANInterface::recordingFinished,
+            this, &MainWindow::onRecordingFinished);
     
     // Инициализация диагностических протоколов
     m_udsProtocol = new UDSProtocol(m_canInterface, this);
@@ -54,6 +68,15 @@ MainWindow::MainWindow(QWidget *parent)
     connect(m_obd2Protocol, &OBD2Protocol::errorOccurred, 
             this, &MainWindow::onDiagnosticError);
     
+    // Такт UI: все накопленные кадры и статистика применяются одной пачкой
+    // не чаще частоты отрисовки (30 или 60 Гц, настройка uiRefreshRate)
+    const int refreshRate = QSettings().value("uiRefreshRate", DEFAULT_UI_REFRESH_RATE).toInt() >= 60 ? 60 : 30;
+    m_uiTimer = new QTimer(this);
+    m_uiTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_uiTimer, &QTimer::timeout, this, &MainWindow::onUiTick);
+    m_uiTimer->start(1000 / refreshRate);
+    m_uiLagClock.start();
+    
     // Автообновление списка портов каждые 5 секунд
     m_autoRefreshTimer = new QTimer(this);
     connect(m_autoRefreshTimer, &QTimer::timeout, this, &MainWindow::onAutoRefreshPorts);
@@ -65,6 +88,7 @@ MainWindow::MainWindow(QWidget *parent)
 MainWindow::~MainWindow()
 {
     saveSettings();
+    closeFileView();
     if (m_isConnected) {
         m_canInterface->disconnect();
     }
@@ -90,9 +114,9 @@ void MainWindow::setupUI()
         "QComboBox::drop-down { border: none; background-color: #3C3C3C; }"
         "QComboBox::down-arrow { image: none; border-left: 4px solid transparent; border-right: 4px solid transparent; border-top: 4px solid #CCCCCC; }"
         "QComboBox QAbstractItemView { border: 1px solid #3C3C3C; border-radius: 4px; background-color: #252526; selection-background-color: #0E639C; selection-color: #FFFFFF; color: #CCCCCC; }"
-        "QTableWidget { border: 1px solid #3C3C3C; border-radius: 5px; background-color: #252526; gridline-color: #2D2D30; alternate-background-color: #2D2D30; color: #CCCCCC; }"
-        "QTableWidget::item { padding: 6px; color: #CCCCCC; }"
-        "QTableWidget::item:selected { background-color: #264F78; color: #FFFFFF; }"
+        "QTableView { border: 1px solid #3C3C3C; border-radius: 5px; background-color: #252526; gridline-color: #2D2D30; alternate-background-color: #2D2D30; color: #CCCCCC; }"
+        "QTableView::item { padding: 6px; color: #CCCCCC; }"
+        "QTableView::item:selected { background-color: #264F78; color: #FFFFFF; }"
         "QHeaderView::section { background-color: #2D2D30; color: #CCCCCC; padding: 10px; border: none; border-bottom: 1px solid #3C3C3C; font-weight: 600; }"
         "QTabWidget::pane { border: 1px solid #3C3C3C; border-radius: 6px; background-color: #252526; top: -1px; }"
         "QTabBar::tab { background-color: #2D2D30; color: #858585; padding: 10px 24px; border-top-left-radius: 6px; border-top-right-radius: 6px; margin-right: 2px; font-weight: 500; }"
@@ -197,17 +221,23 @@ void MainWindow::setupUI()
     m_filterIdEdit->setValidator(new QRegularExpressionValidator(QRegularExpression("[0-9A-Fa-f]{1,8}"), this));
     m_addFilterButton = new QPushButton("Добавить", this);
     m_clearFiltersButton = new QPushButton("Очистить", this);
+    m_filterExpressionEdit = new QLineEdit(this);
+    m_filterExpressionEdit->setPlaceholderText("id == 0x7E8 && data[1] == 0x62");
+    m_filterExpressionEdit->setToolTip("Фильтр по содержимому: id, dlc, ext, data[N], data[N].бит, word[N],\n"
+                                       "& == != < <= > >= ! && || ( ). Enter - применить, пусто - выключить.");
     
     connect(m_filterEnabledCheck, &QCheckBox::toggled, this, &MainWindow::onFilterToggled);
     connect(m_addFilterButton, &QPushButton::clicked, this, &MainWindow::onAddFilterClicked);
     connect(m_clearFiltersButton, &QPushButton::clicked, this, &MainWindow::onClearFiltersClicked);
+    connect(m_filterExpressionEdit, &QLineEdit::returnPressed, this, &MainWindow::onFilterExpressionEntered);
     
     filterLayout->addWidget(m_filterEnabledCheck);
     filterLayout->addWidget(new QLabel("ID:", this));
     filterLayout->addWidget(m_filterIdEdit);
     filterLayout->addWidget(m_addFilterButton);
     filterLayout->addWidget(m_clearFiltersButton);
-    filterLayout->addStretch();
+    filterLayout->addWidget(new QLabel("Выражение:", this));
+    filterLayout->addWidget(m_filterExpressionEdit, 1);
     
     // Таблица сообщений
     QGroupBox *logGroup = new QGroupBox("📋 Сообщения", this);
@@ -219,35 +249,118 @@ void MainWindow::setupUI()
     m_saveLogButton = new QPushButton("Сохранить", this);
     connect(m_clearLogButton, &QPushButton::clicked, this, &MainWindow::onClearLogClicked);
     connect(m_saveLogButton, &QPushButton::clicked, this, &MainWindow::onSaveLogClicked);
+    m_openTraceButton = new QPushButton("Открыть", this);
+    m_openTraceButton->setToolTip("Открыть трассу: файл записи .canrec просматривается без загрузки в память,\n"
+                                  "candump, Vector ASC и BLF загружаются в таблицу");
+    connect(m_openTraceButton, &QPushButton::clicked, this, &MainWindow::onOpenTraceClicked);
     logButtonsLayout->addWidget(m_clearLogButton);
     logButtonsLayout->addWidget(m_saveLogButton);
+    logButtonsLayout->addWidget(m_openTraceButton);
+    // Непрерывная запись всех кадров в файлы .canrec
+    m_recordButton = new QPushButton("Запись", this);
+    m_recordButton->setCheckable(true);
+    connect(m_recordButton, &QPushButton::toggled, this, &MainWindow::onRecordToggled);
+    logButtonsLayout->addWidget(m_recordButton);
     logButtonsLayout->addStretch();
     
-    m_messageTable = new QTableWidget(this);
-    m_messageTable->setColumnCount(4);
-    m_messageTable->setHorizontalHeaderLabels(QStringList() << "Время" << "ID" << "Данные" << "Направление");
+    // Обзор по ID: одна строка на ID вместо прокручиваемой трассы
+    m_overviewCheck = new QCheckBox("Обзор по ID", this);
+    connect(m_overviewCheck, &QCheckBox::toggled, this, &MainWindow::onOverviewToggled);
+    logButtonsLayout->addWidget(m_overviewCheck);
+    
+    // Каналы журнала: выключенные не форматируются и не выводятся
+    const QList<QPair<QString, EventLogView::Channel>> logChannels = {
+        {"RX", EventLogView::RxChannel},
+        {"TX", EventLogView::TxChannel},
+        {"Ошибки", EventLogView::ErrorChannel}
+    };
+    for (const auto &logChannel : logChannels) {
+        QCheckBox *channelCheck = new QCheckBox(logChannel.first, this);
+        channelCheck->setChecked(true);
+        const EventLogView::Channel channel = logChannel.second;
+        connect(channelCheck, &QCheckBox::toggled, this, [this, channel](bool enabled) {
+            m_logView->setChannelEnabled(channel, enabled);
+        });
+        logButtonsLayout->addWidget(channelCheck);
+    }
+    
+    // Просмотр файла: для записи .canrec - выборка по ID и интервалу времени
+    // через индекс файла
+    m_captureBar = new QWidget(this);
+    QHBoxLayout *captureLayout = new QHBoxLayout(m_captureBar);
+    captureLayout->setContentsMargins(0, 0, 0, 0);
+    m_captureFileLabel = new QLabel(this);
+    m_captureFilters = new QWidget(this);
+    QHBoxLayout *filtersLayout = new QHBoxLayout(m_captureFilters);
+    filtersLayout->setContentsMargins(0, 0, 0, 0);
+    m_captureIdEdit = new QLineEdit(this);
+    m_captureIdEdit->setPlaceholderText("все");
+    m_captureIdEdit->setToolTip("CAN ID (hex); больше 3 цифр или больше 7FF - расширенный ID");
+    m_captureIdEdit->setMaximumWidth(120);
+    m_captureIdEdit->setValidator(new QRegularExpressionValidator(QRegularExpression("[0-9A-Fa-f]{1,8}"), this));
+    m_captureFromEdit = new QLineEdit(this);
+    m_captureToEdit = new QLineEdit(this);
+    for (QLineEdit *edit : {m_captureFromEdit, m_captureToEdit}) {
+        edit->setToolTip("Секунды от начала файла");
+        edit->setMaximumWidth(100);
+        edit->setValidator(new QRegularExpressionValidator(QRegularExpression("[0-9]{1,9}([.,][0-9]{0,9})?"), this));
+        connect(edit, &QLineEdit::returnPressed, this, &MainWindow::onApplyCaptureSelection);
+    }
+    m_captureFromEdit->setPlaceholderText("начало");
+    m_captureToEdit->setPlaceholderText("конец");
+    connect(m_captureIdEdit, &QLineEdit::returnPressed, this, &MainWindow::onApplyCaptureSelection);
+    QPushButton *applyCaptureButton = new QPushButton("Применить", this);
+    QPushButton *closeCaptureButton = new QPushButton("Закрыть файл", this);
+    connect(applyCaptureButton, &QPushButton::clicked, this, &MainWindow::onApplyCaptureSelection);
+    connect(closeCaptureButton, &QPushButton::clicked, this, &MainWindow::onCloseCaptureClicked);
+    filtersLayout->addWidget(new QLabel("ID:", this));
+    filtersLayout->addWidget(m_captureIdEdit);
+    filtersLayout->addWidget(new QLabel("с, от:", this));
+    filtersLayout->addWidget(m_captureFromEdit);
+    filtersLayout->addWidget(new QLabel("до:", this));
+    filtersLayout->addWidget(m_captureToEdit);
+    filtersLayout->addWidget(applyCaptureButton);
+    captureLayout->addWidget(m_captureFileLabel, 1);
+    captureLayout->addWidget(m_captureFilters);
+    captureLayout->addWidget(closeCaptureButton);
+    m_captureBar->hide();
+    m_captureModel = new CaptureTableModel(this);
+    m_importModel = new MessageTableModel(this);
+    
+    // Таблица только отображает видимые строки модели, история хранится кольцом
+    m_messageModel = new MessageTableModel(this);
+    m_messageTable = new QTableView(this);
+    m_messageTable->setModel(m_messageModel);
     m_messageTable->horizontalHeader()->setStretchLastSection(true);
     m_messageTable->setAlternatingRowColors(true);
     m_messageTable->setSelectionBehavior(QAbstractItemView::SelectRows);
     m_messageTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
     m_messageTable->setShowGrid(true);
     m_messageTable->verticalHeader()->setVisible(false);
+    // Фиксированная высота строк: без измерения содержимого каждой строки
+    m_messageTable->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    m_messageTable->verticalHeader()->setDefaultSectionSize(22);
     m_messageTable->setFont(QFont("Courier New", 9));
     
     // Настройка ширины колонок
-    m_messageTable->setColumnWidth(0, 150); // Время
-    m_messageTable->setColumnWidth(1, 100);  // ID
-    m_messageTable->setColumnWidth(2, 300);  // Данные
+    m_messageTable->setColumnWidth(MessageTableModel::TimeColumn, 150);
+    m_messageTable->setColumnWidth(MessageTableModel::IdColumn, 100);
+    m_messageTable->setColumnWidth(MessageTableModel::DataColumn, 300);
+    
+    m_overviewModel = new IdOverviewModel(this);
+    m_overviewProxy = new QSortFilterProxyModel(this);
+    m_overviewProxy->setSourceModel(m_overviewModel);
+    m_overviewProxy->setSortRole(IdOverviewModel::SortRole);
     
-    m_logTextEdit = new QTextEdit(this);
-    m_logTextEdit->setReadOnly(true);
-    m_logTextEdit->setFont(QFont("Courier New", 9));
-    m_logTextEdit->setMaximumHeight(120);
-    m_logTextEdit->show(); // Показываем лог по умолчанию
+    m_logView = new EventLogView(this);
+    m_logView->setFont(QFont("Courier New", 9));
+    m_logView->setMaximumHeight(120);
+    m_logView->show(); // Показываем лог по умолчанию
     
     logLayout->addLayout(logButtonsLayout);
+    logLayout->addWidget(m_captureBar);
     logLayout->addWidget(m_messageTable, 1);
-    logLayout->addWidget(m_logTextEdit);
+    logLayout->addWidget(m_logView);
     
     canTabLayout->addWidget(sendGroup);
     canTabLayout->addWidget(filterGroup);
@@ -268,7 +381,11 @@ void MainWindow::setupUI()
     m_statsLabel = new QLabel("", this);
     m_statsLabel->setStyleSheet("color: #FFFFFF;");
     statusBar()->addWidget(m_statusLabel);
+    m_uiLagLabel = new QLabel("Задержка UI: 0 мс", this);
+    m_uiLagLabel->setStyleSheet("color: #858585;");
+    m_uiLagLabel->setToolTip("Возраст самого старого кадра на момент отображения, максимум за 0.5 с");
     statusBar()->addPermanentWidget(m_statsLabel);
+    statusBar()->addPermanentWidget(m_uiLagLabel);
     
     // Обновление списка портов
     m_canInterface->refreshPortList();
@@ -292,6 +409,11 @@ void MainWindow::onConnectClicked()
         if (portName.contains("USB (прямое подключение", Qt::CaseInsensitive)) {
             logMessage(QString("Попытка прямого USB подключения со скоростью %1 кбит/с...").arg(baudRate));
             success = m_canInterface->connectUSB(0x20A2, 0x0001, baudRate);
+        } else if (portName.startsWith(CANInterface::SOCKETCAN_PORT_PREFIX)) {
+            // Скорость шины SocketCAN задается при настройке интерфейса
+            QString interfaceName = portName.mid(QString(CANInterface::SOCKETCAN_PORT_PREFIX).size());
+            logMessage(QString("Попытка подключения к SocketCAN интерфейсу %1...").arg(interfaceName));
+            success = m_canInterface->connectSocketCan(interfaceName);
         } else {
             logMessage(QString("Попытка подключения к %1 со скоростью %2 кбит/с...")
                        .arg(portName).arg(baudRate));
@@ -378,31 +500,78 @@ void MainWindow::onSendClicked()
         QString logMsg = QString("Отправлено: ID=0x%1, Данные=%2")
                          .arg(canId, 0, 16).arg(canDataStr.toUpper());
         logMessage(logMsg, "SEND");
-        addMessageToTable(canId, data, QDateTime::currentDateTime(), false);
+        m_messageModel->append(CanFrame::make(canId, data, CanClock::nowNs(), CanFrame::FLAG_TX));
     } else {
         logMessage("Ошибка отправки сообщения", "ERROR");
     }
 }
 
-void MainWindow::onCanMessageReceived(const QString &message)
+void MainWindow::onUiTick()
 {
-    logMessage(message, "RECV");
+    // Данные забираются полностью, сокращается только работа отрисовки
+    m_uiFrames.clear();
+    m_uiConsumer->drain(m_uiFrames);
+    
+    const quint64 now = CanClock::nowNs();
+    if (!m_uiFrames.isEmpty()) {
+        // Задержка отображения - возраст самого старого кадра пачки
+        m_uiLagNs = qMax(m_uiLagNs, now - qMin(now, m_uiFrames.first().timestampNs));
+        logReceivedFrames(m_uiFrames);
+        m_messageModel->append(m_uiFrames.constData(), m_uiFrames.size());
+    }
+    if (m_viewingFile && !m_overviewCheck->isChecked()) {
+        // В таблице файл, живая трасса накапливается без отрисовки
+        m_messageModel->flush();
+    } else if (m_overviewCheck->isChecked()) {
+        // Трасса продолжает накапливаться без отрисовки
+        m_messageModel->flush();
+        m_canInterface->latestIdStatistics(m_overviewFrames);
+        m_overviewModel->update(m_overviewFrames);
+    } else {
+        flushMessageTable();
+    }
+    m_logView->flush();
+    
+    if (m_statsDirty) {
+        m_statsDirty = false;
+        updateStatisticsDisplay();
+    }
+    
+    // Индикатор обновляется несколько раз в секунду, показывает максимум за период
+    if (m_uiLagClock.elapsed() >= UI_LAG_UPDATE_INTERVAL) {
+        m_uiLagClock.restart();
+        updateUiLagDisplay();
+        m_uiLagNs = 0;
+    }
 }
 
-void MainWindow::onCanMessageReceivedDetailed(quint32 id, const QByteArray &data, const QDateTime &timestamp)
+void MainWindow::logReceivedFrames(const QVector<CanFrame> &frames)
 {
-    // Форматируем сообщение для лога
-    QString dataStr;
-    for (int i = 0; i < data.size(); ++i) {
-        if (i > 0) dataStr += " ";
-        dataStr += QString("%1").arg(static_cast<quint8>(data[i]), 2, 16, QChar('0')).toUpper();
-    }
-    QString logMsg = QString("Принято: ID=0x%1, Данные=%2")
-                     .arg(id, 0, 16).arg(dataStr);
-    logMessage(logMsg, "RECV");
-    
-    // Добавляем в таблицу
-    addMessageToTable(id, data, timestamp, true);
+    // Отставание отрисовки: в лог идут первые кадры пачки и одна сводная строка
+    const int logged = qMin(static_cast<int>(frames.size()), MAX_LOGGED_FRAMES_PER_TICK);
+    for (int i = 0; i < logged; ++i) {
+        const CanFrame &frame = frames[i];
+        QString dataStr;
+        for (int j = 0; j < frame.dlc; ++j) {
+            if (j > 0) dataStr += " ";
+            dataStr += QString("%1").arg(frame.data[j], 2, 16, QChar('0')).toUpper();
+        }
+        logMessage(QString("Принято: ID=0x%1, Данные=%2").arg(frame.id, 0, 16).arg(dataStr), "RECV");
+    }
+    if (frames.size() > logged) {
+        logMessage(QString("Принято еще %1 кадров (в таблице)").arg(frames.size() - logged), "RECV");
+    }
+}
+
+void MainWindow::updateUiLagDisplay()
+{
+    const qint64 lagMs = static_cast<qint64>(m_uiLagNs / 1000000);
+    const qint64 backlog = m_uiConsumer->pending();
+    m_uiLagLabel->setText(QString("Задержка UI: %1 мс").arg(lagMs));
+    
+    // Отрисовка отстает от приема: очередь UI копится или кадры ждут дольше порога
+    const bool behind = lagMs > UI_LAG_WARNING_MS || backlog > m_uiConsumer->capacity() / 2;
+    m_uiLagLabel->setStyleSheet(behind ? "color: #F48771; font-weight: 600;" : "color: #858585;");
 }
 
 void MainWindow::onConnectionStatusChanged(bool connected)
@@ -426,31 +595,18 @@ void MainWindow::onErrorOccurred(const QString &error)
 
 void MainWindow::logMessage(const QString &message, const QString &type)
 {
-    QString timestamp = QDateTime::currentDateTime().toString("hh:mm:ss.zzz");
-    QString color;
-    
-    // Цвета для темной темы
+    // Строка попадает в журнал на ближайшем такте UI
     if (type == "ERROR") {
-        color = "#F48771"; // Мягкий красный
-    } else if (type == "SUCCESS") {
-        color = "#89D185"; // Мягкий зеленый
+        m_logView->append(EventLogView::ErrorChannel, type, message);
     } else if (type == "SEND") {
-        color = "#4EC9B0"; // Бирюзовый
+        m_logView->append(EventLogView::TxChannel, type, message);
     } else if (type == "RECV") {
-        color = "#CE9178"; // Оранжево-коричневый
+        m_logView->append(EventLogView::RxChannel, type, message);
+    } else if (type == "SUCCESS") {
+        m_logView->append(EventLogView::InfoChannel, type, message, QColor("#89D185")); // Мягкий зеленый
     } else {
-        color = "#CCCCCC"; // Светло-серый для обычных сообщений
+        m_logView->append(EventLogView::InfoChannel, type, message);
     }
-    
-    QString formattedMessage = QString("[%1] <span style='color: %2;'><b>%3</b></span> %4")
-                               .arg(timestamp, color, type, message);
-    
-    m_logTextEdit->append(formattedMessage);
-    
-    // Автопрокрутка вниз
-    QTextCursor cursor = m_logTextEdit->textCursor();
-    cursor.movePosition(QTextCursor::End);
-    m_logTextEdit->setTextCursor(cursor);
 }
 
 void MainWindow::onRefreshPortsClicked()
@@ -463,8 +619,8 @@ void MainWindow::onRefreshPortsClicked()
 
 void MainWindow::onClearLogClicked()
 {
-    m_logTextEdit->clear();
-    m_messageTable->setRowCount(0);
+    m_logView->clearLog();
+    m_messageModel->clear();
     logMessage("Лог очищен");
 }
 
@@ -473,9 +629,15 @@ void MainWindow::onSaveLogClicked()
     QString fileName = QFileDialog::getSaveFileName(this, "Сохранить лог", 
                                                     QString("can_log_%1.txt")
                                                     .arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")),
-                                                    "Текстовые файлы (*.txt);;CSV файлы (*.csv)");
+                                                    "Текстовые файлы (*.txt);;CSV файлы (*.csv);;" + traceFileFilter());
     if (fileName.isEmpty()) return;
     
+    // Кадры таблицы в формате трассы: без потерь, в отличие от CSV
+    if (traceFormatForFileName(fileName) != TraceFormat::Unknown) {
+        exportTrace(fileName);
+        return;
+    }
+    
     QFile file(fileName);
     if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
         QTextStream out(&file);
@@ -483,15 +645,18 @@ void MainWindow::onSaveLogClicked()
         if (fileName.endsWith(".csv")) {
             // CSV формат
             out << "Время,ID,Данные,Направление\n";
-            for (int i = 0; i < m_messageTable->rowCount(); ++i) {
-                out << m_messageTable->item(i, 0)->text() << ","
-                    << m_messageTable->item(i, 1)->text() << ","
-                    << m_messageTable->item(i, 2)->text() << ","
-                    << m_messageTable->item(i, 3)->text() << "\n";
+            const int rows = exportRowCount();
+            for (int row = 0; row < rows; ++row) {
+                const CanFrame frame = exportFrameAt(row);
+                out << MessageTableModel::frameCellText(frame, MessageTableModel::TimeColumn) << ","
+                    << MessageTableModel::frameCellText(frame, MessageTableModel::IdColumn) << ","
+                    << MessageTableModel::frameCellText(frame, MessageTableModel::DataColumn) << ","
+                    << MessageTableModel::frameCellText(frame, MessageTableModel::DirectionColumn) << "\n";
             }
         } else {
             // Текстовый формат
-            out << m_logTextEdit->toPlainText();
+            m_logView->flush();
+            out << m_logView->toPlainText();
         }
         
         file.close();
@@ -501,6 +666,280 @@ void MainWindow::onSaveLogClicked()
     }
 }
 
+void MainWindow::exportTrace(const QString &fileName)
+{
+    std::unique_ptr<TraceWriter> writer = createTraceWriter(traceFormatForFileName(fileName));
+    if (!writer->open(fileName)) {
+        logMessage(QString("Ошибка сохранения файла: %1").arg(writer->errorString()), "ERROR");
+        return;
+    }
+    
+    QVector<CanFrame> batch;
+    batch.reserve(TRACE_BATCH_FRAMES);
+    const int rows = exportRowCount();
+    bool ok = true;
+    for (int row = 0; row < rows && ok; ++row) {
+        batch.append(exportFrameAt(row));
+        if (batch.size() == TRACE_BATCH_FRAMES || row == rows - 1) {
+            ok = writer->write(batch.constData(), batch.size());
+            batch.clear();
+        }
+    }
+    ok = writer->close() && ok;
+    
+    if (ok) {
+        logMessage(QString("Трасса сохранена в файл: %1 (%2 кадров)").arg(fileName).arg(rows), "SUCCESS");
+    } else {
+        logMessage(QString("Ошибка сохранения файла: %1").arg(writer->errorString()), "ERROR");
+    }
+}
+
+void MainWindow::onOpenTraceClicked()
+{
+    const QString fileName = QFileDialog::getOpenFileName(this, "Открыть трассу", QString(), traceFileFilter());
+    if (fileName.isEmpty()) return;
+    
+    const TraceFormat format = detectTraceFormat(fileName);
+    if (format == TraceFormat::Capture) {
+        openCapture(fileName);
+    } else {
+        importTrace(fileName, format);
+    }
+}
+
+void MainWindow::importTrace(const QString &fileName, TraceFormat format)
+{
+    std::unique_ptr<TraceReader> reader = createTraceReader(format);
+    if (!reader) {
+        logMessage(QString("Неизвестный формат трассы: %1").arg(fileName), "ERROR");
+        return;
+    }
+    if (!reader->open(fileName)) {
+        logMessage(reader->errorString(), "ERROR");
+        return;
+    }
+    
+    // Трасса загружается в отдельную модель: живые кадры, принятые пока идет
+    // загрузка (окно прогресса обрабатывает события), в нее не попадают.
+    // Файл читается пачками; в модели остаются последние кадры в пределах
+    // емкости таблицы, так что размер трассы не ограничен памятью.
+    closeFileView();
+    m_importModel->clear();
+    m_importModel->setCapacity(m_messageModel->capacity());
+    QProgressDialog progress(QString("Загрузка %1...").arg(QFileInfo(fileName).fileName()), "Отмена", 0, 1000, this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+    
+    QVector<CanFrame> batch(TRACE_BATCH_FRAMES);
+    quint64 total = 0;
+    int count;
+    while ((count = reader->read(batch.data(), batch.size())) > 0) {
+        m_importModel->append(batch.constData(), count);
+        m_importModel->flush();
+        total += count;
+        const qint64 size = reader->size();
+        progress.setValue(size > 0 ? static_cast<int>(reader->position() * 1000 / size) : 0);
+        if (progress.wasCanceled()) {
+            break;
+        }
+    }
+    progress.reset();
+    
+    showFileView(m_importModel, QString("%1 (%2): %3 кадров")
+                                .arg(QFileInfo(fileName).fileName(), traceFormatName(format))
+                                .arg(m_importModel->rowCount()), false);
+    if (count < 0) {
+        logMessage(QString("Ошибка чтения трассы: %1").arg(reader->errorString()), "ERROR");
+    }
+    QString message = QString("Загружено %1 кадров из %2 (%3)")
+                      .arg(total).arg(fileName, traceFormatName(format));
+    if (reader->skippedRecords() > 0) {
+        message += QString(", пропущено записей: %1").arg(reader->skippedRecords());
+    }
+    logMessage(message, count < 0 ? "ERROR" : "SUCCESS");
+}
+
+void MainWindow::openCapture(const QString &fileName)
+{
+    closeFileView();
+    
+    // Индекс строится один раз и сохраняется рядом с файлом
+    QProgressDialog progress(QString("Индексирование %1...").arg(QFileInfo(fileName).fileName()), "Отмена", 0, 1000, this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+    const bool opened = m_capture.open(fileName, [&progress](qint64 done, qint64 total) {
+        progress.setValue(total > 0 ? static_cast<int>(done * 1000 / total) : 0);
+        return !progress.wasCanceled();
+    });
+    progress.reset();
+    if (!opened) {
+        logMessage(m_capture.errorString(), "ERROR");
+        return;
+    }
+    
+    m_captureModel->setCapture(&m_capture);
+    const double duration = (m_capture.lastTimestampNs() - m_capture.firstTimestampNs()) / 1e9;
+    m_captureIdEdit->clear();
+    m_captureFromEdit->clear();
+    m_captureToEdit->clear();
+    showFileView(m_captureModel, QString("%1: %2 кадров, %3 с")
+                                 .arg(QFileInfo(fileName).fileName())
+                                 .arg(m_capture.frameCount())
+                                 .arg(duration, 0, 'f', 3), true);
+    logMessage(QString("Открыт файл записи %1: %2 кадров, %3 ID, индекс %4")
+               .arg(fileName)
+               .arg(m_capture.frameCount())
+               .arg(m_capture.idCount())
+               .arg(m_capture.indexLoaded() ? QString("загружен") : QString("построен")), "SUCCESS");
+}
+
+void MainWindow::showFileView(QAbstractItemModel *model, const QString &description, bool captureFilters)
+{
+    // Обзор по ID показывает живые данные адаптера, с файлом он не совмещается
+    m_overviewCheck->setChecked(false);
+    m_overviewCheck->setEnabled(false);
+    m_messageTable->setModel(model);
+    m_messageTable->setColumnWidth(MessageTableModel::TimeColumn, 150);
+    m_messageTable->setColumnWidth(MessageTableModel::IdColumn, 100);
+    m_messageTable->setColumnWidth(MessageTableModel::DataColumn, 300);
+    m_messageTable->scrollToTop();
+    
+    m_captureFileLabel->setText(description);
+    m_captureFilters->setVisible(captureFilters);
+    m_captureBar->show();
+    m_viewingFile = true;
+}
+
+void MainWindow::closeFileView()
+{
+    if (!m_viewingFile) {
+        return;
+    }
+    m_viewingFile = false;
+    m_messageTable->setModel(m_messageModel);
+    m_messageTable->setColumnWidth(MessageTableModel::TimeColumn, 150);
+    m_messageTable->setColumnWidth(MessageTableModel::IdColumn, 100);
+    m_messageTable->setColumnWidth(MessageTableModel::DataColumn, 300);
+    m_messageTable->scrollToBottom();
+    m_captureModel->setCapture(nullptr);
+    m_capture.close();
+    m_importModel->clear();
+    m_captureBar->hide();
+    m_overviewCheck->setEnabled(true);
+}
+
+// Сохраняется то, что показано в таблице: текущая выборка файла записи,
+// загруженная трасса или живые кадры
+int MainWindow::exportRowCount() const
+{
+    const QAbstractItemModel *model = m_messageTable->model();
+    if (model == m_captureModel) {
+        return m_captureModel->rowCount();
+    }
+    return model == m_importModel ? m_importModel->rowCount() : m_messageModel->rowCount();
+}
+
+CanFrame MainWindow::exportFrameAt(int row) const
+{
+    const QAbstractItemModel *model = m_messageTable->model();
+    if (model == m_captureModel) {
+        return m_captureModel->frameAt(row);
+    }
+    return model == m_importModel ? m_importModel->frameAt(row) : m_messageModel->frameAt(row);
+}
+
+void MainWindow::onCloseCaptureClicked()
+{
+    closeFileView();
+}
+
+void MainWindow::onApplyCaptureSelection()
+{
+    if (!m_capture.isOpen()) {
+        return;
+    }
+    
+    CaptureSelection selection;
+    const QString idText = m_captureIdEdit->text().trimmed();
+    if (!idText.isEmpty()) {
+        bool ok = false;
+        selection.allIds = false;
+        selection.id = idText.toUInt(&ok, 16);
+        if (!ok || selection.id > 0x1FFFFFFF) {
+            logMessage("Неверный CAN ID", "ERROR");
+            return;
+        }
+        selection.extended = idText.size() > 3 || selection.id > 0x7FF;
+    }
+    
+    // Границы - секунды от первого кадра файла
+    const QString fromText = m_captureFromEdit->text().trimmed().replace(',', '.');
+    const QString toText = m_captureToEdit->text().trimmed().replace(',', '.');
+    if (!fromText.isEmpty() || !toText.isEmpty()) {
+        const quint64 start = m_capture.firstTimestampNs();
+        selection.timeRange = true;
+        selection.fromNs = fromText.isEmpty() ? start : start + static_cast<quint64>(fromText.toDouble() * 1e9);
+        selection.toNs = toText.isEmpty() ? m_capture.lastTimestampNs()
+                                          : start + static_cast<quint64>(toText.toDouble() * 1e9);
+        if (selection.fromNs > selection.toNs) {
+            logMessage("Начало интервала позже конца", "ERROR");
+            return;
+        }
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    m_captureModel->setSelection(selection);
+    m_messageTable->scrollToTop();
+    logMessage(QString("Выборка из файла: %1 кадров за %2 мс")
+               .arg(m_captureModel->rowCount())
+               .arg(timer.elapsed()));
+}
+
+void MainWindow::onRecordToggled(bool enabled)
+{
+    if (!enabled) {
+        if (m_canInterface->isRecording()) {
+            // Накопленные буферы дописываются в фоне, итог - в onRecordingFinished
+            m_canInterface->stopRecording();
+            m_recordButton->setEnabled(false);
+            logMessage("Запись останавливается, сохраняются накопленные кадры...");
+        }
+        return;
+    }
+    
+    QSettings settings;
+    const QString directory = QFileDialog::getExistingDirectory(
+        this, "Каталог записи", settings.value("recordDirectory", QDir::homePath()).toString());
+    if (directory.isEmpty()) {
+        QSignalBlocker blocker(m_recordButton);
+        m_recordButton->setChecked(false);
+        return;
+    }
+    settings.setValue("recordDirectory", directory);
+    
+    FrameRecorder::Config config;
+    config.directory = directory;
+    if (!m_canInterface->startRecording(config)) {
+        QSignalBlocker blocker(m_recordButton);
+        m_recordButton->setChecked(false);
+        return;
+    }
+    logMessage(QString("Запись в каталог: %1").arg(directory), "SUCCESS");
+}
+
+void MainWindow::onRecordingFinished()
+{
+    m_recordButton->setEnabled(true);
+    const FrameRecorder::Statistics stats = m_canInterface->recordingStatistics();
+    logMessage(QString("Запись остановлена: %1 кадров, %2 МБ, файлов: %3, потеряно: %4")
+               .arg(stats.framesRecorded)
+               .arg(stats.bytesWritten / (1024.0 * 1024.0), 0, 'f', 1)
+               .arg(stats.filesCreated)
+               .arg(stats.framesDropped),
+               stats.framesDropped > 0 ? "ERROR" : "SUCCESS");
+}
+
 void MainWindow::onFilterToggled(bool enabled)
 {
     m_canInterface->setFilterEnabled(enabled);
@@ -533,9 +972,26 @@ void MainWindow::onClearFiltersClicked()
     logMessage("Все фильтры очищены");
 }
 
+void MainWindow::onFilterExpressionEntered()
+{
+    const QString expression = m_filterExpressionEdit->text().trimmed();
+    QString error;
+    if (!m_canInterface->setFilterExpression(expression, &error)) {
+        logMessage(QString("Ошибка в выражении фильтра: %1").arg(error), "ERROR");
+        return;
+    }
+    
+    if (expression.isEmpty()) {
+        logMessage("Фильтр по содержимому выключен");
+    } else {
+        logMessage(QString("Фильтр по содержимому: %1").arg(expression));
+    }
+}
+
 void MainWindow::onStatisticsUpdated()
 {
-    updateStatisticsDisplay();
+    // Надпись обновляется на ближайшем такте UI
+    m_statsDirty = true;
 }
 
 void MainWindow::updateStatisticsDisplay()
@@ -548,45 +1004,53 @@ void MainWindow::updateStatisticsDisplay()
                         .arg(stats.messagesReceived)
                         .arg(stats.errorsCount)
                         .arg(mps);
+    if (m_canInterface->isConnected() && m_canInterface->getBusLoad() > 0) {
+        statsText += QString(" | Загрузка: %1%").arg(m_canInterface->getBusLoad(), 0, 'f', 1);
+    }
+    if (m_uiConsumer->overflowCount() > 0) {
+        statsText += QString(" | Пропущено UI: %1").arg(m_uiConsumer->overflowCount());
+    }
+    if (m_canInterface->isRecording()) {
+        const FrameRecorder::Statistics recording = m_canInterface->recordingStatistics();
+        statsText += QString(" | Записано: %1").arg(recording.framesRecorded);
+        if (recording.framesDropped > 0) {
+            statsText += QString(" (потеряно %1)").arg(recording.framesDropped);
+        }
+    }
     m_statsLabel->setText(statsText);
 }
 
-void MainWindow::addMessageToTable(quint32 id, const QByteArray &data, const QDateTime &timestamp, bool isReceived)
+void MainWindow::flushMessageTable()
 {
-    int row = m_messageTable->rowCount();
-    m_messageTable->insertRow(row);
-    
-    // Время
-    m_messageTable->setItem(row, 0, new QTableWidgetItem(timestamp.toString("hh:mm:ss.zzz")));
-    
-    // ID
-    m_messageTable->setItem(row, 1, new QTableWidgetItem(QString("0x%1").arg(id, 0, 16).toUpper()));
-    
-    // Данные
-    QString dataStr;
-    for (int i = 0; i < data.size(); ++i) {
-        if (i > 0) dataStr += " ";
-        dataStr += QString("%1").arg(static_cast<quint8>(data[i]), 2, 16, QChar('0')).toUpper();
+    // Автопрокрутка, только если пользователь не листает историю
+    QScrollBar *scrollBar = m_messageTable->verticalScrollBar();
+    const bool atBottom = scrollBar->value() == scrollBar->maximum();
+    if (m_messageModel->flush() > 0 && atBottom) {
+        m_messageTable->scrollToBottom();
     }
-    m_messageTable->setItem(row, 2, new QTableWidgetItem(dataStr));
-    
-    // Направление
-    m_messageTable->setItem(row, 3, new QTableWidgetItem(isReceived ? "RX" : "TX"));
-    
-    // Цветовая подсветка для темной темы
-    if (isReceived) {
-        m_messageTable->item(row, 3)->setForeground(QBrush(QColor("#CE9178"))); // Оранжево-коричневый для RX
+}
+
+void MainWindow::onOverviewToggled(bool enabled)
+{
+    if (enabled) {
+        m_canInterface->latestIdStatistics(m_overviewFrames);
+        m_overviewModel->update(m_overviewFrames);
+        m_messageTable->setModel(m_overviewProxy);
+        m_messageTable->setSortingEnabled(true);
+        m_messageTable->sortByColumn(IdOverviewModel::IdColumn, Qt::AscendingOrder);
+        m_messageTable->setColumnWidth(IdOverviewModel::IdColumn, 100);
+        m_messageTable->setColumnWidth(IdOverviewModel::DirectionColumn, 60);
+        m_messageTable->setColumnWidth(IdOverviewModel::CountColumn, 90);
+        m_messageTable->setColumnWidth(IdOverviewModel::DataColumn, 200);
+        m_messageTable->setColumnWidth(IdOverviewModel::ChangesColumn, 200);
+        m_messageTable->setColumnWidth(IdOverviewModel::CycleColumn, 90);
     } else {
-        m_messageTable->item(row, 3)->setForeground(QBrush(QColor("#4EC9B0"))); // Бирюзовый для TX
-    }
-    
-    // Автопрокрутка к последней строке
-    m_messageTable->scrollToBottom();
-    
-    // Ограничение количества строк (удаляем старые)
-    const int MAX_ROWS = 1000;
-    while (m_messageTable->rowCount() > MAX_ROWS) {
-        m_messageTable->removeRow(0);
+        m_messageTable->setSortingEnabled(false);
+        m_messageTable->setModel(m_messageModel);
+        m_messageTable->setColumnWidth(MessageTableModel::TimeColumn, 150);
+        m_messageTable->setColumnWidth(MessageTableModel::IdColumn, 100);
+        m_messageTable->setColumnWidth(MessageTableModel::DataColumn, 300);
+        m_messageTable->scrollToBottom();
     }
 }
 
@@ -612,6 +1076,8 @@ void MainWindow::saveSettings()
     settings.setValue("windowState", saveState());
     settings.setValue("lastPort", m_portCombo->currentText());
     settings.setValue("lastBaudRate", m_baudRateCombo->currentIndex());
+    settings.setValue("messageTableCapacity", m_messageModel->capacity());
+    settings.setValue("logMaxLines", m_logView->maximumLines());
 }
 
 void MainWindow::loadSettings()
@@ -623,6 +1089,8 @@ void MainWindow::loadSettings()
     // Восстановление последних настроек
     QString lastPort = settings.value("lastPort").toString();
     int lastBaudIndex = settings.value("lastBaudRate", 1).toInt();
+    m_messageModel->setCapacity(settings.value("messageTableCapacity", MessageTableModel::DEFAULT_CAPACITY).toInt());
+    m_logView->setMaximumLines(settings.value("logMaxLines", EventLogView::DEFAULT_MAXIMUM_LINES).toInt());
     
     if (lastBaudIndex >= 0 && lastBaudIndex < m_baudRateCombo->count()) {
         m_baudRateCombo->setCurrentIndex(lastBaudIndex);
@@ -658,6 +1126,7 @@ void MainWindow::keyPressEvent(QKeyEvent *event)
 void MainWindow::closeEvent(QCloseEvent *event)
 {
     saveSettings();
+    closeFileView();
     if (m_isConnected) {
         m_canInterface->disconnect();
     }
@@ -0,0 +1,392 @@
+#include "mappedcapture.h"
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#ifdef Q_OS_LINUX
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+constexpr quint32 KEY_EXTENDED = 0x80000000;
+constexpr quint32 KEY_ERROR = 0x40000000;
+constexpr int PROGRESS_BLOCKS = 4096;         // Вызов progress раз на ~1 млн кадров
+
+} // namespace
+
+MappedCapture::MappedCapture()
+    : m_mapped(nullptr)
+    , m_frames(nullptr)
+    , m_frameCount(0)
+    , m_header()
+    , m_clockOffsetNs(0)
+    , m_indexLoaded(false)
+{
+    static_assert(sizeof(IndexFileHeader) == 64, "Заголовок индекса должен занимать 64 байта");
+    static_assert(sizeof(IndexIdEntry) == 12, "Запись таблицы ID индекса должна занимать 12 байт");
+}
+
+MappedCapture::~MappedCapture()
+{
+    close();
+}
+
+quint32 MappedCapture::keyOf(quint32 id, bool extended)
+{
+    return (id & 0x1FFFFFFF) | (extended ? KEY_EXTENDED : 0);
+}
+
+quint32 MappedCapture::keyOf(const CanFrame &frame)
+{
+    // Кадры ошибок отдельно: их ID - класс ошибки, а не адрес на шине
+    if (frame.flags & CanFrame::FLAG_ERROR) {
+        return (frame.id & 0x1FFFFFFF) | KEY_ERROR;
+    }
+    return keyOf(frame.id, frame.isExtended());
+}
+
+bool MappedCapture::open(const QString &path, const std::function<bool(qint64, qint64)> &progress)
+{
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_lastError = QString("Не удалось открыть %1: %2").arg(path, m_file.errorString());
+        return false;
+    }
+    
+    const qint64 size = m_file.size();
+    if (size < static_cast<qint64>(sizeof(CaptureFileHeader))) {
+        m_lastError = QString("%1 не является файлом записи").arg(path);
+        m_file.close();
+        return false;
+    }
+    m_mapped = m_file.map(0, size);
+    if (!m_mapped) {
+        m_lastError = QString("Не удалось отобразить %1 в память: %2").arg(path, m_file.errorString());
+        m_file.close();
+        return false;
+    }
+    
+    std::memcpy(&m_header, m_mapped, sizeof(m_header));
+    if (std::memcmp(m_header.magic, CaptureFileHeader::CAPTURE_MAGIC, sizeof(m_header.magic)) != 0
+        || m_header.headerSize < sizeof(CaptureFileHeader) || m_header.headerSize > size) {
+        m_lastError = QString("%1 не является файлом записи").arg(path);
+        close();
+        return false;
+    }
+    // Кадры используются прямо из отображения, поэтому только записи текущего формата
+    if (m_header.recordSize != sizeof(CanFrame) || m_header.headerSize % alignof(CanFrame) != 0) {
+        m_lastError = QString("Неподдерживаемый формат записи %1 (версия %2)").arg(path).arg(m_header.version);
+        close();
+        return false;
+    }
+    const quint64 frameCount = static_cast<quint64>(size - m_header.headerSize) / sizeof(CanFrame);
+    if (frameCount > std::numeric_limits<quint32>::max()) {
+        m_lastError = QString("Слишком большой файл записи: %1 кадров").arg(frameCount);
+        close();
+        return false;
+    }
+    m_frameCount = static_cast<quint32>(frameCount);
+    
+    // Метки CanClock записавшего процесса переводятся в текущие через календарное время
+    m_clockOffsetNs = CanClock::fromNsSinceEpoch(m_header.wallClockMs * 1000000) - m_header.monotonicNs;
+    
+    quint32 indexedFrames = 0;
+    m_indexLoaded = loadIndex();
+    if (m_indexLoaded) {
+        indexedFrames = static_cast<quint32>(m_blockMin.size()) * INDEX_BLOCK_FRAMES;
+    }
+    
+    // Первый проход по файлу последовательный, дальше доступ точечный
+    if (indexedFrames < m_frameCount) {
+        adviseAccess(true);
+        if (!buildIndex(indexedFrames, progress)) {
+            m_lastError = "Открытие прервано";
+            close();
+            return false;
+        }
+        // Без прав на запись в каталог индекс просто строится при каждом открытии
+        saveIndex();
+    }
+    adviseAccess(false);
+    finishIndex();
+    return true;
+}
+
+void MappedCapture::close()
+{
+    if (m_mapped) {
+        m_file.unmap(m_mapped);
+    }
+    m_file.close();
+    m_mapped = nullptr;
+    m_frames = nullptr;
+    m_frameCount = 0;
+    m_header = CaptureFileHeader();
+    m_clockOffsetNs = 0;
+    m_blockMin.clear();
+    m_blockMax.clear();
+    m_prefixMax.clear();
+    m_suffixMin.clear();
+    m_postings.clear();
+    m_indexLoaded = false;
+}
+
+void MappedCapture::adviseAccess(bool sequential)
+{
+#ifdef Q_OS_LINUX
+    // Без опережающего чтения запрос по ID читает только страницы своих блоков
+    madvise(m_mapped, static_cast<size_t>(m_file.size()), sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+#else
+    Q_UNUSED(sequential);
+#endif
+}
+
+bool MappedCapture::buildIndex(quint32 fromFrame, const std::function<bool(qint64, qint64)> &progress)
+{
+    m_frames = reinterpret_cast<const CanFrame*>(m_mapped + m_header.headerSize);
+    
+    QVector<quint32> *lastPosting = nullptr;
+    quint32 lastKey = 0;
+    int blocksSinceProgress = 0;
+    for (quint32 begin = fromFrame; begin < m_frameCount; begin += INDEX_BLOCK_FRAMES) {
+        const quint32 end = qMin<quint64>(m_frameCount, static_cast<quint64>(begin) + INDEX_BLOCK_FRAMES);
+        const quint32 block = begin / INDEX_BLOCK_FRAMES;
+        quint64 minNs = std::numeric_limits<quint64>::max();
+        quint64 maxNs = 0;
+        
+        for (quint32 i = begin; i < end; ++i) {
+            const CanFrame &frame = m_frames[i];
+            minNs = qMin(minNs, frame.timestampNs);
+            maxNs = qMax(maxNs, frame.timestampNs);
+            
+            // Подряд идущие кадры одного ID - без поиска в таблице
+            const quint32 key = keyOf(frame);
+            if (!lastPosting || key != lastKey) {
+                lastPosting = &m_postings[key];
+                lastKey = key;
+            }
+            if (lastPosting->isEmpty() || lastPosting->last() != block) {
+                lastPosting->append(block);
+            }
+        }
+        m_blockMin.append(minNs);
+        m_blockMax.append(maxNs);
+        
+        if (progress && ++blocksSinceProgress == PROGRESS_BLOCKS) {
+            blocksSinceProgress = 0;
+            if (!progress(end, m_frameCount)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void MappedCapture::finishIndex()
+{
+    m_frames = reinterpret_cast<const CanFrame*>(m_mapped + m_header.headerSize);
+    
+    const int blocks = m_blockMin.size();
+    m_prefixMax.resize(blocks);
+    m_suffixMin.resize(blocks);
+    quint64 runningMax = 0;
+    for (int i = 0; i < blocks; ++i) {
+        runningMax = qMax(runningMax, m_blockMax[i]);
+        m_prefixMax[i] = runningMax;
+    }
+    quint64 runningMin = std::numeric_limits<quint64>::max();
+    for (int i = blocks - 1; i >= 0; --i) {
+        runningMin = qMin(runningMin, m_blockMin[i]);
+        m_suffixMin[i] = runningMin;
+    }
+}
+
+bool MappedCapture::loadIndex()
+{
+    QFile file(indexPath(m_file.fileName()));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray data = file.readAll();
+    if (data.size() < static_cast<int>(sizeof(IndexFileHeader))) {
+        return false;
+    }
+    
+    IndexFileHeader header;
+    std::memcpy(&header, data.constData(), sizeof(header));
+    if (std::memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) != 0
+        || header.version != INDEX_VERSION
+        || header.blockFrames != static_cast<quint32>(INDEX_BLOCK_FRAMES)
+        || header.captureMonotonicNs != m_header.monotonicNs
+        || header.captureWallClockMs != m_header.wallClockMs
+        || header.frameCount > m_frameCount
+        || header.blockCount != (header.frameCount + INDEX_BLOCK_FRAMES - 1) / INDEX_BLOCK_FRAMES) {
+        return false;
+    }
+    const qint64 expectedSize = static_cast<qint64>(sizeof(IndexFileHeader))
+                                + static_cast<qint64>(header.blockCount) * 2 * sizeof(quint64)
+                                + static_cast<qint64>(header.idCount) * sizeof(IndexIdEntry)
+                                + static_cast<qint64>(header.postingCount) * sizeof(quint32);
+    if (data.size() != expectedSize) {
+        return false;
+    }
+    
+    const char *p = data.constData() + sizeof(IndexFileHeader);
+    m_blockMin.resize(header.blockCount);
+    std::memcpy(m_blockMin.data(), p, header.blockCount * sizeof(quint64));
+    p += header.blockCount * sizeof(quint64);
+    m_blockMax.resize(header.blockCount);
+    std::memcpy(m_blockMax.data(), p, header.blockCount * sizeof(quint64));
+    p += header.blockCount * sizeof(quint64);
+    
+    const char *entries = p;
+    const quint32 *postings = reinterpret_cast<const quint32*>(p + header.idCount * sizeof(IndexIdEntry));
+    m_postings.reserve(header.idCount);
+    for (quint32 i = 0; i < header.idCount; ++i) {
+        IndexIdEntry entry;
+        std::memcpy(&entry, entries + i * sizeof(IndexIdEntry), sizeof(entry));
+        if (static_cast<quint64>(entry.offset) + entry.count > header.postingCount) {
+            m_blockMin.clear();
+            m_blockMax.clear();
+            m_postings.clear();
+            return false;
+        }
+        QVector<quint32> &blocks = m_postings[entry.key];
+        blocks.resize(entry.count);
+        std::memcpy(blocks.data(), postings + entry.offset, entry.count * sizeof(quint32));
+    }
+    
+    // Неполный последний блок (файл дописывался) переиндексируется целиком
+    const quint32 fullBlocks = static_cast<quint32>(header.frameCount / INDEX_BLOCK_FRAMES);
+    if (fullBlocks < header.blockCount && header.frameCount < m_frameCount) {
+        m_blockMin.resize(fullBlocks);
+        m_blockMax.resize(fullBlocks);
+        for (auto it = m_postings.begin(); it != m_postings.end();) {
+            if (it->last() == fullBlocks) {
+                it->removeLast();
+            }
+            if (it->isEmpty()) {
+                it = m_postings.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    return true;
+}
+
+bool MappedCapture::saveIndex() const
+{
+    QVector<quint32> keys = m_postings.keys();
+    std::sort(keys.begin(), keys.end());
+    
+    IndexFileHeader header = {};
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.version = INDEX_VERSION;
+    header.blockFrames = INDEX_BLOCK_FRAMES;
+    header.frameCount = m_frameCount;
+    header.captureMonotonicNs = m_header.monotonicNs;
+    header.captureWallClockMs = m_header.wallClockMs;
+    header.blockCount = static_cast<quint32>(m_blockMin.size());
+    header.idCount = static_cast<quint32>(keys.size());
+    
+    QVector<IndexIdEntry> entries;
+    entries.reserve(keys.size());
+    quint32 postingCount = 0;
+    for (quint32 key : keys) {
+        const quint32 count = static_cast<quint32>(m_postings.value(key).size());
+        entries.append({key, postingCount, count});
+        postingCount += count;
+    }
+    header.postingCount = postingCount;
+    
+    // Атомарная замена: прерванная запись не оставит поврежденный индекс
+    QSaveFile file(indexPath(m_file.fileName()));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(m_blockMin.constData()), m_blockMin.size() * sizeof(quint64));
+    file.write(reinterpret_cast<const char*>(m_blockMax.constData()), m_blockMax.size() * sizeof(quint64));
+    file.write(reinterpret_cast<const char*>(entries.constData()), entries.size() * sizeof(IndexIdEntry));
+    for (quint32 key : keys) {
+        const QVector<quint32> &blocks = m_postings.constFind(key).value();
+        file.write(reinterpret_cast<const char*>(blocks.constData()), blocks.size() * sizeof(quint32));
+    }
+    return file.commit();
+}
+
+quint64 MappedCapture::firstTimestampNs() const
+{
+    return m_suffixMin.isEmpty() ? 0 : m_suffixMin.first() + m_clockOffsetNs;
+}
+
+quint64 MappedCapture::lastTimestampNs() const
+{
+    return m_prefixMax.isEmpty() ? 0 : m_prefixMax.last() + m_clockOffsetNs;
+}
+
+QVector<quint32> MappedCapture::select(const CaptureSelection &selection) const
+{
+    QVector<quint32> rows;
+    if (!isOpen() || m_frameCount == 0) {
+        return rows;
+    }
+    
+    // Границы во времени файла; блоки вне интервала отсекаются двоичным поиском
+    quint32 firstBlock = 0;
+    quint32 endBlock = static_cast<quint32>(m_blockMin.size());
+    quint64 fromNs = 0;
+    quint64 toNs = std::numeric_limits<quint64>::max();
+    if (selection.timeRange) {
+        // Разность считается со знаком: граница раньше начала файла - это его начало
+        const quint64 firstNs = m_suffixMin.first();
+        auto toFileNs = [&](quint64 clockNs) {
+            const qint64 deltaNs = static_cast<qint64>(clockNs - m_clockOffsetNs - firstNs);
+            return deltaNs < 0 ? firstNs : firstNs + deltaNs;
+        };
+        fromNs = toFileNs(selection.fromNs);
+        toNs = toFileNs(selection.toNs);
+        if (static_cast<qint64>(selection.toNs - m_clockOffsetNs - firstNs) < 0 || fromNs > toNs) {
+            return rows;
+        }
+        firstBlock = static_cast<quint32>(std::lower_bound(m_prefixMax.begin(), m_prefixMax.end(), fromNs)
+                                          - m_prefixMax.begin());
+        endBlock = static_cast<quint32>(std::upper_bound(m_suffixMin.begin(), m_suffixMin.end(), toNs)
+                                        - m_suffixMin.begin());
+    }
+    
+    auto scanBlock = [&](quint32 block, auto &&accept) {
+        const quint32 begin = block * INDEX_BLOCK_FRAMES;
+        const quint32 end = qMin<quint64>(m_frameCount, static_cast<quint64>(begin) + INDEX_BLOCK_FRAMES);
+        for (quint32 i = begin; i < end; ++i) {
+            const quint64 timestampNs = m_frames[i].timestampNs;
+            if (timestampNs >= fromNs && timestampNs <= toNs && accept(m_frames[i])) {
+                rows.append(i);
+            }
+        }
+    };
+    
+    if (selection.allIds) {
+        for (quint32 block = firstBlock; block < endBlock; ++block) {
+            scanBlock(block, [](const CanFrame &) { return true; });
+        }
+        return rows;
+    }
+    
+    const auto posting = m_postings.constFind(keyOf(selection.id, selection.extended));
+    if (posting == m_postings.constEnd()) {
+        return rows;
+    }
+    const quint32 key = posting.key();
+    const QVector<quint32> &blocks = posting.value();
+    for (auto it = std::lower_bound(blocks.begin(), blocks.end(), firstBlock);
+         it != blocks.end() && *it < endBlock; ++it) {
+        scanBlock(*it, [key](const CanFrame &frame) { return keyOf(frame) == key; });
+    }
+    return rows;
+}
@@ -0,0 +1,185 @@
+#include "messagetablemodel.h"
+#include <QBrush>
+#include <QColor>
+#include <QDateTime>
+
+MessageTableModel::MessageTableModel(QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_capacity(DEFAULT_CAPACITY)
+    , m_first(0)
+    , m_count(0)
+{
+}
+
+void MessageTableModel::setCapacity(int capacity)
+{
+    capacity = qBound(1, capacity, MAX_CAPACITY);
+    if (capacity == m_capacity) {
+        return;
+    }
+    
+    // Перекладка в линейный порядок с сохранением последних строк
+    beginResetModel();
+    const int keep = qMin(m_count, capacity);
+    QVector<CanFrame> frames;
+    frames.reserve(keep);
+    for (int row = m_count - keep; row < m_count; ++row) {
+        frames.append(frameAt(row));
+    }
+    m_frames = std::move(frames);
+    m_first = 0;
+    m_count = keep;
+    m_capacity = capacity;
+    endResetModel();
+}
+
+void MessageTableModel::append(const CanFrame &frame)
+{
+    m_pending.append(frame);
+}
+
+void MessageTableModel::append(const CanFrame *frames, int count)
+{
+    m_pending.reserve(m_pending.size() + count);
+    for (int i = 0; i < count; ++i) {
+        m_pending.append(frames[i]);
+    }
+}
+
+int MessageTableModel::flush()
+{
+    if (m_pending.isEmpty()) {
+        return 0;
+    }
+    
+    // В буфер попадают только последние m_capacity кадров пачки
+    const int skip = qMax(0, static_cast<int>(m_pending.size()) - m_capacity);
+    const int incoming = m_pending.size() - skip;
+    
+    const int evict = qMax(0, m_count + incoming - m_capacity);
+    if (evict > 0) {
+        beginRemoveRows(QModelIndex(), 0, evict - 1);
+        m_first = (m_first + evict) % m_capacity;
+        m_count -= evict;
+        endRemoveRows();
+    }
+    
+    beginInsertRows(QModelIndex(), m_count, m_count + incoming - 1);
+    for (int i = skip; i < m_pending.size(); ++i) {
+        if (m_frames.size() < m_capacity) {
+            // Кольцо еще не заполнено и не переходило через конец
+            m_frames.append(m_pending[i]);
+        } else {
+            m_frames[(m_first + m_count) % m_capacity] = m_pending[i];
+        }
+        ++m_count;
+    }
+    endInsertRows();
+    
+    m_pending.clear();
+    return incoming;
+}
+
+void MessageTableModel::clear()
+{
+    beginResetModel();
+    m_frames.clear();
+    m_frames.squeeze();
+    m_first = 0;
+    m_count = 0;
+    m_pending.clear();
+    endResetModel();
+}
+
+const CanFrame &MessageTableModel::frameAt(int row) const
+{
+    return m_frames[(m_first + row) % m_frames.size()];
+}
+
+QString MessageTableModel::cellText(int row, int column) const
+{
+    return frameCellText(frameAt(row), column);
+}
+
+QString MessageTableModel::frameCellText(const CanFrame &frame, int column)
+{
+    switch (column) {
+    case TimeColumn:
+        // Перевод монотонной метки в локальное время только для отображения
+        return CanClock::toDateTime(frame.timestampNs).toString("hh:mm:ss.zzz");
+    case IdColumn:
+        return QString("0x%1").arg(frame.id, 0, 16).toUpper();
+    case DataColumn: {
+        static const char HEX[] = "0123456789ABCDEF";
+        const int dlc = qMin<int>(frame.dlc, 8);
+        QString text(qMax(0, dlc * 3 - 1), QChar(' '));
+        for (int i = 0; i < dlc; ++i) {
+            text[i * 3] = QChar(HEX[frame.data[i] >> 4]);
+            text[i * 3 + 1] = QChar(HEX[frame.data[i] & 0x0F]);
+        }
+        return text;
+    }
+    case DirectionColumn:
+        return frame.isTx() ? QStringLiteral("TX") : QStringLiteral("RX");
+    default:
+        return QString();
+    }
+}
+
+int MessageTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_count;
+}
+
+int MessageTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : COLUMN_COUNT;
+}
+
+QVariant MessageTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_count) {
+        return QVariant();
+    }
+    return frameData(frameAt(index.row()), index.column(), role);
+}
+
+QVariant MessageTableModel::frameData(const CanFrame &frame, int column, int role)
+{
+    if (role == Qt::DisplayRole) {
+        return frameCellText(frame, column);
+    }
+    
+    // Цветовая подсветка направления для темной темы
+    if (role == Qt::ForegroundRole && column == DirectionColumn) {
+        return frame.isTx()
+            ? QBrush(QColor("#4EC9B0"))   // Бирюзовый для TX
+            : QBrush(QColor("#CE9178"));  // Оранжево-коричневый для RX
+    }
+    return QVariant();
+}
+
+QVariant MessageTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    return columnHeader(section, orientation, role);
+}
+
+QVariant MessageTableModel::columnHeader(int section, Qt::Orientation orientation, int role)
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    
+    switch (section) {
+    case TimeColumn:
+        return QStringLiteral("Время");
+    case IdColumn:
+        return QStringLiteral("ID");
+    case DataColumn:
+        return QStringLiteral("Данные");
+    case DirectionColumn:
+        return QStringLiteral("Направление");
+    default:
+        return QVariant();
+    }
+}
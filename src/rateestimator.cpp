@@ -0,0 +1,86 @@
+#include "rateestimator.h"
+
+namespace {
+
+inline quint32 keyOf(const IdStatistics &stats)
+{
+    return stats.id | (stats.tx ? 0x80000000u : 0u);
+}
+
+// Прирост счетчика; уменьшение означает обнуление между снимками
+inline quint64 delta(quint64 current, quint64 base)
+{
+    return current >= base ? current - base : current;
+}
+
+} // namespace
+
+RateEstimator::RateEstimator(quint64 windowNs)
+    : m_windowNs(qMax<quint64>(windowNs, 1))
+    , m_bitRateKbps(0)
+    , m_framesPerSecond(0)
+    , m_busLoadPercent(0)
+{
+}
+
+void RateEstimator::setBitRate(int kbps)
+{
+    m_bitRateKbps = qMax(kbps, 0);
+}
+
+void RateEstimator::reset()
+{
+    m_samples.clear();
+    m_framesPerSecond = 0;
+    m_busLoadPercent = 0;
+}
+
+double RateEstimator::load(quint64 bits, double seconds) const
+{
+    if (m_bitRateKbps <= 0) {
+        return 0;
+    }
+    return qMin(100.0, bits * 100.0 / (seconds * m_bitRateKbps * 1000.0));
+}
+
+void RateEstimator::update(quint64 nowNs, quint64 totalFrames, quint64 totalBits, QVector<IdStatistics> &ids)
+{
+    // Счетчики таблицы очищены (новое подключение) - окно начинается заново
+    if (!m_samples.isEmpty() && (totalFrames < m_samples.last().total.frames || nowNs <= m_samples.last().timeNs)) {
+        reset();
+    }
+    
+    Sample sample;
+    sample.timeNs = nowNs;
+    sample.total = {totalFrames, totalBits};
+    sample.perId.reserve(ids.size());
+    for (const IdStatistics &stats : ids) {
+        sample.perId.insert(keyOf(stats), {stats.frames, stats.bits});
+    }
+    m_samples.append(std::move(sample));
+    
+    // База - самый поздний снимок не позже начала окна
+    const quint64 windowStart = nowNs > m_windowNs ? nowNs - m_windowNs : 0;
+    while (m_samples.size() > 2 && m_samples[1].timeNs <= windowStart) {
+        m_samples.removeFirst();
+    }
+    
+    if (m_samples.size() < 2) {
+        m_framesPerSecond = 0;
+        m_busLoadPercent = 0;
+        return;
+    }
+    
+    const Sample &base = m_samples.first();
+    const Sample &current = m_samples.last();
+    const double seconds = (current.timeNs - base.timeNs) / 1e9;
+    m_framesPerSecond = delta(current.total.frames, base.total.frames) / seconds;
+    m_busLoadPercent = load(delta(current.total.bits, base.total.bits), seconds);
+    
+    // ID, которого нет в базе, появился или обнулен внутри окна
+    for (IdStatistics &stats : ids) {
+        const Counters origin = base.perId.value(keyOf(stats), Counters{0, 0});
+        stats.framesPerSecond = delta(stats.frames, origin.frames) / seconds;
+        stats.busLoadPercent = load(delta(stats.bits, origin.bits), seconds);
+    }
+}
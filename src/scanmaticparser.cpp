@@ -0,0 +1,109 @@
+#include "scanmaticparser.h"
+#include <cstring>
+
+ScanmaticParser::ScanmaticParser(int capacity)
+    : m_capacity(0)
+    , m_readPos(0)
+    , m_writePos(0)
+    , m_skippedBytes(0)
+    , m_malformedFrames(0)
+{
+    setCapacity(capacity);
+}
+
+void ScanmaticParser::setCapacity(int capacity)
+{
+    // В буфере всегда должен помещаться хотя бы один полный кадр
+    m_capacity = qMax(capacity, MAX_FRAME_SIZE);
+    m_slab.reset(new quint8[m_capacity]);
+    clear();
+}
+
+void ScanmaticParser::clear()
+{
+    m_readPos = 0;
+    m_writePos = 0;
+    m_skippedBytes = 0;
+    m_malformedFrames = 0;
+}
+
+void ScanmaticParser::commit(int bytes)
+{
+    m_writePos = qMin(m_writePos + qMax(0, bytes), m_capacity);
+}
+
+bool ScanmaticParser::next(CanFrame &frame, FilterEngine *filter)
+{
+    const quint8 *slab = m_slab.get();
+    
+    while (m_writePos - m_readPos >= MIN_FRAME_SIZE) {
+        const quint8 *cursor = slab + m_readPos;
+        const int available = m_writePos - m_readPos;
+        
+        // Поиск начала кадра
+        if (cursor[0] != FRAME_START) {
+            const void *start = std::memchr(cursor, FRAME_START, available);
+            const int skip = start ? static_cast<int>(static_cast<const quint8*>(start) - cursor) : available;
+            m_skippedBytes += skip;
+            m_readPos += skip;
+            continue;
+        }
+        
+        const quint8 dataLength = cursor[2];
+        if (cursor[1] != TYPE_CAN_DATA || dataLength > 8) {
+            // Неизвестный тип кадра или ошибка, пропускаем байт
+            m_skippedBytes++;
+            m_readPos++;
+            continue;
+        }
+        
+        const int frameSize = HEADER_SIZE + dataLength + 1;
+        if (available < frameSize) {
+            // Недостаточно данных, ждем еще
+            return false;
+        }
+        
+        if (cursor[frameSize - 1] != FRAME_END) {
+            // 0xAA внутри данных другого кадра или поврежденный кадр:
+            // сдвигаемся на байт и ищем следующее начало
+            m_malformedFrames++;
+            m_skippedBytes++;
+            m_readPos++;
+            continue;
+        }
+        
+        const quint32 id = (static_cast<quint32>(cursor[3]) << 24)
+                         | (static_cast<quint32>(cursor[4]) << 16)
+                         | (static_cast<quint32>(cursor[5]) << 8)
+                         | static_cast<quint32>(cursor[6]);
+        if (filter && !filter->accept(id)) {
+            m_readPos += frameSize;
+            continue;
+        }
+        
+        frame = CanFrame();
+        frame.id = id;
+        frame.flags = frame.id > 0x7FF ? CanFrame::FLAG_EXTENDED : 0;
+        frame.dlc = dataLength;
+        std::memcpy(frame.data, cursor + HEADER_SIZE, dataLength);
+        
+        m_readPos += frameSize;
+        return true;
+    }
+    
+    return false;
+}
+
+void ScanmaticParser::compact()
+{
+    if (m_readPos == 0) {
+        return;
+    }
+    
+    const int remaining = m_writePos - m_readPos;
+    if (remaining > 0) {
+        std::memmove(m_slab.get(), m_slab.get() + m_readPos, remaining);
+    }
+    m_readPos = 0;
+    m_writePos = remaining;
+}
@@ -0,0 +1,52 @@
+#include "scanmaticprotocol.h"
+
+quint8 ScanmaticProtocol::speedCode(int baudRateKbps)
+{
+    switch (baudRateKbps) {
+        case 125:  return 0x00;
+        case 250:  return 0x01;
+        case 500:  return 0x02;
+        case 1000: return 0x03;
+        default:   return 0x01; // По умолчанию 250
+    }
+}
+
+int ScanmaticProtocol::serialBaudRate(int baudRateKbps)
+{
+    // Scanmatic 2 Pro использует стандартные скорости последовательного порта
+    switch (baudRateKbps) {
+        case 125:  return 57600;
+        case 250:  return 115200;
+        case 500:  return 230400;
+        case 1000: return 460800;
+        default:   return 115200;
+    }
+}
+
+QByteArray ScanmaticProtocol::initCommand(int baudRateKbps)
+{
+    QByteArray command;
+    command.append(static_cast<char>(FRAME_START));
+    command.append(static_cast<char>(CMD_INIT));
+    command.append(static_cast<char>(speedCode(baudRateKbps)));
+    command.append(static_cast<char>(0x00)); // Резерв
+    command.append(static_cast<char>(FRAME_END));
+    return command;
+}
+
+void ScanmaticProtocol::appendFrame(QByteArray &out, const CanFrame &frame)
+{
+    const quint8 length = qMin<quint8>(frame.dlc, 8);
+    const char header[7] = {
+        static_cast<char>(FRAME_START),
+        static_cast<char>(TYPE_CAN_DATA),
+        static_cast<char>(length),
+        static_cast<char>((frame.id >> 24) & 0xFF),
+        static_cast<char>((frame.id >> 16) & 0xFF),
+        static_cast<char>((frame.id >> 8) & 0xFF),
+        static_cast<char>(frame.id & 0xFF)
+    };
+    out.append(header, sizeof(header));
+    out.append(reinterpret_cast<const char*>(frame.data), length);
+    out.append(static_cast<char>(FRAME_END));
+}
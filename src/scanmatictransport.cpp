@@ -0,0 +1,100 @@
+#include "scanmatictransport.h"
+#include "scanmaticprotocol.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <cstring>
+
+ScanmaticTransport::ScanmaticTransport(QObject *parent)
+    : ICanTransport(parent)
+    , m_bufferSize(ScanmaticParser::DEFAULT_CAPACITY)
+{
+}
+
+void ScanmaticTransport::setBufferSize(int bytes)
+{
+    m_bufferSize = qMax(1024, bytes); // Минимум 1KB
+}
+
+void ScanmaticTransport::resetParser()
+{
+    m_parser.setCapacity(m_bufferSize);
+    m_frames.clear();
+}
+
+int ScanmaticTransport::writeBatch(const CanFrame *frames, int count)
+{
+    // Кадры пачки уходят одной записью в устройство, сколько помещается
+    // в буфер передачи. Остаток возвращается в очередь и отправляется позже.
+    const qint64 space = writeSpace();
+    m_txBuffer.clear();
+    int accepted = 0;
+    while (accepted < count) {
+        const int before = m_txBuffer.size();
+        ScanmaticProtocol::appendFrame(m_txBuffer, frames[accepted]);
+        if (m_txBuffer.size() > space) {
+            m_txBuffer.truncate(before);
+            break;
+        }
+        ++accepted;
+    }
+    if (accepted == 0) {
+        return 0;
+    }
+    
+    switch (writeBytes(m_txBuffer)) {
+    case WriteOk:
+        return accepted;
+    case WriteBusy:
+        return 0;
+    case WriteFailed:
+        break;
+    }
+    return -1;
+}
+
+bool ScanmaticTransport::sendInitCommand(int baudRateKbps)
+{
+    return writeBytes(ScanmaticProtocol::initCommand(baudRateKbps)) == WriteOk;
+}
+
+void ScanmaticTransport::commitReceived(int bytes, quint64 timestampNs)
+{
+    m_parser.commit(bytes);
+    
+    // Разбор всех полных кадров, хвост переносится в начало один раз на пачку.
+    // Все кадры одного чтения получают одну метку времени.
+    const quint64 malformedBefore = m_parser.malformedFrames();
+    m_frames.clear();
+    CanFrame frame;
+    while (m_parser.next(frame, m_filter)) {
+        frame.timestampNs = timestampNs;
+        m_frames.append(frame);
+    }
+    m_parser.compact();
+    
+    const quint64 malformed = m_parser.malformedFrames() - malformedBefore;
+    if (m_sink && (!m_frames.isEmpty() || malformed > 0)) {
+        m_sink->onFramesReceived(m_frames.constData(), m_frames.size(), malformed);
+    }
+}
+
+void ScanmaticTransport::ingest(const char *data, int size, quint64 timestampNs)
+{
+    // После разбора в буфере остается меньше одного кадра, поэтому место есть всегда
+    while (size > 0) {
+        const int chunk = qMin(size, writableBytes());
+        std::memcpy(writePointer(), data, chunk);
+        commitReceived(chunk, timestampNs);
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+void ScanmaticTransport::settle(int milliseconds)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < milliseconds) {
+        QCoreApplication::processEvents();
+    }
+}
@@ -0,0 +1,259 @@
+#include "serialtransport.h"
+#include "scanmaticprotocol.h"
+#include <QSerialPortInfo>
+#include <QFileInfo>
+#include <QTimer>
+#include <QDebug>
+
+SerialTransport::SerialTransport(QObject *parent)
+    : ScanmaticTransport(parent)
+    , m_writeTimeout(1000)
+{
+    m_serialPort = new QSerialPort(this);
+    connect(m_serialPort, &QSerialPort::readyRead, this, &SerialTransport::onReadyRead);
+    connect(m_serialPort, &QSerialPort::errorOccurred, this, &SerialTransport::onSerialError);
+    connect(m_serialPort, &QSerialPort::bytesWritten, this, &SerialTransport::onBytesWritten);
+    
+    m_writeTimer = new QTimer(this);
+    m_writeTimer->setSingleShot(true);
+    connect(m_writeTimer, &QTimer::timeout, this, &SerialTransport::onWriteTimeout);
+}
+
+QString SerialTransport::name() const
+{
+    return m_serialPort->portName();
+}
+
+bool SerialTransport::isOpen() const
+{
+    return m_serialPort->isOpen();
+}
+
+bool SerialTransport::open(const QString &portDisplayName, int baudRateKbps)
+{
+    if (portDisplayName.isEmpty()) {
+        m_lastError = "Ошибка: имя порта не указано";
+        return false;
+    }
+    
+    if (isOpen()) {
+        close();
+    }
+    
+    // Извлекаем реальное имя порта из строки с описанием
+    // Формат: "ttyUSB0 (FTDI Serial Converter)" -> "ttyUSB0"
+    // Или: "COM3 - USB Serial Port" -> "COM3"
+    QString portName = portDisplayName.trimmed();
+    int spaceIndex = portName.indexOf(' ');
+    if (spaceIndex > 0) {
+        portName = portName.left(spaceIndex);
+    }
+    
+    if (portName.isEmpty()) {
+        m_lastError = "Ошибка: не удалось извлечь имя порта";
+        return false;
+    }
+    
+    // Проверка доступности порта
+    QSerialPortInfo portInfo(portName);
+    bool usePath = false;
+    if (portInfo.isNull()) {
+        // Попробуем найти порт по VID/PID если порт не найден по имени
+        bool foundByVidPid = false;
+        const auto allPorts = QSerialPortInfo::availablePorts();
+        for (const QSerialPortInfo &info : allPorts) {
+            if (info.vendorIdentifier() == TARGET_VENDOR_ID &&
+                info.productIdentifier() == TARGET_PRODUCT_ID) {
+                portInfo = info;
+                foundByVidPid = true;
+                qDebug() << "Найден адаптер по VID/PID:" << info.portName();
+                break;
+            }
+        }
+        
+        // Устройство, не найденное при перечислении портов (псевдотерминал
+        // симулятора, символическая ссылка udev), открывается по пути
+        if (!foundByVidPid && portName.startsWith('/') && QFileInfo::exists(portName)) {
+            qDebug() << "Порт не найден при перечислении, открытие по пути:" << portName;
+            usePath = true;
+        } else if (!foundByVidPid) {
+            QString errorMsg = QString("Порт %1 не найден в системе.\n\n").arg(portName);
+            errorMsg += "Проверьте:\n";
+            errorMsg += "1. Подключено ли устройство USB (VID:20A2 PID:0001)\n";
+            errorMsg += "2. Установлены ли драйверы для устройства\n";
+            errorMsg += "3. Создается ли виртуальный COM порт при подключении\n";
+            errorMsg += "4. Если устройство не создает COM порт, может потребоваться специальный драйвер или протокол";
+            m_lastError = errorMsg;
+            return false;
+        }
+    }
+    
+    if (usePath) {
+        m_serialPort->setPortName(portName);
+    } else {
+        m_serialPort->setPort(portInfo);
+    }
+    
+    // Дополнительная диагностика
+    qDebug() << "Подключение к порту:" << portInfo.portName();
+    qDebug() << "VID:" << QString::number(portInfo.vendorIdentifier(), 16);
+    qDebug() << "PID:" << QString::number(portInfo.productIdentifier(), 16);
+    qDebug() << "Описание:" << portInfo.description();
+    qDebug() << "Производитель:" << portInfo.manufacturer();
+    
+    // Маппинг скоростей CAN на скорости последовательного порта
+    int serialBaudRate = ScanmaticProtocol::serialBaudRate(baudRateKbps);
+    m_serialPort->setBaudRate(serialBaudRate);
+    m_serialPort->setDataBits(QSerialPort::Data8);
+    m_serialPort->setParity(QSerialPort::NoParity);
+    m_serialPort->setStopBits(QSerialPort::OneStop);
+    m_serialPort->setFlowControl(QSerialPort::NoFlowControl);
+    
+    qDebug() << "Попытка открыть порт:" << portName << "со скоростью" << serialBaudRate;
+    
+    if (!m_serialPort->open(QIODevice::ReadWrite)) {
+        QString errorMsg = QString("Не удалось открыть порт %1: %2")
+                          .arg(portName)
+                          .arg(m_serialPort->errorString());
+        
+        // Дополнительная диагностика
+        if (m_serialPort->error() == QSerialPort::PermissionError) {
+            errorMsg += "\nВозможно, недостаточно прав доступа. Попробуйте запустить с правами администратора или добавить пользователя в группу dialout (Linux).";
+        } else if (m_serialPort->error() == QSerialPort::DeviceNotFoundError) {
+            errorMsg += QString("\nУстройство не найдено. Проверьте:\n"
+                              "- Подключено ли устройство USB (VID:20A2 PID:0001)\n"
+                              "- Установлены ли драйверы\n"
+                              "- Определяется ли порт в системе (lsusb / dmesg на Linux)");
+        } else if (m_serialPort->error() == QSerialPort::OpenError) {
+            errorMsg += "\nПорт уже открыт другим приложением.";
+        }
+        
+        m_lastError = errorMsg;
+        qDebug() << "Ошибка открытия порта:" << errorMsg;
+        return false;
+    }
+    
+    qDebug() << "Порт успешно открыт";
+    // Очистка буферов порта перед использованием
+    m_serialPort->clear();
+    resetParser();
+    
+    // Задержка для инициализации устройства после открытия порта
+    settle(100);
+    
+    // Очистка выходного буфера перед отправкой команды инициализации
+    m_serialPort->clear(QSerialPort::Output);
+    
+    if (!sendInitCommand(baudRateKbps)) {
+        m_lastError = QString("Ошибка записи команды инициализации: %1").arg(m_lastError);
+        m_serialPort->close();
+        return false;
+    }
+    
+    // Увеличенный таймаут для инициализации (5 секунд)
+    if (!m_serialPort->waitForBytesWritten(5000)) {
+        m_writeTimer->stop();
+        m_lastError = "Таймаут при инициализации адаптера. Проверьте подключение устройства.";
+        m_serialPort->close();
+        return false;
+    }
+    m_writeTimer->stop();
+    
+    // Дополнительная задержка после отправки команды инициализации
+    settle(200);
+    
+    // Очистка входного буфера после инициализации
+    m_serialPort->clear(QSerialPort::Input);
+    return true;
+}
+
+void SerialTransport::close()
+{
+    m_writeTimer->stop();
+    if (m_serialPort->isOpen()) {
+        m_serialPort->close();
+    }
+    resetParser();
+}
+
+qint64 SerialTransport::writeSpace() const
+{
+    return qMax<qint64>(0, MAX_PENDING_WRITE - m_serialPort->bytesToWrite());
+}
+
+ScanmaticTransport::WriteStatus SerialTransport::writeBytes(const QByteArray &bytes)
+{
+    if (!m_serialPort->isOpen()) {
+        m_lastError = "Порт не открыт";
+        return WriteFailed;
+    }
+    
+    // Запись без ожидания: данные уходят из буфера порта в цикле событий.
+    // Полный буфер - шина медленнее потока кадров, а не ошибка: запись
+    // повторяется позже. Зависшее устройство обнаруживает m_writeTimer.
+    if (m_serialPort->bytesToWrite() + bytes.size() > MAX_PENDING_WRITE) {
+        m_lastError = QString("Буфер передачи порта заполнен: %1 байт ожидают записи")
+                      .arg(m_serialPort->bytesToWrite());
+        return WriteBusy;
+    }
+    
+    qint64 bytesWritten = m_serialPort->write(bytes);
+    if (bytesWritten != bytes.size()) {
+        m_lastError = QString("Ошибка записи в порт: записано %1 из %2 байт. Ошибка: %3")
+                      .arg(bytesWritten).arg(bytes.size()).arg(m_serialPort->errorString());
+        return WriteFailed;
+    }
+    
+    // Увеличенный таймаут для записи (3 секунды вместо 1)
+    if (!m_writeTimer->isActive()) {
+        m_writeTimer->start(qMax(m_writeTimeout, 3000));
+    }
+    return WriteOk;
+}
+
+void SerialTransport::onBytesWritten()
+{
+    if (m_serialPort->bytesToWrite() == 0) {
+        m_writeTimer->stop();
+    } else {
+        // Запись продвигается, отсчет таймаута начинается заново
+        m_writeTimer->start(qMax(m_writeTimeout, 3000));
+    }
+}
+
+void SerialTransport::onWriteTimeout()
+{
+    if (!m_serialPort->isOpen() || m_serialPort->bytesToWrite() == 0) {
+        return;
+    }
+    
+    emit errorOccurred(QString("Таймаут при записи в порт: %1").arg(m_serialPort->errorString()));
+    // Проверка, не отключилось ли устройство
+    if (m_serialPort->error() == QSerialPort::ResourceError) {
+        emit deviceLost();
+    }
+}
+
+void SerialTransport::onReadyRead()
+{
+    // Чтение прямо в буфер разбора, без промежуточного QByteArray.
+    // После разбора в буфере остается меньше одного кадра, поэтому место есть всегда.
+    const quint64 timestampNs = CanClock::nowNs();
+    while (m_serialPort->bytesAvailable() > 0) {
+        qint64 bytesRead = m_serialPort->read(reinterpret_cast<char*>(writePointer()), writableBytes());
+        if (bytesRead <= 0) {
+            break;
+        }
+        commitReceived(static_cast<int>(bytesRead), timestampNs);
+    }
+}
+
+void SerialTransport::onSerialError(QSerialPort::SerialPortError error)
+{
+    if (error == QSerialPort::ResourceError) {
+        emit errorOccurred("Критическая ошибка порта. Возможно, устройство отключено.");
+        emit deviceLost();
+    } else if (error != QSerialPort::NoError) {
+        emit errorOccurred(QString("Ошибка порта: %1").arg(m_serialPort->errorString()));
+    }
+}
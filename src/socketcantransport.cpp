@@ -0,0 +1,328 @@
+#include "socketcantransport.h"
+#include "filterengine.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSocketNotifier>
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+#ifndef SO_RXQ_OVFL
+#define SO_RXQ_OVFL 40
+#endif
+
+// Буферы одного вызова recvmmsg: кадры, вектора и управляющие данные
+struct SocketCanTransport::ReceiveBuffers {
+    can_frame frames[RX_BATCH];
+    iovec iov[RX_BATCH];
+    mmsghdr headers[RX_BATCH];
+    char control[RX_BATCH][CMSG_SPACE(sizeof(timespec)) + CMSG_SPACE(sizeof(quint32))];
+    
+    ReceiveBuffers()
+    {
+        std::memset(headers, 0, sizeof(headers));
+        for (int i = 0; i < RX_BATCH; ++i) {
+            iov[i].iov_base = &frames[i];
+            iov[i].iov_len = sizeof(can_frame);
+        }
+    }
+    
+    void reset()
+    {
+        for (int i = 0; i < RX_BATCH; ++i) {
+            msghdr &header = headers[i].msg_hdr;
+            header.msg_name = nullptr;
+            header.msg_namelen = 0;
+            header.msg_iov = &iov[i];
+            header.msg_iovlen = 1;
+            header.msg_control = control[i];
+            header.msg_controllen = sizeof(control[i]);
+            header.msg_flags = 0;
+        }
+    }
+};
+
+static quint64 clockNs(clockid_t clock)
+{
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<quint64>(ts.tv_sec) * 1000000000ULL + static_cast<quint64>(ts.tv_nsec);
+}
+
+SocketCanTransport::SocketCanTransport(QObject *parent)
+    : ICanTransport(parent)
+    , m_socket(-1)
+    , m_notifier(nullptr)
+    , m_rx(new ReceiveBuffers)
+    , m_droppedFrames(0)
+{
+    m_rxFrames.reserve(RX_BATCH * MAX_BATCHES_PER_READ);
+}
+
+SocketCanTransport::~SocketCanTransport()
+{
+    close();
+    delete m_rx;
+}
+
+bool SocketCanTransport::open(const QString &interfaceName)
+{
+    if (isOpen()) {
+        close();
+    }
+    
+    const unsigned int ifIndex = if_nametoindex(interfaceName.toLocal8Bit().constData());
+    if (ifIndex == 0) {
+        m_lastError = QString("Интерфейс %1 не найден").arg(interfaceName);
+        return false;
+    }
+    
+    m_socket = ::socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
+    if (m_socket < 0) {
+        m_lastError = QString("Не удалось создать сокет CAN: %1").arg(strerror(errno));
+        return false;
+    }
+    
+    // Метки времени ядра и счетчик потерь очереди. Ошибки не критичны.
+    const int enable = 1;
+    if (setsockopt(m_socket, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) < 0) {
+        qDebug() << "SocketCAN: SO_TIMESTAMPNS не поддерживается:" << strerror(errno);
+    }
+    setsockopt(m_socket, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable));
+    const int receiveBuffer = SOCKET_RCVBUF;
+    setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+    
+    sockaddr_can address;
+    std::memset(&address, 0, sizeof(address));
+    address.can_family = AF_CAN;
+    address.can_ifindex = static_cast<int>(ifIndex);
+    if (::bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        m_lastError = QString("Не удалось подключиться к %1: %2").arg(interfaceName).arg(strerror(errno));
+        ::close(m_socket);
+        m_socket = -1;
+        return false;
+    }
+    
+    m_interfaceName = interfaceName;
+    m_droppedFrames = 0;
+    m_notifier = new QSocketNotifier(m_socket, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, [this]() { onReadyRead(); });
+    
+    qDebug() << "SocketCAN интерфейс открыт:" << interfaceName;
+    return true;
+}
+
+void SocketCanTransport::close()
+{
+    if (m_notifier) {
+        m_notifier->setEnabled(false);
+        delete m_notifier;
+        m_notifier = nullptr;
+    }
+    
+    if (m_socket >= 0) {
+        ::close(m_socket);
+        m_socket = -1;
+        qDebug() << "SocketCAN интерфейс закрыт:" << m_interfaceName;
+    }
+}
+
+int SocketCanTransport::maxAcceptanceFilters() const
+{
+    return CAN_RAW_FILTER_MAX;
+}
+
+bool SocketCanTransport::setAcceptanceFilters(const AcceptanceFilters &filters)
+{
+    if (!isOpen()) {
+        return false;
+    }
+    
+    // Один фильтр с нулевой маской пропускает все кадры. Пустой список
+    // разрешенных не пропускает ничего: ядро без фильтров не доставляет кадры.
+    const can_filter acceptAll = {0, 0};
+    if (filters.mode == AcceptanceFilters::AcceptMatching && filters.masks.isEmpty()) {
+        return setsockopt(m_socket, SOL_CAN_RAW, CAN_RAW_FILTER, nullptr, 0) == 0;
+    }
+    if (filters.mode == AcceptanceFilters::AcceptAll || filters.masks.isEmpty()) {
+        return setsockopt(m_socket, SOL_CAN_RAW, CAN_RAW_FILTER, &acceptAll, sizeof(acceptAll)) == 0;
+    }
+    
+    // Обычные фильтры объединяются по ИЛИ. Инвертированные - по И: кадр
+    // проходит, если его ID не совпал ни с одним из запрещенных.
+    const bool reject = filters.mode == AcceptanceFilters::RejectMatching;
+    const int join = reject ? 1 : 0;
+    if (setsockopt(m_socket, SOL_CAN_RAW, CAN_RAW_JOIN_FILTERS, &join, sizeof(join)) < 0 && reject) {
+        qDebug() << "SocketCAN: CAN_RAW_JOIN_FILTERS не поддерживается, фильтрация в приложении";
+        setsockopt(m_socket, SOL_CAN_RAW, CAN_RAW_FILTER, &acceptAll, sizeof(acceptAll));
+        return false;
+    }
+    
+    // Маска без CAN_EFF_FLAG: фильтр сравнивает только значение ID,
+    // как и правила в приложении, для 11- и 29-битных кадров
+    QVector<can_filter> kernelFilters;
+    kernelFilters.reserve(filters.masks.size());
+    for (const AcceptanceFilters::Mask &mask : filters.masks) {
+        can_filter filter;
+        filter.can_id = (mask.code & CAN_EFF_MASK) | (reject ? CAN_INV_FILTER : 0);
+        filter.can_mask = mask.mask & CAN_EFF_MASK;
+        kernelFilters.append(filter);
+    }
+    
+    if (setsockopt(m_socket, SOL_CAN_RAW, CAN_RAW_FILTER, kernelFilters.constData(),
+                   static_cast<socklen_t>(kernelFilters.size() * sizeof(can_filter))) < 0) {
+        m_lastError = QString("Не удалось установить фильтры ядра: %1").arg(strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+int SocketCanTransport::writeBatch(const CanFrame *frames, int count)
+{
+    if (!isOpen()) {
+        m_lastError = "Интерфейс SocketCAN не открыт";
+        return -1;
+    }
+    
+    can_frame txFrames[TX_BATCH];
+    iovec iov[TX_BATCH];
+    mmsghdr headers[TX_BATCH];
+    int sent = 0;
+    
+    while (sent < count) {
+        const int batch = qMin(count - sent, TX_BATCH);
+        std::memset(headers, 0, sizeof(mmsghdr) * batch);
+        for (int i = 0; i < batch; ++i) {
+            const CanFrame &frame = frames[sent + i];
+            std::memset(&txFrames[i], 0, sizeof(can_frame));
+            txFrames[i].can_id = frame.id;
+            if (frame.isExtended() || frame.id > CAN_SFF_MASK) {
+                txFrames[i].can_id = (frame.id & CAN_EFF_MASK) | CAN_EFF_FLAG;
+            }
+            if (frame.flags & CanFrame::FLAG_RTR) {
+                txFrames[i].can_id |= CAN_RTR_FLAG;
+            }
+            txFrames[i].can_dlc = qMin<quint8>(frame.dlc, 8);
+            std::memcpy(txFrames[i].data, frame.data, txFrames[i].can_dlc);
+            iov[i].iov_base = &txFrames[i];
+            iov[i].iov_len = sizeof(can_frame);
+            headers[i].msg_hdr.msg_iov = &iov[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+        
+        const int result = sendmmsg(m_socket, headers, batch, 0);
+        if (result < 0) {
+            if (errno == EAGAIN || errno == ENOBUFS) {
+                // Очередь передачи ядра заполнена, остаток отправит вызывающий код
+                break;
+            }
+            m_lastError = QString("Ошибка записи SocketCAN: %1").arg(strerror(errno));
+            return sent > 0 ? sent : -1;
+        }
+        sent += result;
+        if (result < batch) {
+            break;
+        }
+    }
+    
+    return sent;
+}
+
+void SocketCanTransport::onReadyRead()
+{
+    m_rxFrames.clear();
+    const quint32 droppedBefore = m_droppedFrames;
+    
+    // Разница часов для перевода меток ядра (CLOCK_REALTIME) в монотонное время
+    const qint64 realtimeToMonotonic = static_cast<qint64>(clockNs(CLOCK_MONOTONIC) - clockNs(CLOCK_REALTIME));
+    
+    for (int batch = 0; batch < MAX_BATCHES_PER_READ; ++batch) {
+        m_rx->reset();
+        const int received = recvmmsg(m_socket, m_rx->headers, RX_BATCH, MSG_DONTWAIT, nullptr);
+        if (received < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                m_lastError = QString("Ошибка чтения SocketCAN: %1").arg(strerror(errno));
+                emit errorOccurred(m_lastError);
+            }
+            break;
+        }
+        
+        const quint64 fallbackNs = CanClock::nowNs();
+        for (int i = 0; i < received; ++i) {
+            if (m_rx->headers[i].msg_len < sizeof(can_frame)) {
+                continue;
+            }
+            
+            const can_frame &raw = m_rx->frames[i];
+            const quint32 id = raw.can_id & ((raw.can_id & CAN_EFF_FLAG) ? CAN_EFF_MASK : CAN_SFF_MASK);
+            if (m_filter && !m_filter->accept(id)) {
+                continue;
+            }
+            
+            CanFrame frame = {};
+            frame.timestampNs = fallbackNs;
+            frame.id = id;
+            if (raw.can_id & CAN_EFF_FLAG) {
+                frame.flags |= CanFrame::FLAG_EXTENDED;
+            }
+            if (raw.can_id & CAN_RTR_FLAG) {
+                frame.flags |= CanFrame::FLAG_RTR;
+            }
+            if (raw.can_id & CAN_ERR_FLAG) {
+                frame.flags |= CanFrame::FLAG_ERROR;
+            }
+            frame.dlc = qMin<quint8>(raw.can_dlc, 8);
+            std::memcpy(frame.data, raw.data, frame.dlc);
+            
+            msghdr *header = &m_rx->headers[i].msg_hdr;
+            for (cmsghdr *cmsg = CMSG_FIRSTHDR(header); cmsg; cmsg = CMSG_NXTHDR(header, cmsg)) {
+                if (cmsg->cmsg_level != SOL_SOCKET) {
+                    continue;
+                }
+                if (cmsg->cmsg_type == SO_TIMESTAMPNS) {
+                    timespec ts;
+                    std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+                    const qint64 realtimeNs = static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+                    frame.timestampNs = static_cast<quint64>(realtimeNs + realtimeToMonotonic);
+                } else if (cmsg->cmsg_type == SO_RXQ_OVFL) {
+                    std::memcpy(&m_droppedFrames, CMSG_DATA(cmsg), sizeof(m_droppedFrames));
+                }
+            }
+            
+            m_rxFrames.append(frame);
+        }
+        
+        if (received < RX_BATCH) {
+            break;
+        }
+    }
+    
+    // Счетчик ядра накопительный и 32-битный: прирост по модулю 2^32
+    const quint32 dropped = m_droppedFrames - droppedBefore;
+    if (m_sink && (!m_rxFrames.isEmpty() || dropped > 0)) {
+        m_sink->onFramesReceived(m_rxFrames.constData(), m_rxFrames.size(), dropped);
+    }
+}
+
+QStringList SocketCanTransport::availableInterfaces()
+{
+    // Тип 280 - ARPHRD_CAN
+    QStringList interfaces;
+    const QDir netDir("/sys/class/net");
+    const QStringList names = netDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &name : names) {
+        QFile typeFile(netDir.filePath(name + "/type"));
+        if (typeFile.open(QIODevice::ReadOnly) && typeFile.readAll().trimmed() == "280") {
+            interfaces.append(name);
+        }
+    }
+    return interfaces;
+}
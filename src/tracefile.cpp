@@ -0,0 +1,301 @@
+#include "tracefile.h"
+#include "candumptrace.h"
+#include "asctrace.h"
+#include "blftrace.h"
+#include "capturetrace.h"
+#include <QFileInfo>
+#include <QVector>
+#include <cstring>
+
+bool TraceLineInput::open(const QString &path, QString *error)
+{
+    close();
+    m_file.setFileName(path);
+    // Чтение большими блоками в свой буфер, буфер QFile не нужен
+    if (!m_file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        *error = QString("Не удалось открыть %1: %2").arg(path, m_file.errorString());
+        return false;
+    }
+    m_fileSize = m_file.size();
+    m_buffer.resize(CHUNK_BYTES);
+    return true;
+}
+
+void TraceLineInput::close()
+{
+    m_file.close();
+    m_begin = 0;
+    m_end = 0;
+    m_filePosition = 0;
+    m_fileSize = 0;
+    m_eof = false;
+    m_error = false;
+}
+
+bool TraceLineInput::refill()
+{
+    // Недочитанный хвост строки переносится в начало буфера
+    const int remaining = m_end - m_begin;
+    if (m_begin > 0) {
+        std::memmove(m_buffer.data(), m_buffer.constData() + m_begin, remaining);
+        m_begin = 0;
+        m_end = remaining;
+    }
+    if (m_end == m_buffer.size()) {
+        // Строка длиннее буфера
+        m_buffer.resize(m_buffer.size() * 2);
+    }
+    
+    const qint64 bytesRead = m_file.read(m_buffer.data() + m_end, m_buffer.size() - m_end);
+    if (bytesRead < 0) {
+        m_error = true;
+        return false;
+    }
+    if (bytesRead == 0) {
+        m_eof = true;
+        return false;
+    }
+    m_end += static_cast<int>(bytesRead);
+    m_filePosition += bytesRead;
+    return true;
+}
+
+bool TraceLineInput::readLine(const char *&begin, const char *&end)
+{
+    int searchFrom = m_begin;
+    for (;;) {
+        const char *data = m_buffer.constData();
+        const void *newline = std::memchr(data + searchFrom, '\n', m_end - searchFrom);
+        if (newline) {
+            begin = data + m_begin;
+            end = static_cast<const char*>(newline);
+            m_begin = static_cast<int>(end - data) + 1;
+            break;
+        }
+        
+        const int scanned = m_end - m_begin;
+        if (m_eof || m_error || !refill()) {
+            if (m_error || m_begin == m_end) {
+                return false;
+            }
+            // Последняя строка без перевода строки
+            begin = m_buffer.constData() + m_begin;
+            end = m_buffer.constData() + m_end;
+            m_begin = m_end;
+            break;
+        }
+        searchFrom = m_begin + scanned;
+    }
+    
+    if (end > begin && end[-1] == '\r') {
+        --end;
+    }
+    return true;
+}
+
+bool TraceOutput::open(const QString &path, QString *error)
+{
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        *error = QString("Не удалось создать %1: %2").arg(path, m_file.errorString());
+        return false;
+    }
+    m_buffer.clear();
+    m_buffer.reserve(FLUSH_BYTES + 4096);
+    m_written = 0;
+    return true;
+}
+
+bool TraceOutput::flush(QString *error)
+{
+    if (m_buffer.isEmpty()) {
+        return true;
+    }
+    if (m_file.write(m_buffer.constData(), m_buffer.size()) != m_buffer.size()) {
+        *error = QString("Ошибка записи %1: %2").arg(m_file.fileName(), m_file.errorString());
+        m_buffer.clear();
+        return false;
+    }
+    m_written += m_buffer.size();
+    m_buffer.clear();
+    return true;
+}
+
+bool TraceOutput::overwrite(qint64 position, const char *data, int size, QString *error)
+{
+    if (!flush(error)) {
+        return false;
+    }
+    if (!m_file.seek(position) || m_file.write(data, size) != size || !m_file.seek(m_written)) {
+        *error = QString("Ошибка записи %1: %2").arg(m_file.fileName(), m_file.errorString());
+        return false;
+    }
+    return true;
+}
+
+bool TraceOutput::close(QString *error)
+{
+    const bool flushed = flush(error);
+    m_file.close();
+    return flushed;
+}
+
+TraceFormat traceFormatForFileName(const QString &path)
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    if (suffix == "canrec") {
+        return TraceFormat::Capture;
+    }
+    if (suffix == "log") {
+        return TraceFormat::Candump;
+    }
+    if (suffix == "asc") {
+        return TraceFormat::VectorAsc;
+    }
+    if (suffix == "blf") {
+        return TraceFormat::VectorBlf;
+    }
+    return TraceFormat::Unknown;
+}
+
+TraceFormat detectTraceFormat(const QString &path)
+{
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly)) {
+        const QByteArray head = file.read(64);
+        if (head.startsWith("LOGG")) {
+            return TraceFormat::VectorBlf;
+        }
+        if (head.startsWith(QByteArray(CaptureFileHeader::CAPTURE_MAGIC, sizeof(CaptureFileHeader::CAPTURE_MAGIC)))) {
+            return TraceFormat::Capture;
+        }
+        const QByteArray text = head.trimmed();
+        if (text.startsWith('(')) {
+            return TraceFormat::Candump;
+        }
+        if (text.startsWith("date ") || text.startsWith("base ") || text.startsWith("//")) {
+            return TraceFormat::VectorAsc;
+        }
+    }
+    return traceFormatForFileName(path);
+}
+
+QString traceFormatName(TraceFormat format)
+{
+    switch (format) {
+    case TraceFormat::Capture:
+        return "Запись CANReader";
+    case TraceFormat::Candump:
+        return "candump";
+    case TraceFormat::VectorAsc:
+        return "Vector ASC";
+    case TraceFormat::VectorBlf:
+        return "Vector BLF";
+    case TraceFormat::Unknown:
+        break;
+    }
+    return "Неизвестный формат";
+}
+
+QString traceFileFilter()
+{
+    return "Трассы (*.canrec *.log *.asc *.blf);;"
+           "Запись CANReader (*.canrec);;"
+           "candump (*.log);;"
+           "Vector ASC (*.asc);;"
+           "Vector BLF (*.blf)";
+}
+
+std::unique_ptr<TraceReader> createTraceReader(TraceFormat format)
+{
+    switch (format) {
+    case TraceFormat::Capture:
+        return std::make_unique<CaptureReader>();
+    case TraceFormat::Candump:
+        return std::make_unique<CandumpReader>();
+    case TraceFormat::VectorAsc:
+        return std::make_unique<AscReader>();
+    case TraceFormat::VectorBlf:
+        return std::make_unique<BlfReader>();
+    case TraceFormat::Unknown:
+        break;
+    }
+    return nullptr;
+}
+
+std::unique_ptr<TraceWriter> createTraceWriter(TraceFormat format)
+{
+    switch (format) {
+    case TraceFormat::Capture:
+        return std::make_unique<CaptureWriter>();
+    case TraceFormat::Candump:
+        return std::make_unique<CandumpWriter>();
+    case TraceFormat::VectorAsc:
+        return std::make_unique<AscWriter>();
+    case TraceFormat::VectorBlf:
+        return std::make_unique<BlfWriter>();
+    case TraceFormat::Unknown:
+        break;
+    }
+    return nullptr;
+}
+
+bool convertTrace(const QString &sourcePath, const QString &targetPath, TraceConversionStats *stats,
+                  QString *error, const std::function<bool(qint64, qint64)> &progress)
+{
+    std::unique_ptr<TraceReader> reader = createTraceReader(detectTraceFormat(sourcePath));
+    if (!reader) {
+        *error = QString("Неизвестный формат трассы: %1").arg(sourcePath);
+        return false;
+    }
+    std::unique_ptr<TraceWriter> writer = createTraceWriter(traceFormatForFileName(targetPath));
+    if (!writer) {
+        *error = QString("Неизвестный формат по расширению: %1").arg(targetPath);
+        return false;
+    }
+    if (!reader->open(sourcePath)) {
+        *error = reader->errorString();
+        return false;
+    }
+    if (!writer->open(targetPath)) {
+        *error = writer->errorString();
+        return false;
+    }
+    
+    QVector<CanFrame> batch(TRACE_BATCH_FRAMES);
+    TraceConversionStats result;
+    bool ok = true;
+    for (;;) {
+        const int count = reader->read(batch.data(), batch.size());
+        if (count < 0) {
+            *error = reader->errorString();
+            ok = false;
+            break;
+        }
+        if (count == 0) {
+            break;
+        }
+        if (!writer->write(batch.constData(), count)) {
+            *error = writer->errorString();
+            ok = false;
+            break;
+        }
+        result.frames += count;
+        if (progress && !progress(reader->position(), reader->size())) {
+            *error = "Преобразование прервано";
+            ok = false;
+            break;
+        }
+    }
+    
+    if (!writer->close() && ok) {
+        *error = writer->errorString();
+        ok = false;
+    }
+    result.skippedRecords = reader->skippedRecords();
+    reader->close();
+    if (stats) {
+        *stats = result;
+    }
+    return ok;
+}
@@ -0,0 +1,296 @@
+#include "transmitqueue.h"
+#include <algorithm>
+
+namespace {
+
+// Сравнение для std::push_heap/pop_heap: на вершине кадр, выигрывающий арбитраж
+bool losesArbitration(const TransmitRequest &a, const TransmitRequest &b)
+{
+    if (a.frame.id != b.frame.id) {
+        return a.frame.id > b.frame.id;
+    }
+    return a.sequence > b.sequence;
+}
+
+int priorityIndex(TransmitPriority priority)
+{
+    return qBound(0, static_cast<int>(priority), TransmitQueue::PRIORITY_COUNT - 1);
+}
+
+} // namespace
+
+TransmitQueue::TransmitQueue(int capacityPerPriority)
+    : m_capacity(qMax(1, capacityPerPriority))
+    , m_nextSequence(0)
+    , m_nextReleaseNs(0)
+    , m_queued(0)
+    , m_sent(0)
+    , m_failed(0)
+    , m_rateLimited(0)
+{
+    std::fill(std::begin(m_maxDepth), std::end(m_maxDepth), 0);
+    std::fill(std::begin(m_waiting), std::end(m_waiting), 0);
+}
+
+void TransmitQueue::push(TransmitRequest &&request)
+{
+    std::vector<TransmitRequest> &heap = m_heaps[priorityIndex(request.priority)];
+    heap.push_back(std::move(request));
+    std::push_heap(heap.begin(), heap.end(), losesArbitration);
+}
+
+bool TransmitQueue::enqueue(const CanFrame &frame, TransmitPriority priority, const TransmitCallbackPtr &callback)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        const int index = priorityIndex(priority);
+        const int depth = static_cast<int>(m_heaps[index].size()) + m_waiting[index];
+        if (depth < m_capacity) {
+            const quint64 nowNs = CanClock::nowNs();
+            TransmitRequest request = {frame, callback, m_nextSequence++, nowNs, priority};
+            auto limit = m_rateLimits.find(frame.id);
+            if (limit == m_rateLimits.end()) {
+                push(std::move(request));
+            } else if (!limit->inHeap && limit->waiting.empty() && nowNs >= limit->nextAllowedNs) {
+                // Окно открыто: кадр сразу участвует в арбитраже
+                limit->inHeap = true;
+                push(std::move(request));
+            } else {
+                // Кадр ждет окна; учитывается один раз, при постановке
+                limit->waiting.push_back(std::move(request));
+                m_waiting[index]++;
+                m_rateLimited.fetch_add(1, std::memory_order_relaxed);
+            }
+            m_maxDepth[index] = qMax(m_maxDepth[index], depth + 1);
+            m_queued.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    
+    m_failed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void TransmitQueue::releaseWaiting(quint64 nowNs)
+{
+    // Голова очереди ID переходит в кучу, когда открывается окно
+    m_nextReleaseNs = 0;
+    for (auto limit = m_rateLimits.begin(); limit != m_rateLimits.end(); ++limit) {
+        if (limit->inHeap || limit->waiting.empty()) {
+            continue;
+        }
+        if (nowNs < limit->nextAllowedNs) {
+            if (m_nextReleaseNs == 0 || limit->nextAllowedNs < m_nextReleaseNs) {
+                m_nextReleaseNs = limit->nextAllowedNs;
+            }
+            continue;
+        }
+        TransmitRequest &request = limit->waiting.front();
+        m_waiting[priorityIndex(request.priority)]--;
+        limit->inHeap = true;
+        push(std::move(request));
+        limit->waiting.pop_front();
+    }
+}
+
+int TransmitQueue::take(QVector<TransmitRequest> &requests, int maxCount, quint64 nowNs)
+{
+    QMutexLocker locker(&m_mutex);
+    releaseWaiting(nowNs);
+    int count = 0;
+    
+    for (int index = 0; index < PRIORITY_COUNT && count < maxCount; ++index) {
+        std::vector<TransmitRequest> &heap = m_heaps[index];
+        while (!heap.empty() && count < maxCount) {
+            std::pop_heap(heap.begin(), heap.end(), losesArbitration);
+            TransmitRequest request = std::move(heap.back());
+            heap.pop_back();
+            
+            // Кадр ID с ограничением частоты использует окно; следующий кадр
+            // этого ID перейдет в кучу при одном из следующих вызовов
+            auto limit = m_rateLimits.find(request.frame.id);
+            if (limit != m_rateLimits.end()) {
+                limit->nextAllowedNs = qMax(limit->nextAllowedNs, nowNs) + limit->intervalNs;
+                limit->inHeap = false;
+                if (!limit->waiting.empty()
+                    && (m_nextReleaseNs == 0 || limit->nextAllowedNs < m_nextReleaseNs)) {
+                    m_nextReleaseNs = limit->nextAllowedNs;
+                }
+            }
+            
+            const quint64 waitNs = nowNs > request.enqueuedNs ? nowNs - request.enqueuedNs : 0;
+            WaitStats &wait = m_wait[index];
+            wait.totalNs += waitNs;
+            wait.maxNs = qMax(wait.maxNs, waitNs);
+            wait.count++;
+            
+            requests.append(std::move(request));
+            ++count;
+        }
+    }
+    return count;
+}
+
+void TransmitQueue::requeue(const TransmitRequest *requests, int count)
+{
+    // Кадры сохраняют исходный порядок постановки и занимают прежнее место
+    QMutexLocker locker(&m_mutex);
+    for (int i = 0; i < count; ++i) {
+        TransmitRequest request = requests[i];
+        auto limit = m_rateLimits.find(request.frame.id);
+        if (limit != m_rateLimits.end()) {
+            // Окно не было использовано, кадр снова голова очереди ID
+            limit->nextAllowedNs -= qMin(limit->nextAllowedNs, limit->intervalNs);
+            limit->inHeap = true;
+        }
+        push(std::move(request));
+    }
+}
+
+void TransmitQueue::clear()
+{
+    std::vector<TransmitRequest> dropped;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (std::vector<TransmitRequest> &heap : m_heaps) {
+            std::move(heap.begin(), heap.end(), std::back_inserter(dropped));
+            heap.clear();
+        }
+        for (auto limit = m_rateLimits.begin(); limit != m_rateLimits.end(); ++limit) {
+            std::move(limit->waiting.begin(), limit->waiting.end(), std::back_inserter(dropped));
+            limit->waiting.clear();
+            limit->inHeap = false;
+        }
+        std::fill(std::begin(m_waiting), std::end(m_waiting), 0);
+        m_nextReleaseNs = 0;
+    }
+    
+    // Уведомления вызываются без блокировки: callback может поставить новый кадр
+    m_failed.fetch_add(dropped.size(), std::memory_order_relaxed);
+    for (const TransmitRequest &request : dropped) {
+        if (request.callback) {
+            (*request.callback)(false, request.frame);
+        }
+    }
+}
+
+bool TransmitQueue::isEmpty() const
+{
+    return pending() == 0;
+}
+
+int TransmitQueue::pending() const
+{
+    QMutexLocker locker(&m_mutex);
+    return pendingLocked();
+}
+
+int TransmitQueue::pendingLocked() const
+{
+    int total = 0;
+    for (int index = 0; index < PRIORITY_COUNT; ++index) {
+        total += static_cast<int>(m_heaps[index].size()) + m_waiting[index];
+    }
+    return total;
+}
+
+quint64 TransmitQueue::nextReleaseNs() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_nextReleaseNs;
+}
+
+void TransmitQueue::releaseAll(RateLimit &limit)
+{
+    // Ожидающие кадры возвращаются в кучи со своим порядком постановки
+    for (TransmitRequest &request : limit.waiting) {
+        m_waiting[priorityIndex(request.priority)]--;
+        push(std::move(request));
+    }
+    limit.waiting.clear();
+}
+
+void TransmitQueue::setRateLimit(quint32 id, int framesPerSecond)
+{
+    QMutexLocker locker(&m_mutex);
+    if (framesPerSecond <= 0) {
+        auto limit = m_rateLimits.find(id);
+        if (limit != m_rateLimits.end()) {
+            releaseAll(limit.value());
+            m_rateLimits.erase(limit);
+        }
+        return;
+    }
+    
+    const bool added = !m_rateLimits.contains(id);
+    RateLimit &limit = m_rateLimits[id];
+    limit.intervalNs = 1000000000ULL / static_cast<quint64>(framesPerSecond);
+    limit.nextAllowedNs = 0;
+    if (!added) {
+        return;
+    }
+    
+    // Кадры этого ID, уже стоящие в кучах, переходят в очередь ожидания
+    // и учитываются как ограниченные, как при постановке в enqueue()
+    for (int index = 0; index < PRIORITY_COUNT; ++index) {
+        std::vector<TransmitRequest> &heap = m_heaps[index];
+        auto moved = std::stable_partition(heap.begin(), heap.end(), [id](const TransmitRequest &request) {
+            return request.frame.id != id;
+        });
+        if (moved == heap.end()) {
+            continue;
+        }
+        const int count = static_cast<int>(heap.end() - moved);
+        m_waiting[index] += count;
+        m_rateLimited.fetch_add(count, std::memory_order_relaxed);
+        std::move(moved, heap.end(), std::back_inserter(limit.waiting));
+        heap.erase(moved, heap.end());
+        std::make_heap(heap.begin(), heap.end(), losesArbitration);
+    }
+    std::sort(limit.waiting.begin(), limit.waiting.end(), [](const TransmitRequest &a, const TransmitRequest &b) {
+        return a.sequence < b.sequence;
+    });
+}
+
+void TransmitQueue::clearRateLimits()
+{
+    QMutexLocker locker(&m_mutex);
+    for (auto limit = m_rateLimits.begin(); limit != m_rateLimits.end(); ++limit) {
+        releaseAll(limit.value());
+    }
+    m_rateLimits.clear();
+}
+
+TransmitStatistics TransmitQueue::statistics() const
+{
+    TransmitStatistics stats;
+    stats.queued = m_queued.load(std::memory_order_relaxed);
+    stats.sent = m_sent.load(std::memory_order_relaxed);
+    stats.failed = m_failed.load(std::memory_order_relaxed);
+    stats.rateLimited = m_rateLimited.load(std::memory_order_relaxed);
+    
+    QMutexLocker locker(&m_mutex);
+    stats.pending = pendingLocked();
+    for (int index = 0; index < PRIORITY_COUNT; ++index) {
+        const WaitStats &wait = m_wait[index];
+        stats.pendingPerPriority[index] = static_cast<int>(m_heaps[index].size()) + m_waiting[index];
+        stats.maxDepthPerPriority[index] = m_maxDepth[index];
+        stats.averageWaitUs[index] = wait.count > 0 ? wait.totalNs / wait.count / 1000 : 0;
+        stats.maxWaitUs[index] = wait.maxNs / 1000;
+    }
+    return stats;
+}
+
+void TransmitQueue::resetStatistics()
+{
+    m_queued.store(0, std::memory_order_relaxed);
+    m_sent.store(0, std::memory_order_relaxed);
+    m_failed.store(0, std::memory_order_relaxed);
+    m_rateLimited.store(0, std::memory_order_relaxed);
+    
+    QMutexLocker locker(&m_mutex);
+    for (int index = 0; index < PRIORITY_COUNT; ++index) {
+        m_maxDepth[index] = static_cast<int>(m_heaps[index].size()) + m_waiting[index];
+        m_wait[index] = WaitStats();
+    }
+}
@@ -0,0 +1,239 @@
+#include "usbloopbackbackend.h"
+#include "scanmaticprotocol.h"
+#include <QMutexLocker>
+#include <QThread>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <thread>
+
+UsbLoopbackBackend::UsbLoopbackBackend()
+    : UsbLoopbackBackend(Config())
+{
+}
+
+UsbLoopbackBackend::UsbLoopbackBackend(const Config &config)
+    : m_config(config)
+    , m_isOpen(false)
+    , m_transferCount(1)
+    , m_transferSize(512)
+    , m_generatorThread(nullptr)
+    , m_stopping(false)
+    , m_initReceived(false)
+    , m_packets(0)
+    , m_bytesIn(0)
+    , m_framesGenerated(0)
+    , m_framesEchoed(0)
+    , m_writes(0)
+    , m_bytesOut(0)
+{
+}
+
+UsbLoopbackBackend::~UsbLoopbackBackend()
+{
+    close();
+}
+
+bool UsbLoopbackBackend::open(quint16 vendorId, quint16 productId, int transferCount, int transferSize)
+{
+    Q_UNUSED(vendorId);
+    Q_UNUSED(productId);
+    
+    if (m_isOpen) {
+        close();
+    }
+    
+    m_transferCount = qMax(1, transferCount);
+    m_transferSize = qMax(1, transferSize);
+    m_initReceived = !m_config.waitForInit;
+    m_packets = 0;
+    m_bytesIn = 0;
+    m_framesGenerated = 0;
+    m_framesEchoed = 0;
+    m_writes = 0;
+    m_bytesOut = 0;
+    {
+        QMutexLocker locker(&m_echoMutex);
+        m_echo.clear();
+    }
+    
+    m_stopping = false;
+    m_isOpen = true;
+    m_generatorThread = QThread::create([this]() { runGenerator(); });
+    m_generatorThread->setObjectName("USBLoopbackThread");
+    m_generatorThread->start(QThread::TimeCriticalPriority);
+    return true;
+}
+
+void UsbLoopbackBackend::close()
+{
+    m_stopping = true;
+    if (m_generatorThread) {
+        m_generatorThread->wait();
+        delete m_generatorThread;
+        m_generatorThread = nullptr;
+    }
+    m_isOpen = false;
+}
+
+int UsbLoopbackBackend::write(const QByteArray &data)
+{
+    if (!m_isOpen) {
+        m_lastError = "Устройство не открыто";
+        return -1;
+    }
+    
+    if (m_config.writeLatencyUs > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(m_config.writeLatencyUs));
+    }
+    
+    m_writes++;
+    m_bytesOut += data.size();
+    
+    // Разбор записи так же, как это делает адаптер
+    const quint8 *bytes = reinterpret_cast<const quint8*>(data.constData());
+    const int size = data.size();
+    int pos = 0;
+    while (pos + 1 < size) {
+        if (bytes[pos] != ScanmaticProtocol::FRAME_START) {
+            ++pos;
+            continue;
+        }
+        
+        if (bytes[pos + 1] == ScanmaticProtocol::CMD_INIT && pos + 4 < size) {
+            m_initReceived = true;
+            pos += 5;
+        } else if (bytes[pos + 1] == ScanmaticProtocol::TYPE_CAN_DATA && pos + 2 < size) {
+            const int frameSize = 8 + qMin<int>(bytes[pos + 2], 8);
+            if (pos + frameSize > size) {
+                break;
+            }
+            if (m_config.echoWrites) {
+                QMutexLocker locker(&m_echoMutex);
+                m_echo.append(data.constData() + pos, frameSize);
+                m_framesEchoed++;
+            }
+            pos += frameSize;
+        } else {
+            ++pos;
+        }
+    }
+    
+    return size;
+}
+
+QByteArray UsbLoopbackBackend::read(int timeoutMs)
+{
+    // Весь прием идет через асинхронную выдачу пакетов
+    Q_UNUSED(timeoutMs);
+    return QByteArray();
+}
+
+UsbLoopbackBackend::Statistics UsbLoopbackBackend::statistics() const
+{
+    Statistics stats;
+    stats.packets = m_packets;
+    stats.bytesIn = m_bytesIn;
+    stats.framesGenerated = m_framesGenerated;
+    stats.framesEchoed = m_framesEchoed;
+    stats.writes = m_writes;
+    stats.bytesOut = m_bytesOut;
+    stats.initReceived = m_initReceived;
+    return stats;
+}
+
+void UsbLoopbackBackend::appendGenerated(QByteArray &stream, int count)
+{
+    const int dlc = qBound(0, m_config.dlc, 8);
+    const int idCount = qMax(1, m_config.idCount);
+    quint64 sequence = m_framesGenerated;
+    
+    for (int i = 0; i < count; ++i, ++sequence) {
+        CanFrame frame = {};
+        frame.id = m_config.firstId + static_cast<quint32>(sequence % idCount);
+        frame.dlc = static_cast<quint8>(dlc);
+        if (m_config.embedTimestamp && dlc == 8) {
+            const quint64 nowNs = CanClock::nowNs();
+            std::memcpy(frame.data, &nowNs, sizeof(nowNs));
+        } else {
+            for (int j = 0; j < dlc; ++j) {
+                frame.data[j] = static_cast<quint8>(sequence >> (8 * (j % 8)));
+            }
+        }
+        ScanmaticProtocol::appendFrame(stream, frame);
+    }
+    
+    m_framesGenerated = sequence;
+}
+
+void UsbLoopbackBackend::runGenerator()
+{
+    // Пакет здесь - один завершенный запрос bulk IN, он не длиннее буфера запроса
+    const int minPacket = qBound(1, m_config.packetSize, m_transferSize);
+    const int maxPacket = qBound(minPacket, m_config.packetSizeMax, m_transferSize);
+    const auto interval = std::chrono::microseconds(qMax(1, m_config.packetIntervalUs));
+    const quint64 maxBurst = static_cast<quint64>(m_config.frameRate) * MAX_BURST_MS / 1000 + 1;
+    // Без ограничения частоты за один период заполняются все запросы приема
+    const int unlimitedBurst = qMax(1, m_transferCount * m_transferSize / (8 + 8));
+    
+    std::mt19937 random(0x5CA1AB1E);
+    std::uniform_int_distribution<int> packetSize(minPacket, maxPacket);
+    QByteArray stream;
+    stream.reserve(m_transferCount * m_transferSize);
+    
+    quint64 streamStartNs = 0;
+    quint64 scheduled = 0; // Кадров, положенных по частоте с начала потока
+    auto wake = std::chrono::steady_clock::now();
+    
+    while (!m_stopping) {
+        wake += interval;
+        const auto now = std::chrono::steady_clock::now();
+        if (wake < now) {
+            wake = now; // Поток отстал, период отсчитывается заново
+        } else {
+            std::this_thread::sleep_until(wake);
+        }
+        
+        int count = 0;
+        if (m_initReceived) {
+            const quint64 nowNs = CanClock::nowNs();
+            if (streamStartNs == 0) {
+                streamStartNs = nowNs;
+            }
+            
+            if (m_config.frameRate > 0) {
+                // В микросекундах, чтобы произведение не переполнялось при долгой работе
+                const quint64 target = (nowNs - streamStartNs) / 1000 * m_config.frameRate / 1000000;
+                if (target - scheduled > maxBurst) {
+                    scheduled = target - maxBurst;
+                }
+                count = static_cast<int>(target - scheduled);
+                scheduled = target;
+            } else {
+                count = unlimitedBurst;
+            }
+        }
+        
+        stream.clear();
+        appendGenerated(stream, count);
+        {
+            QMutexLocker locker(&m_echoMutex);
+            if (!m_echo.isEmpty()) {
+                stream.append(m_echo);
+                m_echo.clear();
+            }
+        }
+        
+        // Поток байт режется на пакеты без учета границ кадров, как у адаптера
+        int offset = 0;
+        while (offset < stream.size() && !m_stopping) {
+            const int size = qMin(packetSize(random), static_cast<int>(stream.size()) - offset);
+            if (m_onData) {
+                m_onData(stream.constData() + offset, size);
+            }
+            offset += size;
+            m_packets++;
+            m_bytesIn += size;
+        }
+    }
+}
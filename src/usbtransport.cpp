@@ -0,0 +1,92 @@
+#include "usbtransport.h"
+#include "usbdevice.h"
+#include <QDebug>
+
+UsbTransport::UsbTransport(QObject *parent)
+    : ScanmaticTransport(parent)
+{
+    m_usbDevice = new USBDevice(this);
+    
+    // Данные приходят из потока событий libusb, разбор - в потоке транспорта
+    connect(m_usbDevice, &USBDevice::dataReceived, this, [this](const QByteArray &data) {
+        if (m_usbDevice->isOpen()) {
+            ingest(data.constData(), data.size(), CanClock::nowNs());
+        }
+    }, Qt::QueuedConnection);
+    connect(m_usbDevice, &USBDevice::errorOccurred, this, &UsbTransport::errorOccurred);
+}
+
+QString UsbTransport::name() const
+{
+    return "USB";
+}
+
+bool UsbTransport::isOpen() const
+{
+    return m_usbDevice->isOpen();
+}
+
+bool UsbTransport::open(quint16 vendorId, quint16 productId, int baudRateKbps)
+{
+    if (isOpen()) {
+        close();
+    }
+    
+    qDebug() << "Попытка подключения к USB устройству VID:" << QString::number(vendorId, 16)
+             << "PID:" << QString::number(productId, 16);
+    
+    if (!m_usbDevice->open(vendorId, productId)) {
+        m_lastError = QString("Не удалось открыть USB устройство: %1").arg(m_usbDevice->errorString());
+        return false;
+    }
+    
+    resetParser();
+    
+    // Задержка для инициализации устройства
+    settle(100);
+    
+    if (!sendInitCommand(baudRateKbps)) {
+        m_lastError = QString("Ошибка записи команды инициализации: %1").arg(m_usbDevice->errorString());
+        m_usbDevice->close();
+        return false;
+    }
+    
+    // Дополнительная задержка после отправки команды инициализации
+    settle(200);
+    return true;
+}
+
+void UsbTransport::close()
+{
+    m_usbDevice->close();
+    resetParser();
+}
+
+ScanmaticTransport::WriteStatus UsbTransport::writeBytes(const QByteArray &bytes)
+{
+    if (!m_usbDevice->isOpen()) {
+        m_lastError = "USB устройство не открыто";
+        return WriteFailed;
+    }
+    
+    int offset = 0;
+    while (offset < bytes.size()) {
+        const int written = m_usbDevice->write(offset == 0 ? bytes : bytes.mid(offset));
+        if (written < 0) {
+            m_lastError = QString("Ошибка записи в USB: %1").arg(m_usbDevice->errorString());
+            return WriteFailed;
+        }
+        if (written == 0) {
+            if (offset == 0) {
+                // Устройство не принимает данные (NAK): пачка вернется в очередь
+                m_lastError = "USB устройство не принимает данные";
+                return WriteBusy;
+            }
+            // Начатый кадр нельзя вернуть в очередь: поток байт адаптера уже нарушен
+            m_lastError = QString("Запись в USB прервана: записано %1 из %2 байт").arg(offset).arg(bytes.size());
+            return WriteFailed;
+        }
+        offset += written;
+    }
+    return WriteOk;
+}
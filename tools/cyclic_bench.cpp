@@ -0,0 +1,163 @@
+// Проверка циклической передачи без адаптера: десятки периодических
+// сообщений (10/20/100 мс, сдвинутые фазы) через CyclicTransmitter,
+// CANInterface и UsbLoopbackBackend, одновременно с приемом потока кадров.
+// Итог - CyclicStatistics по группам периодов: отправки, отказы,
+// пропущенные периоды и опоздание записи в устройство относительно расписания.
+//
+// Пример:
+//   cyclic_bench --messages 48 --rx-rate 5000 --bulk-rate 2000 --duration 30
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QTimer>
+#include <cstdio>
+#include <iterator>
+#include <memory>
+#include "caninterface.h"
+#include "cyclictransmitter.h"
+#include "usbloopbackbackend.h"
+
+namespace {
+
+constexpr int PERIODS_US[] = {10000, 20000, 100000};
+constexpr quint32 FIRST_CYCLIC_ID = 0x200;
+constexpr quint32 BULK_ID = 0x600;
+constexpr int BULK_TICK_MS = 1;
+constexpr int DRAIN_MS = 200;   // Дозапись кадров, поставленных до остановки расписания
+
+// Итоги группы сообщений с одним периодом
+struct PeriodSummary {
+    int messages = 0;
+    quint64 sent = 0;
+    quint64 failed = 0;
+    quint64 missedCycles = 0;
+    quint64 lateTotalUs = 0;   // Сумма средних, взвешенных числом отправок
+    quint64 maxJitterUs = 0;
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Циклическая передача через UsbLoopbackBackend");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"messages", "Число периодических сообщений", "N", "48"},
+        {"rx-rate", "Кадров приема в секунду от backend'а, 0 - без ограничения", "N", "2000"},
+        {"bulk-rate", "Фоновых кадров Bulk в секунду", "N", "0"},
+        {"write-latency-us", "Задержка записи bulk OUT", "US", "0"},
+        {"duration", "Длительность, с", "S", "10"},
+        {"no-acquisition-thread", "Сбор в основном потоке"},
+    });
+    parser.process(app);
+    
+    const int messageCount = qMax(1, parser.value("messages").toInt());
+    const int bulkRate = parser.value("bulk-rate").toInt();
+    const int durationMs = qMax(1, static_cast<int>(parser.value("duration").toDouble() * 1000));
+    
+    UsbLoopbackBackend::Config config;
+    config.frameRate = parser.value("rx-rate").toInt();
+    config.writeLatencyUs = parser.value("write-latency-us").toInt();
+    config.embedTimestamp = false;
+    
+    CANInterface can;
+    can.setAcquisitionThreadEnabled(!parser.isSet("no-acquisition-thread"));
+    can.setUSBBackend(std::make_unique<UsbLoopbackBackend>(config));
+    QObject::connect(&can, &CANInterface::errorOccurred, &app, [](const QString &error) {
+        std::fprintf(stderr, "Ошибка: %s\n", qPrintable(error));
+    });
+    if (!can.connectUSB()) {
+        std::fprintf(stderr, "connectUSB() не выполнен\n");
+        return 1;
+    }
+    
+    // Периоды по кругу, фазы разнесены внутри периода, как у ЭБУ на шине.
+    // Счетчик в младшей тетраде байта 0 и сумма в байте 7.
+    CyclicTransmitter cyclic(&can);
+    for (int i = 0; i < messageCount; ++i) {
+        const int periodUs = PERIODS_US[i % std::size(PERIODS_US)];
+        const int phaseUs = (i * 1370) % periodUs;
+        const int handle = cyclic.addMessage(FIRST_CYCLIC_ID + i, QByteArray(8, char(i)), periodUs, phaseUs);
+        cyclic.addHook(handle, CyclicTransmitter::counterHook(0, 0x0F));
+        cyclic.addHook(handle, CyclicTransmitter::checksumHook(7));
+    }
+    
+    // Фоновая передача класса Bulk: циклические кадры должны уходить раньше
+    QTimer bulkTimer;
+    QElapsedTimer bulkClock;
+    quint64 bulkScheduled = 0;
+    if (bulkRate > 0) {
+        bulkTimer.setTimerType(Qt::PreciseTimer);
+        QObject::connect(&bulkTimer, &QTimer::timeout, &app, [&]() {
+            const quint64 target = static_cast<quint64>(bulkClock.nsecsElapsed() / 1000) * bulkRate / 1000000;
+            QVector<CanFrame> batch;
+            for (; bulkScheduled < target; ++bulkScheduled) {
+                batch.append(CanFrame::make(BULK_ID, QByteArray(8, '\0'), 0, 0));
+            }
+            can.sendFrames(batch.constData(), batch.size());
+        });
+        bulkClock.start();
+        bulkTimer.start(BULK_TICK_MS);
+    }
+    
+    QElapsedTimer runClock;
+    runClock.start();
+    cyclic.start();
+    
+    QTimer::singleShot(durationMs, &app, [&]() {
+        cyclic.stop();
+        bulkTimer.stop();
+        const double seconds = runClock.elapsed() / 1000.0;
+        
+        QTimer::singleShot(DRAIN_MS, &app, [&, seconds]() {
+            QMap<int, PeriodSummary> summaries;
+            for (const CyclicStatistics &stats : cyclic.statistics()) {
+                PeriodSummary &summary = summaries[stats.periodUs];
+                summary.messages++;
+                summary.sent += stats.sent;
+                summary.failed += stats.failed;
+                summary.missedCycles += stats.missedCycles;
+                summary.lateTotalUs += stats.averageJitterUs * stats.sent;
+                summary.maxJitterUs = qMax(summary.maxJitterUs, stats.maxJitterUs);
+            }
+            
+            std::printf("Сообщений: %d, %.1f с, прием %d кадров/с, Bulk %d кадров/с\n\n",
+                        messageCount, seconds, config.frameRate, bulkRate);
+            std::printf("%10s %9s %10s %10s %8s %10s %12s %12s\n",
+                        "период мс", "сообщ.", "ожидалось", "записано", "отказы", "пропуски",
+                        "опозд. ср.", "опозд. max");
+            for (auto it = summaries.constBegin(); it != summaries.constEnd(); ++it) {
+                const PeriodSummary &summary = it.value();
+                const quint64 expected = static_cast<quint64>(seconds * 1e6 / it.key()) * summary.messages;
+                std::printf("%10.1f %9d %10llu %10llu %8llu %10llu %9llu мкс %9llu мкс\n",
+                            it.key() / 1000.0, summary.messages,
+                            static_cast<unsigned long long>(expected),
+                            static_cast<unsigned long long>(summary.sent),
+                            static_cast<unsigned long long>(summary.failed),
+                            static_cast<unsigned long long>(summary.missedCycles),
+                            static_cast<unsigned long long>(summary.sent > 0 ? summary.lateTotalUs / summary.sent : 0),
+                            static_cast<unsigned long long>(summary.maxJitterUs));
+            }
+            
+            const TransmitStatistics txStats = can.getTransmitStatistics();
+            const int periodic = static_cast<int>(TransmitPriority::Periodic);
+            const int bulk = static_cast<int>(TransmitPriority::Bulk);
+            std::printf("\nОжидание в очереди передачи: Periodic среднее %llu мкс, max %llu мкс; "
+                        "Bulk среднее %llu мкс, max %llu мкс\n",
+                        static_cast<unsigned long long>(txStats.averageWaitUs[periodic]),
+                        static_cast<unsigned long long>(txStats.maxWaitUs[periodic]),
+                        static_cast<unsigned long long>(txStats.averageWaitUs[bulk]),
+                        static_cast<unsigned long long>(txStats.maxWaitUs[bulk]));
+            
+            can.disconnect();
+            app.quit();
+        });
+    });
+    
+    return app.exec();
+}
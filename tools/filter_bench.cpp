@@ -0,0 +1,115 @@
+// Стоимость фильтрации на кадр: выражения FilterExpression, набор правил
+// FilterEngine и ручная проверка на C++ для сравнения.
+//
+// Пример:
+//   filter_bench                         - типовые выражения
+//   filter_bench "id == 0x7E8 && data[1] == 0x62" "data[2].3"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+#include "filterengine.h"
+#include "filterexpression.h"
+
+namespace {
+
+constexpr int FRAME_COUNT = 65536;        // Кадров в наборе (помещается в L2)
+constexpr qint64 MIN_DURATION_NS = 300000000; // Минимум 0.3 с на замер
+
+// Поток, похожий на реальную шину: периодические кадры 11-бит, ответы
+// диагностики 0x7E8 и немного 29-битных кадров J1939
+std::vector<CanFrame> makeFrames()
+{
+    std::mt19937 random(42);
+    std::vector<CanFrame> frames(FRAME_COUNT);
+    for (CanFrame &frame : frames) {
+        frame = CanFrame();
+        const unsigned kind = random() % 100;
+        if (kind < 10) {
+            frame.id = 0x7E8;
+        } else if (kind < 20) {
+            frame.id = 0x18DA00F1 | ((random() % 16) << 8);
+            frame.flags = CanFrame::FLAG_EXTENDED;
+        } else {
+            frame.id = 0x100 + random() % 0x200;
+        }
+        frame.dlc = kind < 95 ? 8 : random() % 8;
+        for (int i = 0; i < frame.dlc; ++i) {
+            frame.data[i] = static_cast<quint8>(random());
+        }
+        if (frame.id == 0x7E8 && random() % 2) {
+            frame.data[1] = 0x62;
+        }
+    }
+    return frames;
+}
+
+// Наносекунд на кадр и доля прошедших кадров
+void measure(const char *title, const std::vector<CanFrame> &frames, const std::function<bool(const CanFrame&)> &predicate)
+{
+    quint64 passed = 0;
+    quint64 evaluated = 0;
+    QElapsedTimer timer;
+    timer.start();
+    do {
+        for (const CanFrame &frame : frames) {
+            passed += predicate(frame);
+        }
+        evaluated += frames.size();
+    } while (timer.nsecsElapsed() < MIN_DURATION_NS);
+    const double nsPerFrame = static_cast<double>(timer.nsecsElapsed()) / evaluated;
+    
+    std::printf("%-60s %7.2f нс/кадр  %5.1f%% прошло\n", title, nsPerFrame, 100.0 * passed / evaluated);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    
+    QStringList expressions = app.arguments().mid(1);
+    if (expressions.isEmpty()) {
+        expressions = {
+            "id == 0x7E8 && data[1] == 0x62",
+            "data[2].3",
+            "(word[0] & 0xFFF0) != 0x1230 || ext",
+            "id >= 0x100 && id <= 0x1FF && data[0] > 0x80 && data[7] != 0",
+            "!ext && (data[0] & 0x0F) == 3 && (id == 0x7E8 || id == 0x7E9)",
+        };
+    }
+    
+    const std::vector<CanFrame> frames = makeFrames();
+    std::printf("Кадров в наборе: %d\n\n", FRAME_COUNT);
+    
+    // Опорные значения: пустой цикл и та же проверка, написанная вручную
+    measure("[C++] без фильтра", frames, [](const CanFrame &) { return true; });
+    measure("[C++] id == 0x7E8 && data[1] == 0x62", frames, [](const CanFrame &frame) {
+        return frame.id == 0x7E8 && frame.dlc > 1 && frame.data[1] == 0x62;
+    });
+    
+    FilterEngine engine({FilterRule::range(0x100, 0x1FF, false), FilterRule::exact(0x7E8, true),
+                         FilterRule::mask(0x18DA00F1, 0x1FFF00FF, false)});
+    measure("[FilterEngine] диапазон + ID + маска", frames, [&engine](const CanFrame &frame) {
+        return engine.accept(frame.id);
+    });
+    
+    for (const QString &text : expressions) {
+        FilterExpression expression;
+        if (!expression.compile(text)) {
+            std::printf("%s: %s (позиция %d)\n", qPrintable(text), qPrintable(expression.errorString()),
+                        expression.errorPosition() + 1);
+            continue;
+        }
+        const QString title = QString("%1 [%2 инстр.]").arg(text).arg(expression.instructionCount());
+        measure(qPrintable(title), frames, [&expression](const CanFrame &frame) {
+            return expression.matches(frame);
+        });
+    }
+    
+    return 0;
+}
@@ -0,0 +1,135 @@
+// Скорость разбора потока Scanmatic: синтетический поток кадров подается
+// в ScanmaticParser порциями, как при чтении из порта или USB.
+//
+// Пример:
+//   parser_bench              - 1024 МБ потока, чтение по 4096 байт
+//   parser_bench 256 64       - 256 МБ потока, чтение по 64 байта
+//   parser_bench 1024 4096 random - длина данных равновероятно 0-8 байт
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "filterengine.h"
+#include "scanmaticparser.h"
+
+namespace {
+
+constexpr int PATTERN_SIZE = 16 * 1024 * 1024;  // Образец потока, повторяется до нужного объема
+constexpr int DEFAULT_STREAM_MB = 1024;
+constexpr int DEFAULT_READ_SIZE = 4096;
+
+// Кадры того же состава, что в filter_bench: периодические 11-бит, ответы
+// диагностики 0x7E8 и 29-битные J1939. Длина данных - 8 байт у 95% кадров
+// или равновероятно 0-8 (randomDlc). Образец заканчивается на границе кадра.
+std::vector<quint8> makePattern(bool randomDlc, quint64 &frameCount)
+{
+    std::mt19937 random(42);
+    std::vector<quint8> pattern;
+    pattern.reserve(PATTERN_SIZE);
+    frameCount = 0;
+    while (pattern.size() + ScanmaticParser::MAX_FRAME_SIZE <= static_cast<size_t>(PATTERN_SIZE)) {
+        const unsigned kind = random() % 100;
+        quint32 id;
+        if (kind < 10) {
+            id = 0x7E8;
+        } else if (kind < 20) {
+            id = 0x18DA00F1 | ((random() % 16) << 8);
+        } else {
+            id = 0x100 + random() % 0x200;
+        }
+        const quint8 dlc = randomDlc ? random() % 9 : (kind < 95 ? 8 : random() % 8);
+        
+        pattern.push_back(ScanmaticParser::FRAME_START);
+        pattern.push_back(ScanmaticParser::TYPE_CAN_DATA);
+        pattern.push_back(dlc);
+        pattern.push_back(static_cast<quint8>(id >> 24));
+        pattern.push_back(static_cast<quint8>(id >> 16));
+        pattern.push_back(static_cast<quint8>(id >> 8));
+        pattern.push_back(static_cast<quint8>(id));
+        for (int i = 0; i < dlc; ++i) {
+            pattern.push_back(static_cast<quint8>(random()));
+        }
+        pattern.push_back(ScanmaticParser::FRAME_END);
+        frameCount++;
+    }
+    return pattern;
+}
+
+// Подача streamBytes байт порциями по readSize, разбор после каждой порции
+void measure(const char *title, const std::vector<quint8> &pattern, quint64 patternFrames,
+             quint64 streamBytes, int readSize, FilterEngine *filter)
+{
+    ScanmaticParser parser;
+    quint64 parsed = 0;
+    quint64 fed = 0;
+    quint64 checksum = 0;
+    size_t offset = 0;
+    CanFrame frame;
+    
+    QElapsedTimer timer;
+    timer.start();
+    while (fed < streamBytes) {
+        const int chunk = static_cast<int>(qMin<quint64>(qMin(readSize, parser.writableBytes()),
+                                                         pattern.size() - offset));
+        std::memcpy(parser.writePointer(), pattern.data() + offset, chunk);
+        parser.commit(chunk);
+        offset = (offset + chunk) % pattern.size();
+        fed += chunk;
+        
+        while (parser.next(frame, filter)) {
+            checksum += frame.id + frame.data[0];
+            parsed++;
+        }
+        parser.compact();
+    }
+    const qint64 elapsedNs = timer.nsecsElapsed();
+    
+    const double seconds = elapsedNs / 1e9;
+    const double streamFrames = static_cast<double>(fed) / pattern.size() * patternFrames;
+    std::printf("%-28s %8.2f М кадров/с  %8.1f МБ/с  %6.2f нс/кадр  (принято %llu, контроль %llx)\n",
+                title, streamFrames / seconds / 1e6, fed / seconds / (1024.0 * 1024.0),
+                elapsedNs / streamFrames, static_cast<unsigned long long>(parsed),
+                static_cast<unsigned long long>(checksum));
+    if (parser.malformedFrames() > 0 || parser.skippedBytes() > 0) {
+        std::printf("  ошибки разбора: %llu кадров, %llu байт пропущено\n",
+                    static_cast<unsigned long long>(parser.malformedFrames()),
+                    static_cast<unsigned long long>(parser.skippedBytes()));
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments().mid(1);
+    
+    const int streamMb = args.size() > 0 ? args.at(0).toInt() : DEFAULT_STREAM_MB;
+    const int readSize = args.size() > 1 ? args.at(1).toInt() : DEFAULT_READ_SIZE;
+    const bool randomDlc = args.size() > 2 && args.at(2) == "random";
+    if (streamMb <= 0 || readSize <= 0) {
+        std::fprintf(stderr, "Использование: parser_bench [МБ потока] [байт за чтение] [random]\n");
+        return 1;
+    }
+    
+    quint64 patternFrames = 0;
+    const std::vector<quint8> pattern = makePattern(randomDlc, patternFrames);
+    const quint64 streamBytes = static_cast<quint64>(streamMb) * 1024 * 1024;
+    std::printf("Поток: %d МБ (образец %zu байт, %llu кадров, данные %s), чтение по %d байт\n\n",
+                streamMb, pattern.size(), static_cast<unsigned long long>(patternFrames),
+                randomDlc ? "0-8 байт" : "8 байт у 95%", readSize);
+    
+    measure("без фильтра", pattern, patternFrames, streamBytes, readSize, nullptr);
+    
+    // Проходят только ответы 0x7E8 (около 10% кадров), остальные
+    // отбрасываются по ID без копирования данных
+    FilterEngine engine({FilterRule::exact(0x7E8, true), FilterRule::range(0x100, 0x2FF, false),
+                         FilterRule::mask(0x18DA00F1, 0x1FFF00FF, false)});
+    measure("FilterEngine: только 0x7E8", pattern, patternFrames, streamBytes, readSize, &engine);
+    
+    return 0;
+}
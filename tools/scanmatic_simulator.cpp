@@ -0,0 +1,491 @@
+// Симулятор адаптера Scanmatic 2 Pro на псевдотерминале (Linux).
+//
+// Открывает пару pty, отвечает на команду инициализации 0xAA 0x01 и
+// отправляет кадры 0xAA 0x02 len ID[4] data 0x55 с заданной частотой,
+// пачками и с дроблением записи. Позволяет проверить connect(), разбор
+// и интерфейс без устройства, в том числе на скоростях выше 1 Мбит/с.
+//
+// Пример:
+//   scanmatic_simulator --bus-kbps 1000 --burst 32 --fragment 1:64
+//   CANReader -> порт /tmp/ttyScanmaticSim
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint8_t FRAME_START = 0xAA;
+constexpr uint8_t FRAME_END = 0x55;
+constexpr uint8_t CMD_INIT = 0x01;
+constexpr uint8_t TYPE_CAN_DATA = 0x02;
+constexpr int HEADER_SIZE = 7;
+constexpr const char *DEFAULT_LINK = "/tmp/ttyScanmaticSim";
+
+volatile sig_atomic_t g_stop = 0;
+
+struct Options {
+    std::string link = DEFAULT_LINK;
+    double rate = 1000.0;      // Кадров в секунду, 0 - без ограничения
+    int busKbps = 0;           // Если задано - частота по загрузке шины 100%
+    int burst = 1;             // Кадров подряд в одной записи
+    int fragmentMin = 0;       // Дробление записи, 0 - без дробления
+    int fragmentMax = 0;
+    int idCount = 16;          // Число разных ID, начиная с firstId
+    uint32_t firstId = 0x100;
+    bool extended = false;
+    int dlc = 8;
+    double garbage = 0.0;      // Доля пачек с мусорными байтами между кадрами
+    double duration = 0.0;     // Секунд, 0 - до остановки
+    uint64_t count = 0;        // Кадров, 0 - без ограничения
+    bool waitInit = true;
+    bool echo = false;         // Возвращать принятые кадры передачи как прием
+    uint32_t seed = 1;
+};
+
+uint64_t nowNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+void sleepUntil(uint64_t deadlineNs)
+{
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(deadlineNs / 1000000000ULL);
+    ts.tv_nsec = static_cast<long>(deadlineNs % 1000000000ULL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR && !g_stop) {
+    }
+}
+
+// Число бит кадра на шине: поля кадра плюс худший случай бит-стаффинга
+int bitsPerFrame(bool extended, int dlc)
+{
+    const int stuffable = (extended ? 54 : 34) + 8 * dlc;
+    const int fixed = 13; // CRC delimiter, ACK, EOF, межкадровый интервал
+    return stuffable + (stuffable - 1) / 4 + fixed;
+}
+
+void usage(const char *program)
+{
+    std::fprintf(stderr,
+        "Использование: %s [параметры]\n"
+        "  --link PATH        символическая ссылка на порт (по умолчанию %s)\n"
+        "  --rate N           кадров в секунду, 0 - без ограничения (1000)\n"
+        "  --bus-kbps N       частота по 100%% загрузке шины N кбит/с\n"
+        "  --burst N          кадров в одной записи (1)\n"
+        "  --fragment MIN:MAX дробить запись на куски MIN..MAX байт\n"
+        "  --ids N            число разных ID (16)\n"
+        "  --first-id HEX     первый ID (100)\n"
+        "  --extended         29-битные ID\n"
+        "  --dlc N            длина данных 0-8 (8)\n"
+        "  --garbage P        доля пачек с мусором между кадрами 0..1 (0)\n"
+        "  --duration S       время работы, секунд\n"
+        "  --count N          число кадров\n"
+        "  --no-wait-init     не ждать команды инициализации\n"
+        "  --echo             возвращать кадры, отправленные приложением\n"
+        "  --seed N           начальное значение генератора (1)\n",
+        program, DEFAULT_LINK);
+}
+
+bool parseOptions(int argc, char **argv, Options &options)
+{
+    enum { OPT_LINK = 1000, OPT_RATE, OPT_BUS, OPT_BURST, OPT_FRAGMENT, OPT_IDS, OPT_FIRST_ID,
+           OPT_EXTENDED, OPT_DLC, OPT_GARBAGE, OPT_DURATION, OPT_COUNT, OPT_NO_WAIT, OPT_ECHO,
+           OPT_SEED, OPT_HELP };
+    static const option longOptions[] = {
+        {"link", required_argument, nullptr, OPT_LINK},
+        {"rate", required_argument, nullptr, OPT_RATE},
+        {"bus-kbps", required_argument, nullptr, OPT_BUS},
+        {"burst", required_argument, nullptr, OPT_BURST},
+        {"fragment", required_argument, nullptr, OPT_FRAGMENT},
+        {"ids", required_argument, nullptr, OPT_IDS},
+        {"first-id", required_argument, nullptr, OPT_FIRST_ID},
+        {"extended", no_argument, nullptr, OPT_EXTENDED},
+        {"dlc", required_argument, nullptr, OPT_DLC},
+        {"garbage", required_argument, nullptr, OPT_GARBAGE},
+        {"duration", required_argument, nullptr, OPT_DURATION},
+        {"count", required_argument, nullptr, OPT_COUNT},
+        {"no-wait-init", no_argument, nullptr, OPT_NO_WAIT},
+        {"echo", no_argument, nullptr, OPT_ECHO},
+        {"seed", required_argument, nullptr, OPT_SEED},
+        {"help", no_argument, nullptr, OPT_HELP},
+        {nullptr, 0, nullptr, 0},
+    };
+    
+    int option;
+    while ((option = getopt_long(argc, argv, "", longOptions, nullptr)) != -1) {
+        switch (option) {
+            case OPT_LINK:     options.link = optarg; break;
+            case OPT_RATE:     options.rate = std::atof(optarg); break;
+            case OPT_BUS:      options.busKbps = std::atoi(optarg); break;
+            case OPT_BURST:    options.burst = std::max(1, std::atoi(optarg)); break;
+            case OPT_FRAGMENT:
+                if (std::sscanf(optarg, "%d:%d", &options.fragmentMin, &options.fragmentMax) != 2 ||
+                    options.fragmentMin < 1 || options.fragmentMax < options.fragmentMin) {
+                    std::fprintf(stderr, "Неверный формат --fragment, ожидается MIN:MAX\n");
+                    return false;
+                }
+                break;
+            case OPT_IDS:      options.idCount = std::max(1, std::atoi(optarg)); break;
+            case OPT_FIRST_ID: options.firstId = static_cast<uint32_t>(std::strtoul(optarg, nullptr, 16)); break;
+            case OPT_EXTENDED: options.extended = true; break;
+            case OPT_DLC:      options.dlc = std::min(8, std::max(0, std::atoi(optarg))); break;
+            case OPT_GARBAGE:  options.garbage = std::atof(optarg); break;
+            case OPT_DURATION: options.duration = std::atof(optarg); break;
+            case OPT_COUNT:    options.count = std::strtoull(optarg, nullptr, 10); break;
+            case OPT_NO_WAIT:  options.waitInit = false; break;
+            case OPT_ECHO:     options.echo = true; break;
+            case OPT_SEED:     options.seed = static_cast<uint32_t>(std::strtoul(optarg, nullptr, 10)); break;
+            default:
+                usage(argv[0]);
+                return false;
+        }
+    }
+    
+    if (options.busKbps > 0) {
+        options.rate = options.busKbps * 1000.0 / bitsPerFrame(options.extended, options.dlc);
+    }
+    return true;
+}
+
+void appendFrame(std::vector<uint8_t> &out, uint32_t id, const uint8_t *data, int dlc)
+{
+    out.push_back(FRAME_START);
+    out.push_back(TYPE_CAN_DATA);
+    out.push_back(static_cast<uint8_t>(dlc));
+    out.push_back(static_cast<uint8_t>(id >> 24));
+    out.push_back(static_cast<uint8_t>(id >> 16));
+    out.push_back(static_cast<uint8_t>(id >> 8));
+    out.push_back(static_cast<uint8_t>(id));
+    out.insert(out.end(), data, data + dlc);
+    out.push_back(FRAME_END);
+}
+
+// Разбор байт от приложения: команда инициализации и кадры передачи
+class InputParser
+{
+public:
+    int initSpeedCode = -1;   // Код скорости последней команды инициализации
+    uint64_t initCommands = 0;
+    uint64_t txFrames = 0;
+    
+    template<typename FrameHandler>
+    void feed(const uint8_t *data, size_t size, FrameHandler onFrame)
+    {
+        m_buffer.insert(m_buffer.end(), data, data + size);
+        size_t pos = 0;
+        while (true) {
+            while (pos < m_buffer.size() && m_buffer[pos] != FRAME_START) {
+                ++pos;
+            }
+            if (m_buffer.size() - pos < 5) {
+                break;
+            }
+            
+            const uint8_t type = m_buffer[pos + 1];
+            if (type == CMD_INIT) {
+                if (m_buffer[pos + 4] == FRAME_END) {
+                    initSpeedCode = m_buffer[pos + 2];
+                    ++initCommands;
+                    pos += 5;
+                } else {
+                    ++pos;
+                }
+                continue;
+            }
+            
+            if (type == TYPE_CAN_DATA) {
+                const int dlc = m_buffer[pos + 2];
+                const size_t frameSize = HEADER_SIZE + dlc + 1;
+                if (dlc > 8) {
+                    ++pos;
+                    continue;
+                }
+                if (m_buffer.size() - pos < frameSize) {
+                    break;
+                }
+                if (m_buffer[pos + frameSize - 1] != FRAME_END) {
+                    ++pos;
+                    continue;
+                }
+                const uint32_t id = (static_cast<uint32_t>(m_buffer[pos + 3]) << 24) |
+                                    (static_cast<uint32_t>(m_buffer[pos + 4]) << 16) |
+                                    (static_cast<uint32_t>(m_buffer[pos + 5]) << 8) |
+                                    static_cast<uint32_t>(m_buffer[pos + 6]);
+                ++txFrames;
+                onFrame(id, &m_buffer[pos + HEADER_SIZE], dlc);
+                pos += frameSize;
+                continue;
+            }
+            ++pos;
+        }
+        m_buffer.erase(m_buffer.begin(), m_buffer.begin() + static_cast<std::ptrdiff_t>(pos));
+    }
+
+private:
+    std::vector<uint8_t> m_buffer;
+};
+
+const char *speedName(int code)
+{
+    switch (code) {
+        case 0: return "125 кбит/с";
+        case 1: return "250 кбит/с";
+        case 2: return "500 кбит/с";
+        case 3: return "1000 кбит/с";
+        default: return "неизвестна";
+    }
+}
+
+// Запись буфера с учетом частичных записей. Если приложение не читает порт
+// дольше WRITE_STALL_MS, запись прекращается (как переполнение у адаптера).
+// Возвращает число записанных байт или -1 при ошибке.
+constexpr int WRITE_STALL_MS = 100;
+
+ssize_t writeAll(int fd, const uint8_t *data, size_t size)
+{
+    size_t total = 0;
+    while (total < size && !g_stop) {
+        const ssize_t written = ::write(fd, data + total, size - total);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN) {
+                pollfd pfd = {fd, POLLOUT, 0};
+                if (poll(&pfd, 1, WRITE_STALL_MS) <= 0) {
+                    break;
+                }
+                continue;
+            }
+            return -1;
+        }
+        total += static_cast<size_t>(written);
+    }
+    return static_cast<ssize_t>(total);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+    
+    signal(SIGINT, [](int) { g_stop = 1; });
+    signal(SIGTERM, [](int) { g_stop = 1; });
+    signal(SIGPIPE, SIG_IGN);
+    
+    const int master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        std::perror("Не удалось создать псевдотерминал");
+        return 1;
+    }
+    const char *slaveName = ptsname(master);
+    
+    // Открытый конец slave не дает master получать EIO, пока приложение не подключено
+    const int slave = ::open(slaveName, O_RDWR | O_NOCTTY);
+    if (slave >= 0) {
+        termios tio;
+        if (tcgetattr(slave, &tio) == 0) {
+            cfmakeraw(&tio);
+            tcsetattr(slave, TCSANOW, &tio);
+        }
+    }
+    
+    unlink(options.link.c_str());
+    if (symlink(slaveName, options.link.c_str()) != 0) {
+        std::fprintf(stderr, "Не удалось создать ссылку %s: %s\n", options.link.c_str(), std::strerror(errno));
+    }
+    
+    std::fprintf(stderr, "Симулятор Scanmatic: порт %s -> %s\n", options.link.c_str(), slaveName);
+    std::fprintf(stderr, "Частота: %s, пачка %d, дробление %d:%d, ID %d шт. с 0x%X, DLC %d\n",
+                 options.rate > 0 ? std::to_string(static_cast<long long>(options.rate)).c_str() : "без ограничения",
+                 options.burst, options.fragmentMin, options.fragmentMax,
+                 options.idCount, options.firstId, options.dlc);
+    
+    std::mt19937 random(options.seed);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    std::uniform_int_distribution<int> fragmentSize(std::max(1, options.fragmentMin),
+                                                    std::max(1, options.fragmentMax));
+    std::uniform_int_distribution<int> noiseSize(1, 16);
+    
+    InputParser input;
+    std::vector<uint8_t> out;
+    std::vector<uint8_t> echo;
+    uint8_t readBuffer[4096];
+    
+    bool streaming = !options.waitInit;
+    uint64_t sequence = 0;
+    uint64_t sentFrames = 0;
+    uint64_t sentBytes = 0;
+    uint64_t droppedBursts = 0;
+    const uint64_t startNs = nowNs();
+    uint64_t nextSendNs = startNs;
+    uint64_t reportNs = startNs + 1000000000ULL;
+    uint64_t reportFrames = 0;
+    uint64_t reportBytes = 0;
+    const uint64_t burstIntervalNs = options.rate > 0
+        ? static_cast<uint64_t>(1e9 * options.burst / options.rate) : 0;
+    const uint64_t endNs = options.duration > 0 ? startNs + static_cast<uint64_t>(options.duration * 1e9) : 0;
+    
+    if (!streaming) {
+        std::fprintf(stderr, "Ожидание команды инициализации (0xAA 0x01 ...)\n");
+    }
+    
+    while (!g_stop) {
+        const uint64_t now = nowNs();
+        if (endNs != 0 && now >= endNs) {
+            break;
+        }
+        if (options.count != 0 && sentFrames >= options.count) {
+            break;
+        }
+        
+        // Чтение команд и кадров передачи от приложения
+        int timeoutMs = 0;
+        if (!streaming) {
+            timeoutMs = 100;
+        } else if (burstIntervalNs > 0 && nextSendNs > now) {
+            timeoutMs = static_cast<int>(std::min<uint64_t>((nextSendNs - now) / 1000000, 100));
+        }
+        pollfd pfd = {master, POLLIN, 0};
+        if (poll(&pfd, 1, timeoutMs) > 0 && (pfd.revents & POLLIN)) {
+            const ssize_t received = ::read(master, readBuffer, sizeof(readBuffer));
+            if (received > 0) {
+                const uint64_t initsBefore = input.initCommands;
+                echo.clear();
+                input.feed(readBuffer, static_cast<size_t>(received), [&](uint32_t id, const uint8_t *data, int dlc) {
+                    if (options.echo) {
+                        appendFrame(echo, id, data, dlc);
+                    }
+                });
+                if (input.initCommands != initsBefore) {
+                    std::fprintf(stderr, "Команда инициализации, скорость CAN %s\n", speedName(input.initSpeedCode));
+                    // Подтверждение - повтор команды. Приложение очищает прием после
+                    // инициализации, поэтому поток кадров начинается с задержкой.
+                    const uint8_t ack[] = {FRAME_START, CMD_INIT, static_cast<uint8_t>(input.initSpeedCode), 0x00, FRAME_END};
+                    writeAll(master, ack, sizeof(ack));
+                    streaming = true;
+                    nextSendNs = nowNs() + 300000000ULL;
+                }
+                if (!echo.empty()) {
+                    writeAll(master, echo.data(), echo.size());
+                }
+            }
+        }
+        
+        if (!streaming) {
+            continue;
+        }
+        
+        if (burstIntervalNs > 0) {
+            if (nowNs() < nextSendNs) {
+                if (nextSendNs - nowNs() < 1000000ULL) {
+                    sleepUntil(nextSendNs);
+                } else {
+                    continue;
+                }
+            }
+            nextSendNs += burstIntervalNs;
+        }
+        
+        // Пачка кадров, при необходимости с мусором между ними
+        out.clear();
+        for (int i = 0; i < options.burst; ++i) {
+            uint32_t id = options.firstId + static_cast<uint32_t>(sequence % static_cast<uint64_t>(options.idCount));
+            id &= options.extended ? 0x1FFFFFFFu : 0x7FFu;
+            if (options.extended && id <= 0x7FF) {
+                id |= 0x800;
+            }
+            uint8_t data[8];
+            for (int b = 0; b < 8; ++b) {
+                data[b] = static_cast<uint8_t>(sequence >> (8 * (b % 4)));
+            }
+            appendFrame(out, id, data, options.dlc);
+            ++sequence;
+            
+            if (options.garbage > 0 && chance(random) < options.garbage) {
+                const int noise = noiseSize(random);
+                for (int n = 0; n < noise; ++n) {
+                    out.push_back(static_cast<uint8_t>(random() & 0xFF));
+                }
+            }
+        }
+        
+        // Дробление записи на куски случайного размера
+        size_t offset = 0;
+        bool stalled = false;
+        while (offset < out.size()) {
+            size_t chunk = out.size() - offset;
+            if (options.fragmentMax > 0) {
+                chunk = std::min(chunk, static_cast<size_t>(fragmentSize(random)));
+            }
+            const ssize_t written = writeAll(master, out.data() + offset, chunk);
+            if (written < 0) {
+                std::perror("Ошибка записи в порт");
+                g_stop = 1;
+                break;
+            }
+            offset += static_cast<size_t>(written);
+            if (static_cast<size_t>(written) < chunk) {
+                stalled = true;
+                break;
+            }
+        }
+        sentBytes += offset;
+        if (stalled) {
+            // Остаток пачки отброшен; в порту мог остаться неполный кадр
+            if (droppedBursts++ == 0) {
+                std::fprintf(stderr, "Приложение не читает порт, кадры отбрасываются\n");
+            }
+            continue;
+        }
+        sentFrames += static_cast<uint64_t>(options.burst);
+        
+        const uint64_t reportNow = nowNs();
+        if (reportNow >= reportNs) {
+            const double seconds = (reportNow - reportNs + 1000000000ULL) / 1e9;
+            std::fprintf(stderr, "Отправлено: %llu кадров/с, %.2f МБ/с, всего %llu кадров, принято от приложения %llu\n",
+                         static_cast<unsigned long long>((sentFrames - reportFrames) / seconds),
+                         (sentBytes - reportBytes) / seconds / 1e6,
+                         static_cast<unsigned long long>(sentFrames),
+                         static_cast<unsigned long long>(input.txFrames));
+            reportFrames = sentFrames;
+            reportBytes = sentBytes;
+            reportNs = reportNow + 1000000000ULL;
+        }
+    }
+    
+    const double seconds = (nowNs() - startNs) / 1e9;
+    std::fprintf(stderr, "Итого: %llu кадров, %llu байт за %.1f с, отброшено пачек %llu, принято от приложения %llu кадров\n",
+                 static_cast<unsigned long long>(sentFrames), static_cast<unsigned long long>(sentBytes),
+                 seconds, static_cast<unsigned long long>(droppedBursts),
+                 static_cast<unsigned long long>(input.txFrames));
+    
+    unlink(options.link.c_str());
+    if (slave >= 0) {
+        ::close(slave);
+    }
+    ::close(master);
+    return 0;
+}
@@ -0,0 +1,69 @@
+// Преобразование трасс между форматами: запись CANReader (.canrec),
+// candump (.log), Vector ASC (.asc) и Vector BLF (.blf). Исходный формат
+// определяется по содержимому, целевой - по расширению. Файл читается и
+// пишется потоком, размер трассы не ограничен памятью.
+//
+// Пример:
+//   trace_convert capture_20240101_120000_000.canrec trace.blf
+//   trace_convert vehicle.asc vehicle.log
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <cstdio>
+#include "tracefile.h"
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Преобразование трасс CAN: .canrec, candump .log, Vector .asc, Vector .blf");
+    parser.addHelpOption();
+    parser.addPositionalArgument("source", "Исходный файл");
+    parser.addPositionalArgument("target", "Целевой файл, формат по расширению");
+    parser.addOptions({
+        {"quiet", "Без индикации хода"},
+    });
+    parser.process(app);
+    
+    const QStringList files = parser.positionalArguments();
+    if (files.size() != 2) {
+        parser.showHelp(1);
+    }
+    
+    const bool quiet = parser.isSet("quiet");
+    int lastPercent = -1;
+    QElapsedTimer timer;
+    timer.start();
+    
+    TraceConversionStats stats;
+    QString error;
+    const bool ok = convertTrace(files[0], files[1], &stats, &error, [&](qint64 position, qint64 size) {
+        const int percent = size > 0 ? static_cast<int>(position * 100 / size) : 0;
+        if (!quiet && percent != lastPercent) {
+            lastPercent = percent;
+            std::fprintf(stderr, "\r%3d%%", percent);
+        }
+        return true;
+    });
+    if (!quiet) {
+        std::fprintf(stderr, "\n");
+    }
+    
+    if (!ok) {
+        std::fprintf(stderr, "Ошибка: %s\n", qPrintable(error));
+        return 1;
+    }
+    
+    const double seconds = qMax<qint64>(1, timer.elapsed()) / 1000.0;
+    std::printf("%s -> %s: %llu кадров за %.2f с (%.0f кадров/с)\n",
+                qPrintable(traceFormatName(detectTraceFormat(files[0]))),
+                qPrintable(traceFormatName(traceFormatForFileName(files[1]))),
+                static_cast<unsigned long long>(stats.frames), seconds, stats.frames / seconds);
+    if (stats.skippedRecords > 0) {
+        std::printf("Пропущено записей (CAN FD, поврежденные): %llu\n",
+                    static_cast<unsigned long long>(stats.skippedRecords));
+    }
+    return 0;
+}
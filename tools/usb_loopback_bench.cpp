@@ -0,0 +1,255 @@
+// Нагрузочная проверка пути приема USB без адаптера.
+//
+// CANInterface подключается через connectUSB() к UsbLoopbackBackend:
+// выполняется обычная последовательность инициализации, затем backend
+// выдает кадры пакетами bulk IN заданного размера и периода. В данные
+// кадров заложено время генерации, по нему считаются задержки до разбора
+// (метка кадра) и до потребителя. С --tx-rate кадры передачи проходят
+// через очередь передачи, эхо backend'а дает время полного оборота.
+//
+// Пример:
+//   usb_loopback_bench --rate 200000 --packet 64:512 --interval-us 125 --duration 60
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "caninterface.h"
+#include "frameconsumer.h"
+#include "usbloopbackbackend.h"
+
+namespace {
+
+constexpr quint32 TX_ID = 0x7DF;        // ID кадров передачи, отличается от генерируемых
+constexpr int HISTOGRAM_US = 100000;    // Гистограмма задержек с шагом 1 мкс, дальше - переполнение
+constexpr int TX_TICK_MS = 1;
+
+// Гистограмма задержек в микросекундах
+class LatencyHistogram
+{
+public:
+    LatencyHistogram() : m_bins(HISTOGRAM_US + 1, 0), m_count(0), m_maxNs(0) {}
+    
+    void add(quint64 latencyNs)
+    {
+        const quint64 us = latencyNs / 1000;
+        m_bins[us < HISTOGRAM_US ? us : HISTOGRAM_US]++;
+        m_count++;
+        m_maxNs = qMax(m_maxNs, latencyNs);
+    }
+    
+    double percentileUs(double p) const
+    {
+        const quint64 rank = static_cast<quint64>(p * m_count);
+        quint64 seen = 0;
+        for (int us = 0; us <= HISTOGRAM_US; ++us) {
+            seen += m_bins[us];
+            if (seen > rank) {
+                return us;
+            }
+        }
+        return HISTOGRAM_US;
+    }
+    
+    void print(const char *title) const
+    {
+        if (m_count == 0) {
+            std::fprintf(stderr, "%s: нет данных\n", title);
+            return;
+        }
+        std::fprintf(stderr, "%s, мкс: p50 %.0f, p90 %.0f, p99 %.0f, p99.9 %.0f, max %.1f (%llu кадров)\n",
+                     title, percentileUs(0.5), percentileUs(0.9), percentileUs(0.99),
+                     percentileUs(0.999), m_maxNs / 1000.0, static_cast<unsigned long long>(m_count));
+    }
+
+private:
+    std::vector<quint64> m_bins;
+    quint64 m_count;
+    quint64 m_maxNs;
+};
+
+quint64 embeddedNs(const CanFrame &frame)
+{
+    quint64 ns = 0;
+    std::memcpy(&ns, frame.data, sizeof(ns));
+    return ns;
+}
+
+bool parseRange(const QString &text, int &minValue, int &maxValue)
+{
+    const QStringList parts = text.split(':');
+    bool ok = true;
+    minValue = parts.value(0).toInt(&ok);
+    if (!ok) {
+        return false;
+    }
+    maxValue = parts.size() > 1 ? parts.value(1).toInt(&ok) : minValue;
+    return ok && parts.size() <= 2 && minValue > 0 && maxValue >= minValue;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Нагрузочная проверка приема USB через UsbLoopbackBackend");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"rate", "Кадров в секунду, 0 - без ограничения", "N", "10000"},
+        {"packet", "Размер пакета bulk IN или диапазон MIN:MAX", "BYTES", "64"},
+        {"interval-us", "Период выдачи пакетов", "US", "1000"},
+        {"transfers", "Число одновременных запросов приема", "N", "8"},
+        {"transfer-size", "Размер буфера запроса", "BYTES", "4096"},
+        {"tx-rate", "Кадров передачи в секунду (эхо, время оборота)", "N", "0"},
+        {"write-latency-us", "Задержка записи bulk OUT", "US", "0"},
+        {"duration", "Длительность, с", "S", "10"},
+        {"no-acquisition-thread", "Сбор в основном потоке"},
+    });
+    parser.process(app);
+    
+    UsbLoopbackBackend::Config config;
+    config.frameRate = parser.value("rate").toInt();
+    config.packetIntervalUs = parser.value("interval-us").toInt();
+    config.writeLatencyUs = parser.value("write-latency-us").toInt();
+    if (!parseRange(parser.value("packet"), config.packetSize, config.packetSizeMax)) {
+        std::fprintf(stderr, "Неверный формат --packet, ожидается BYTES или MIN:MAX\n");
+        return 1;
+    }
+    const int txRate = parser.value("tx-rate").toInt();
+    const int durationMs = qMax(1, static_cast<int>(parser.value("duration").toDouble() * 1000));
+    
+    CANInterface can;
+    can.setAcquisitionThreadEnabled(!parser.isSet("no-acquisition-thread"));
+    can.setUSBReceiveBuffers(parser.value("transfers").toInt(), parser.value("transfer-size").toInt());
+    
+    auto ownedBackend = std::make_unique<UsbLoopbackBackend>(config);
+    UsbLoopbackBackend *backend = ownedBackend.get();
+    can.setUSBBackend(std::move(ownedBackend));
+    
+    LatencyHistogram toParser;
+    LatencyHistogram toConsumer;
+    LatencyHistogram roundTrip;
+    quint64 consumed = 0;
+    quint64 lastConsumed = 0;
+    
+    FrameConsumer *consumer = can.createConsumer("bench", 1 << 20);
+    QVector<CanFrame> frames;
+    QObject::connect(consumer, &FrameConsumer::framesAvailable, &app, [&]() {
+        for (;;) {
+            frames.clear();
+            if (consumer->drain(frames, 4096) == 0) {
+                break;
+            }
+            const quint64 nowNs = CanClock::nowNs();
+            for (const CanFrame &frame : frames) {
+                if (frame.dlc != 8 || frame.isTx()) {
+                    continue;
+                }
+                const quint64 generatedNs = embeddedNs(frame);
+                if (frame.id == TX_ID) {
+                    roundTrip.add(nowNs - generatedNs);
+                } else {
+                    toParser.add(frame.timestampNs - generatedNs);
+                    toConsumer.add(nowNs - generatedNs);
+                }
+            }
+            consumed += frames.size();
+        }
+    });
+    
+    QObject::connect(&can, &CANInterface::errorOccurred, &app, [](const QString &error) {
+        std::fprintf(stderr, "Ошибка: %s\n", qPrintable(error));
+    });
+    
+    QElapsedTimer connectTimer;
+    connectTimer.start();
+    if (!can.connectUSB()) {
+        std::fprintf(stderr, "connectUSB() не выполнен\n");
+        return 1;
+    }
+    std::fprintf(stderr, "connectUSB(): %lld мс, инициализация %s\n",
+                 static_cast<long long>(connectTimer.elapsed()),
+                 backend->statistics().initReceived ? "получена" : "не получена");
+    
+    // Передача: кадры с временем постановки в очередь, эхо возвращается в прием
+    QTimer txTimer;
+    QElapsedTimer txClock;
+    quint64 txScheduled = 0;
+    quint64 txRejected = 0;
+    if (txRate > 0) {
+        txTimer.setTimerType(Qt::PreciseTimer);
+        QObject::connect(&txTimer, &QTimer::timeout, &app, [&]() {
+            const quint64 target = static_cast<quint64>(txClock.nsecsElapsed() / 1000) * txRate / 1000000;
+            QVector<CanFrame> batch;
+            const quint64 nowNs = CanClock::nowNs();
+            for (; txScheduled < target; ++txScheduled) {
+                CanFrame frame = {};
+                frame.id = TX_ID;
+                frame.dlc = 8;
+                std::memcpy(frame.data, &nowNs, sizeof(nowNs));
+                batch.append(frame);
+            }
+            const int accepted = can.sendFrames(batch.constData(), batch.size());
+            txRejected += batch.size() - accepted;
+        });
+        txClock.start();
+        txTimer.start(TX_TICK_MS);
+    }
+    
+    QElapsedTimer runClock;
+    runClock.start();
+    QTimer progressTimer;
+    QObject::connect(&progressTimer, &QTimer::timeout, &app, [&]() {
+        const UsbLoopbackBackend::Statistics stats = backend->statistics();
+        std::fprintf(stderr, "Принято: %llu кадров/с, выдано пакетов %llu, переполнений очереди %llu\n",
+                     static_cast<unsigned long long>(consumed - lastConsumed),
+                     static_cast<unsigned long long>(stats.packets),
+                     static_cast<unsigned long long>(consumer->overflowCount()));
+        lastConsumed = consumed;
+    });
+    progressTimer.start(1000);
+    
+    QTimer::singleShot(durationMs, &app, [&]() {
+        txTimer.stop();
+        progressTimer.stop();
+        const double seconds = runClock.elapsed() / 1000.0;
+        can.disconnect();
+        
+        const UsbLoopbackBackend::Statistics stats = backend->statistics();
+        const Statistics canStats = can.getStatistics();
+        std::fprintf(stderr, "\nИтого за %.1f с:\n", seconds);
+        std::fprintf(stderr, "  сгенерировано %llu кадров, %llu пакетов, %.2f МБ/с\n",
+                     static_cast<unsigned long long>(stats.framesGenerated),
+                     static_cast<unsigned long long>(stats.packets),
+                     stats.bytesIn / seconds / 1e6);
+        std::fprintf(stderr, "  принято CANInterface %llu, потребителем %llu (%.0f кадров/с), ошибок %llu, переполнений %llu\n",
+                     static_cast<unsigned long long>(canStats.messagesReceived),
+                     static_cast<unsigned long long>(consumed), consumed / seconds,
+                     static_cast<unsigned long long>(canStats.errorsCount),
+                     static_cast<unsigned long long>(consumer->overflowCount()));
+        if (txRate > 0) {
+            const TransmitStatistics txStats = can.getTransmitStatistics();
+            std::fprintf(stderr, "  передано %llu, эхо %llu, отклонено очередью %llu, записей bulk OUT %llu\n",
+                         static_cast<unsigned long long>(canStats.messagesSent),
+                         static_cast<unsigned long long>(stats.framesEchoed),
+                         static_cast<unsigned long long>(txRejected),
+                         static_cast<unsigned long long>(stats.writes));
+            const int bulk = static_cast<int>(TransmitPriority::Bulk);
+            std::fprintf(stderr, "  ожидание в очереди передачи: среднее %llu мкс, max %llu мкс\n",
+                         static_cast<unsigned long long>(txStats.averageWaitUs[bulk]),
+                         static_cast<unsigned long long>(txStats.maxWaitUs[bulk]));
+        }
+        toParser.print("Генерация -> разбор");
+        toConsumer.print("Генерация -> потребитель");
+        roundTrip.print("Передача -> эхо у потребителя");
+        app.quit();
+    });
+    
+    return app.exec();
+}